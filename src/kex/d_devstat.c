@@ -37,14 +37,18 @@
 #include "d_englsh.h"
 #include "r_drawlist.h"
 #include "i_video.h"
+#include "r_geom.h"
 
 static dboolean showstats = true;
 
 extern word statindice;
+extern int sightcounts[4];
 
 CVAR_EXTERNAL(v_mlook);
 CVAR_EXTERNAL(v_mlookinvert);
 CVAR_EXTERNAL(sv_lockmonsters);
+CVAR_EXTERNAL(r_batchdrawlists);
+CVAR_EXTERNAL(r_geometrycache);
 
 //
 // ST_DrawFPS
@@ -92,6 +96,13 @@ void D_DeveloperDisplay(void) {
         glBindCalls = 0;
         vertCount = 0;
         statindice = 0;
+        dlEntryCount = 0;
+        dlDrawCount = 0;
+        geomHits = 0;
+        geomMisses = 0;
+        textHits = 0;
+        textMisses = 0;
+        dmemset(sightcounts, 0, sizeof(sightcounts));
 
         return;
     }
@@ -177,6 +188,28 @@ void D_DeveloperDisplay(void) {
     Draw_Text(0, y, WHITE, 0.35f, false, "Draw Indices: %i", statindice);
     y+=16;
 
+    sevclr = dlDrawCount >= 100 ? YELLOW : WHITE;
+    Draw_Text(0, y, sevclr, 0.35f, false, "Draw List Draws: %i (%i entries, batching %s)",
+              dlDrawCount, dlEntryCount, r_batchdrawlists.value > 0 ? "on" : "off");
+    y+=16;
+
+    Draw_Text(0, y, WHITE, 0.35f, false, "Sight Checks: %i rejected, %i pvs culled, %i traced",
+              sightcounts[0], sightcounts[2], sightcounts[1]);
+    y+=16;
+
+    Draw_Text(0, y, WHITE, 0.35f, false, "Geometry Cache: %i hits, %i rebuilt (%s)",
+              geomHits, geomMisses, r_geometrycache.value > 0 ? "on" : "off");
+    y+=16;
+
+    Draw_Text(0, y, WHITE, 0.35f, false, "Text Cache: %i hits, %i laid out",
+              textHits, textMisses);
+    y+=16;
+
+    if(gameflags & GF_DORMANTMONSTERS) {
+        Draw_Text(0, y, WHITE, 0.35f, false, "Dormant Mobjs: %i per tic", dormantmobjs);
+        y+=16;
+    }
+
     if(gamestate == GS_LEVEL && !automapactive) {
         Draw_Text(0, y, WHITE, 0.35f, false, "PlayerView Render Time: %ims", renderTic);
         y+=16;
@@ -198,6 +231,13 @@ void D_DeveloperDisplay(void) {
     glBindCalls = 0;
     vertCount = 0;
     statindice = 0;
+    dlEntryCount = 0;
+    dlDrawCount = 0;
+    geomHits = 0;
+    geomMisses = 0;
+    textHits = 0;
+    textMisses = 0;
+    dmemset(sightcounts, 0, sizeof(sightcounts));
 }
 
 //
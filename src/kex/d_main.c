@@ -62,8 +62,10 @@
 #include "r_wipe.h"
 #include "g_controls.h"
 #include "g_demo.h"
+#include "g_bench.h"
 #include "p_saveg.h"
 #include "gl_draw.h"
+#include "d_prof.h"
 
 #include "Ext/ChocolateDoom/net_client.h"
 
@@ -90,6 +92,8 @@ dboolean        setWindow       = true;
 int             validcount      = 1;
 dboolean        windowpause     = false;
 dboolean        devparm         = false;    // started game with -devparm
+dboolean        nodrawers       = false;    // started game with -nodraw
+dboolean        singletics      = false;    // debug flag to cancel adaptiveness
 dboolean        nomonsters      = false;    // checkparm of -nomonsters
 dboolean        respawnparm     = false;    // checkparm of -respawn
 dboolean        respawnitem     = false;    // checkparm of -respawnitem
@@ -184,10 +188,6 @@ void D_IncValidCount(void) {
     validcount++;
 }
 
-//
-// D_MiniLoop
-//
-
 CVAR_EXTERNAL(i_interpolateframes);
 
 extern dboolean renderinframe;
@@ -207,12 +207,17 @@ static void D_DrawInterface(void) {
         M_Drawer();
     }
 
+    // everything from here on is text drawn over the
+    // console background, so it can all go out together
+    Draw_BeginText();
+
     CON_Draw();
 
     if(devparm) {
         D_DeveloperDisplay();
     }
 
+    D_ProfDrawer();
 
     BusyDisk = false;
 
@@ -220,11 +225,15 @@ static void D_DrawInterface(void) {
     if(paused) {
         Draw_BigText(-1, 64, WHITE, STRPAUSED);
     }
+
+    Draw_EndText();
 }
 
 static void D_FinishDraw(void) {
     // send out any new accumulation
-    NetUpdate();
+    if(!singletics) {
+        NetUpdate();
+    }
 
     // normal update
     I_FinishUpdate();
@@ -232,8 +241,68 @@ static void D_FinishDraw(void) {
     if(i_interpolateframes.value) {
         I_EndDisplay();
     }
+
+    D_ProfFrame();
+}
+
+//
+// D_RunSingleTic
+// Runs exactly one tic and one frame without waiting on
+// the clock. Used by -timedemo to benchmark the engine
+//
+
+static int D_RunSingleTic(void (*draw)(void), dboolean(*tick)(void)) {
+    int action = ga_nothing;
+    uint64 starttic;
+
+    starttic = I_GetTimeUS();
+
+    if(!nodrawers) {
+        I_StartTic();
+    }
+
+    D_ProcessEvents();
+    M_Ticker();
+
+    G_BuildTiccmd(&netcmds[consoleplayer][maketic % BACKUPTICS]);
+    nettics[consoleplayer] = ++maketic;
+
+    G_Ticker();
+
+    if(tick) {
+        action = tick();
+    }
+
+    if(gameaction != ga_nothing) {
+        action = gameaction;
+    }
+
+    gametic++;
+
+    if(!nodrawers) {
+        S_UpdateSounds();
+
+        if(draw && !action) {
+            draw();
+        }
+        D_DrawInterface();
+        D_FinishDraw();
+    }
+
+    if(timingdemo && demoplayback) {
+        G_TimeDemoTic((uint32)(I_GetTimeUS() - starttic));
+    }
+
+    // force garbage collection
+    Z_FreeAlloca();
+
+    return action;
 }
 
+//
+// D_MiniLoop
+//
+
 int D_MiniLoop(void (*start)(void), void (*stop)(void),
                void (*draw)(void), dboolean(*tick)(void)) {
     int action = gameaction = ga_nothing;
@@ -242,6 +311,10 @@ int D_MiniLoop(void (*start)(void), void (*stop)(void),
         start();
     }
 
+    while(!action && singletics) {
+        action = D_RunSingleTic(draw, tick);
+    }
+
     while(!action) {
         int i = 0;
         int lowtic = 0;
@@ -942,6 +1015,8 @@ static void D_Init(void) {
 static int D_CheckDemo(void) {
     int p;
 
+    G_DemoHashInit();
+
     // start the apropriate game based on parms
     p = M_CheckParm("-record");
 
@@ -957,6 +1032,24 @@ static int D_CheckDemo(void) {
         return 1;
     }
 
+    p = M_CheckParm("-timedemo");
+    if(p && p < myargc-1) {
+        G_TimeDemo(myargv[p+1]);
+        return 1;
+    }
+
+    p = M_CheckParm("-simbench");
+    if(p && p < myargc-1) {
+        G_SimBenchmark(datoi(myargv[p+1]));
+        return 1;
+    }
+
+    p = M_CheckParm("-glreplay");
+    if(p && p < myargc-1) {
+        DGL_Replay(myargv[p+1]);
+        return 1;
+    }
+
     return 0;
 }
 
@@ -967,6 +1060,14 @@ static int D_CheckDemo(void) {
 void D_DoomMain(void) {
     devparm = M_CheckParm("-devparm");
 
+    // -nodraw is only meaningful for -timedemo and -simbench;
+    // the window and GL context are never created
+    nodrawers = (M_CheckParm("-timedemo") || M_CheckParm("-simbench")) && M_CheckParm("-nodraw");
+
+    // everything is still drawn, but into dgl_rec.c's
+    // command stream instead of an OpenGL context
+    dglrecording = !nodrawers && (M_CheckParm("-nullgl") || M_CheckParm("-glrecord"));
+
     // init subsystems
 
     I_Printf("Z_Init: Init Zone Memory Allocator\n");
@@ -1011,8 +1112,10 @@ void D_DoomMain(void) {
     I_Printf("ST_Init: Init status bar.\n");
     ST_Init();
 
-    I_Printf("GL_Init: Init OpenGL\n");
-    GL_Init();
+    if(!nodrawers) {
+        I_Printf("GL_Init: Init OpenGL\n");
+        GL_Init();
+    }
 
 #ifdef USESYSCONSOLE
     I_ShowSysConsole(false);
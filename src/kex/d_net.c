@@ -38,6 +38,7 @@
 #include "con_console.h"
 #include "SDL.h"
 #include "i_video.h"
+#include "d_prof.h"
 
 #define FEATURE_MULTIPLAYER 1
 
@@ -115,6 +116,8 @@ void NetUpdate(void) {
         return;
     }
 
+    PROF_BEGIN(PROF_NETUPDATE);
+
 #ifdef FEATURE_MULTIPLAYER
 
     // Run network subsystems
@@ -187,6 +190,8 @@ void NetUpdate(void) {
         ++maketic;
         nettics[consoleplayer] = maketic;
     }
+
+    PROF_END(PROF_NETUPDATE);
 }
 
 //
@@ -0,0 +1,360 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2013 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Scoped stage timers. Shows a rolling per-frame breakdown
+//              on screen and can write frames out as a Chrome trace
+//              (chrome://tracing or ui.perfetto.dev).
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+
+#include "doomdef.h"
+#include "d_prof.h"
+
+#ifdef USE_PROFILER
+
+#include "i_system.h"
+#include "con_console.h"
+#include "g_actions.h"
+#include "gl_draw.h"
+
+#define PROFMAXDEPTH    32
+#define PROFHISTORY     64
+
+typedef struct {
+    int     scope;
+    uint64  start;
+    uint64  end;
+} profevent_t;
+
+dboolean profiling = false;
+
+static const char* profnames[NUMPROFSCOPES+1] = {
+    "G_Ticker",
+    "P_PlayerThink",
+    "P_RunThinkers",
+    "P_ScanSights",
+    "P_RunMobjs",
+    "P_UpdateSpecials",
+    "P_RunMacros",
+    "R_RenderBSPNode",
+    "DL_ProcessDrawList WALL",
+    "DL_ProcessDrawList FLAT",
+    "DL_ProcessDrawList SPRITE",
+    "DL_ProcessDrawList AMAP",
+    "GL_Bind*Texture miss",
+    "I_PNGReadData",
+    "W_ReadLump",
+    "S_UpdateSounds",
+    "NetUpdate",
+    "Frame"
+};
+
+static dboolean     profoverlay = false;
+
+// open scopes
+static int          profstack[PROFMAXDEPTH];
+static uint64       profstart[PROFMAXDEPTH];
+static int          profdepth = 0;
+
+// current frame
+static uint64       frametime[NUMPROFSCOPES];
+static int          framecalls[NUMPROFSCOPES];
+static uint64       framestart = 0;
+
+// last PROFHISTORY frames, for the overlay
+static uint32       histtime[PROFHISTORY][NUMPROFSCOPES];
+static int          histcalls[PROFHISTORY][NUMPROFSCOPES];
+static uint32       histframe[PROFHISTORY];
+static int          histcount = 0;
+static int          histpos = 0;
+
+// trace capture. not using the zone so that
+// the events don't show up in the zone stats
+static profevent_t* traceevents = NULL;
+static int          numtraceevents = 0;
+static int          maxtraceevents = 0;
+static int          tracepending = 0;
+static int          traceframes = 0;
+static uint64       tracebase = 0;
+static char         tracefile[256];
+
+//
+// D_ProfTraceEvent
+//
+
+static void D_ProfTraceEvent(int scope, uint64 start, uint64 end) {
+    profevent_t* ev;
+
+    if(numtraceevents >= maxtraceevents) {
+        maxtraceevents = maxtraceevents ? maxtraceevents * 2 : 4096;
+        traceevents = realloc(traceevents, maxtraceevents * sizeof(profevent_t));
+
+        if(!traceevents) {
+            I_Error("D_ProfTraceEvent: Out of memory");
+        }
+    }
+
+    ev = &traceevents[numtraceevents++];
+    ev->scope = scope;
+    ev->start = start;
+    ev->end = end;
+}
+
+//
+// D_ProfFreeTrace
+//
+
+static void D_ProfFreeTrace(void) {
+    free(traceevents);
+
+    traceevents = NULL;
+    numtraceevents = 0;
+    maxtraceevents = 0;
+}
+
+//
+// D_ProfWriteTrace
+// Writes the captured frames as Chrome trace-event JSON
+//
+
+static void D_ProfWriteTrace(void) {
+    FILE* f;
+    int i;
+    profevent_t* ev;
+
+    if(!(f = fopen(tracefile, "w"))) {
+        CON_Warnf("D_ProfWriteTrace: Couldn't write %s\n", tracefile);
+        D_ProfFreeTrace();
+        return;
+    }
+
+    fprintf(f, "{\"traceEvents\":[\n");
+
+    for(i = 0; i < numtraceevents; i++) {
+        ev = &traceevents[i];
+
+        fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                "\"ts\":%u,\"dur\":%u}", i ? ",\n" : "", profnames[ev->scope],
+                ev->scope == NUMPROFSCOPES ? "frame" : "stage",
+                (uint32)(ev->start - tracebase), (uint32)(ev->end - ev->start));
+    }
+
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(f);
+
+    CON_Printf(WHITE, "Wrote %i events to %s\n", numtraceevents, tracefile);
+    D_ProfFreeTrace();
+}
+
+//
+// D_ProfBegin
+//
+
+void D_ProfBegin(int scope) {
+    if(profdepth < PROFMAXDEPTH) {
+        profstack[profdepth] = scope;
+        profstart[profdepth] = I_GetTimeUS();
+    }
+
+    profdepth++;
+}
+
+//
+// D_ProfEnd
+//
+
+void D_ProfEnd(int scope) {
+    uint64 start;
+    uint64 now;
+
+    if(profdepth <= 0) {
+        return;
+    }
+
+    if(--profdepth >= PROFMAXDEPTH) {
+        return;
+    }
+
+    if(profstack[profdepth] != scope) {
+        I_Error("D_ProfEnd: %s ended inside of %s",
+                profnames[scope], profnames[profstack[profdepth]]);
+    }
+
+    now = I_GetTimeUS();
+    start = profstart[profdepth];
+
+    frametime[scope] += now - start;
+    framecalls[scope]++;
+
+    if(traceframes > 0) {
+        D_ProfTraceEvent(scope, start, now);
+    }
+}
+
+//
+// D_ProfFrame
+// Called once the frame has been sent to the screen. Profiling
+// is only ever switched on or off here, in between frames
+//
+
+void D_ProfFrame(void) {
+    uint64 now;
+    int i;
+
+    now = I_GetTimeUS();
+
+    if(profiling) {
+        for(i = 0; i < NUMPROFSCOPES; i++) {
+            histtime[histpos][i] = (uint32)frametime[i];
+            histcalls[histpos][i] = framecalls[i];
+        }
+
+        histframe[histpos] = (uint32)(now - framestart);
+        histpos = (histpos + 1) % PROFHISTORY;
+
+        if(histcount < PROFHISTORY) {
+            histcount++;
+        }
+
+        if(traceframes > 0) {
+            D_ProfTraceEvent(NUMPROFSCOPES, framestart, now);
+
+            if(--traceframes == 0) {
+                D_ProfWriteTrace();
+            }
+        }
+
+        dmemset(frametime, 0, sizeof(frametime));
+        dmemset(framecalls, 0, sizeof(framecalls));
+    }
+
+    if(tracepending > 0) {
+        D_ProfFreeTrace();
+        traceframes = tracepending;
+        tracepending = 0;
+        tracebase = now;
+    }
+
+    profdepth = 0;
+    framestart = now;
+    profiling = (profoverlay || traceframes > 0);
+}
+
+//
+// D_ProfDrawer
+// Average time per frame spent in each stage over the
+// last PROFHISTORY frames
+//
+
+void D_ProfDrawer(void) {
+    int     i;
+    int     j;
+    int     y = 8;
+    int     calls;
+    double  ms;
+    rcolor  sevclr;
+
+    if(!profoverlay || !histcount) {
+        return;
+    }
+
+    ms = 0;
+    for(j = 0; j < histcount; j++) {
+        ms += histframe[j];
+    }
+
+    ms = ms / histcount / 1000.0;
+
+    Draw_Text(480, y, WHITE, 0.35f, false, "Frame: %.2fms (%i frames)", ms, histcount);
+    y+=16;
+
+    for(i = 0; i < NUMPROFSCOPES; i++) {
+        ms = 0;
+        calls = 0;
+
+        for(j = 0; j < histcount; j++) {
+            ms += histtime[j][i];
+            calls += histcalls[j][i];
+        }
+
+        if(!calls) {
+            continue;
+        }
+
+        ms = ms / histcount / 1000.0;
+        sevclr = ms >= 4.0 ? YELLOW : WHITE;
+
+        Draw_Text(480, y, sevclr, 0.35f, false, "%s: %.2fms (%i)",
+                  profnames[i], ms, (calls + histcount - 1) / histcount);
+        y+=16;
+    }
+}
+
+//
+// CMD_Profile
+//
+
+static CMD(Profile) {
+    if(param[0]) {
+        profoverlay = (datoi(param[0]) != 0);
+    }
+    else {
+        profoverlay ^= 1;
+    }
+
+    histcount = histpos = 0;
+}
+
+//
+// CMD_ProfileTrace
+// Captures the next frames to a trace file
+//
+
+static CMD(ProfileTrace) {
+    int frames = 60;
+
+    if(param[0]) {
+        frames = datoi(param[0]);
+    }
+
+    if(frames <= 0) {
+        frames = 1;
+    }
+
+    dstrncpy(tracefile, (param[0] && param[1]) ? param[1] : "profile.json", sizeof(tracefile) - 1);
+    tracepending = frames;
+
+    CON_Printf(WHITE, "Tracing %i frames to %s\n", frames, tracefile);
+}
+
+//
+// D_ProfRegisterCommands
+//
+
+void D_ProfRegisterCommands(void) {
+    G_AddCommand("profile", CMD_Profile, 0);
+    G_AddCommand("profiletrace", CMD_ProfileTrace, 0);
+}
+
+#endif
@@ -0,0 +1,80 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2013 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __D_PROF_H__
+#define __D_PROF_H__
+
+#include "doomtype.h"
+
+// comment out to compile the profiler and all of its timers out
+#define USE_PROFILER
+
+//
+// profiled stages. the P_Ticker stages are in the same order
+// as tickstat_e and the draw lists in the same order as DLT_*
+//
+typedef enum {
+    PROF_GTICKER,
+    PROF_PLAYERS,
+    PROF_THINKERS,
+    PROF_SIGHTS,
+    PROF_MOBJS,
+    PROF_SPECIALS,
+    PROF_MACROS,
+    PROF_RENDERBSP,
+    PROF_DRAWWALLS,
+    PROF_DRAWFLATS,
+    PROF_DRAWSPRITES,
+    PROF_DRAWAMAP,
+    PROF_TEXTUREMISS,
+    PROF_PNGREAD,
+    PROF_READLUMP,
+    PROF_SOUNDS,
+    PROF_NETUPDATE,
+    NUMPROFSCOPES
+} profscope_e;
+
+#ifdef USE_PROFILER
+
+extern dboolean profiling;
+
+void D_ProfBegin(int scope);
+void D_ProfEnd(int scope);
+void D_ProfFrame(void);
+void D_ProfDrawer(void);
+void D_ProfRegisterCommands(void);
+
+// timers must only be used on the main thread
+#define PROF_BEGIN(s)   do { if(profiling) D_ProfBegin(s); } while(0)
+#define PROF_END(s)     do { if(profiling) D_ProfEnd(s); } while(0)
+
+#else
+
+#define PROF_BEGIN(s)
+#define PROF_END(s)
+#define D_ProfFrame()
+#define D_ProfDrawer()
+#define D_ProfRegisterCommands()
+
+#endif
+
+#endif
@@ -27,6 +27,7 @@
 
 #include "SDL_opengl.h"
 #include "gl_main.h"
+#include "dgl_rec.h"
 #include "i_system.h"
 
 //#define LOG_GLFUNC_CALLS
@@ -4267,5 +4268,155 @@ dboolean has_GL_EXT_texture_filter_anisotropic = false;
 #define GL_EXT_texture_filter_anisotropic_Init() \
 has_GL_EXT_texture_filter_anisotropic = GL_CheckExtension("GL_EXT_texture_filter_anisotropic");
 
+//
+// RECORDING BACKEND
+// While dglrecording is set (-nullgl or -glrecord) the calls made
+// by the game go into dgl_rec.c's command stream instead of to
+// OpenGL, so no GL context is needed. Anything that isn't listed
+// here still goes straight to OpenGL. Not available together with
+// USE_DEBUG_GLFUNCS
+//
+#ifndef USE_DEBUG_GLFUNCS
+
+#define DGL_CALL(gl, rec)   (dglrecording ? (rec) : (gl))
+#define DGL_I(x)            ((int)(x))
+#define DGL_F(x)            ((double)(x))
+
+#undef dglActiveTextureARB
+#undef dglAlphaFunc
+#undef dglBegin
+#undef dglBindTexture
+#undef dglBlendFunc
+#undef dglClear
+#undef dglClearColor
+#undef dglClearDepth
+#undef dglColor4f
+#undef dglColor4ub
+#undef dglColor4ubv
+#undef dglColorPointer
+#undef dglCopyTexSubImage2D
+#undef dglCullFace
+#undef dglDeleteTextures
+#undef dglDepthFunc
+#undef dglDepthMask
+#undef dglDepthRange
+#undef dglDisable
+#undef dglDisableClientState
+#undef dglDrawElements
+#undef dglEnable
+#undef dglEnableClientState
+#undef dglEnd
+#undef dglFlush
+#undef dglFogf
+#undef dglFogfv
+#undef dglFogi
+#undef dglGenTextures
+#undef dglGetBooleanv
+#undef dglGetDoublev
+#undef dglGetFloatv
+#undef dglGetIntegerv
+#undef dglGetString
+#undef dglHint
+#undef dglLoadIdentity
+#undef dglLockArraysEXT
+#undef dglMatrixMode
+#undef dglMultMatrixf
+#undef dglOrtho
+#undef dglPixelStorei
+#undef dglPolygonMode
+#undef dglPopMatrix
+#undef dglPushMatrix
+#undef dglReadPixels
+#undef dglRectf
+#undef dglRecti
+#undef dglRotatef
+#undef dglScissor
+#undef dglShadeModel
+#undef dglTexCoord2f
+#undef dglTexCoordPointer
+#undef dglTexEnvfv
+#undef dglTexEnvi
+#undef dglTexImage2D
+#undef dglTexParameterf
+#undef dglTexParameteri
+#undef dglTexSubImage2D
+#undef dglTranslated
+#undef dglTranslatef
+#undef dglUnlockArraysEXT
+#undef dglVertex2f
+#undef dglVertex2i
+#undef dglVertex3f
+#undef dglVertexPointer
+#undef dglViewport
+
+#define dglActiveTextureARB(texture) DGL_CALL(_glActiveTextureARB(texture), DGL_RecActiveTexture(texture))
+#define dglAlphaFunc(func, ref) DGL_CALL(glAlphaFunc(func, ref), DGL_RecCmd(DGLREC_ALPHAFUNC, "if", DGL_I(func), DGL_F(ref)))
+#define dglBegin(mode) DGL_CALL(glBegin(mode), DGL_RecCmd(DGLREC_BEGIN, "i", DGL_I(mode)))
+#define dglBindTexture(target, texture) DGL_CALL(glBindTexture(target, texture), DGL_RecCmd(DGLREC_BINDTEXTURE, "ii", DGL_I(target), DGL_I(texture)))
+#define dglBlendFunc(sfactor, dfactor) DGL_CALL(glBlendFunc(sfactor, dfactor), DGL_RecCmd(DGLREC_BLENDFUNC, "ii", DGL_I(sfactor), DGL_I(dfactor)))
+#define dglClear(mask) DGL_CALL(glClear(mask), DGL_RecCmd(DGLREC_CLEAR, "i", DGL_I(mask)))
+#define dglClearColor(red, green, blue, alpha) DGL_CALL(glClearColor(red, green, blue, alpha), DGL_RecCmd(DGLREC_CLEARCOLOR, "ffff", DGL_F(red), DGL_F(green), DGL_F(blue), DGL_F(alpha)))
+#define dglClearDepth(depth) DGL_CALL(glClearDepth(depth), DGL_RecCmd(DGLREC_CLEARDEPTH, "f", DGL_F(depth)))
+#define dglColor4f(red, green, blue, alpha) DGL_CALL(glColor4f(red, green, blue, alpha), DGL_RecCmd(DGLREC_COLOR4F, "ffff", DGL_F(red), DGL_F(green), DGL_F(blue), DGL_F(alpha)))
+#define dglColor4ub(red, green, blue, alpha) DGL_CALL(glColor4ub(red, green, blue, alpha), DGL_RecCmd(DGLREC_COLOR4UB, "iiii", DGL_I(red), DGL_I(green), DGL_I(blue), DGL_I(alpha)))
+#define dglColor4ubv(v) DGL_CALL(glColor4ubv(v), DGL_RecCmd(DGLREC_COLOR4UB, "iiii", DGL_I((v)[0]), DGL_I((v)[1]), DGL_I((v)[2]), DGL_I((v)[3])))
+#define dglColorPointer(size, type, stride, pointer) DGL_CALL(glColorPointer(size, type, stride, pointer), (void)0)
+#define dglCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height) DGL_CALL(glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height), DGL_RecCmd(DGLREC_COPYTEXSUBIMAGE2D, "iiiiiiii", DGL_I(target), DGL_I(level), DGL_I(xoffset), DGL_I(yoffset), DGL_I(x), DGL_I(y), DGL_I(width), DGL_I(height)))
+#define dglCullFace(mode) DGL_CALL(glCullFace(mode), DGL_RecCmd(DGLREC_CULLFACE, "i", DGL_I(mode)))
+#define dglDeleteTextures(n, textures) DGL_CALL(glDeleteTextures(n, textures), DGL_RecDeleteTextures(n, textures))
+#define dglDepthFunc(func) DGL_CALL(glDepthFunc(func), DGL_RecCmd(DGLREC_DEPTHFUNC, "i", DGL_I(func)))
+#define dglDepthMask(flag) DGL_CALL(glDepthMask(flag), DGL_RecCmd(DGLREC_DEPTHMASK, "i", DGL_I(flag)))
+#define dglDepthRange(zNear, zFar) DGL_CALL(glDepthRange(zNear, zFar), DGL_RecCmd(DGLREC_DEPTHRANGE, "ff", DGL_F(zNear), DGL_F(zFar)))
+#define dglDisable(cap) DGL_CALL(glDisable(cap), DGL_RecEnable(cap, false))
+#define dglDisableClientState(array) DGL_CALL(glDisableClientState(array), DGL_RecCmd(DGLREC_DISABLECLIENTSTATE, "i", DGL_I(array)))
+#define dglDrawElements(mode, count, type, indices) DGL_CALL(glDrawElements(mode, count, type, indices), DGL_RecDrawElements(mode, count, type, indices))
+#define dglEnable(cap) DGL_CALL(glEnable(cap), DGL_RecEnable(cap, true))
+#define dglEnableClientState(array) DGL_CALL(glEnableClientState(array), DGL_RecCmd(DGLREC_ENABLECLIENTSTATE, "i", DGL_I(array)))
+#define dglEnd() DGL_CALL(glEnd(), DGL_RecCmd(DGLREC_END, ""))
+#define dglFlush() DGL_CALL(glFlush(), DGL_RecCmd(DGLREC_FLUSH, ""))
+#define dglFogf(pname, param) DGL_CALL(glFogf(pname, param), DGL_RecCmd(DGLREC_FOGF, "if", DGL_I(pname), DGL_F(param)))
+#define dglFogfv(pname, params) DGL_CALL(glFogfv(pname, params), DGL_RecCmd(DGLREC_FOGFV, "iffff", DGL_I(pname), DGL_F((params)[0]), DGL_F((params)[1]), DGL_F((params)[2]), DGL_F((params)[3])))
+#define dglFogi(pname, param) DGL_CALL(glFogi(pname, param), DGL_RecCmd(DGLREC_FOGI, "ii", DGL_I(pname), DGL_I(param)))
+#define dglGenTextures(n, textures) DGL_CALL(glGenTextures(n, textures), DGL_RecGenTextures(n, textures))
+#define dglGetBooleanv(pname, params) DGL_CALL(glGetBooleanv(pname, params), DGL_RecGetBooleanv(pname, params))
+#define dglGetDoublev(pname, params) DGL_CALL(glGetDoublev(pname, params), DGL_RecGetDoublev(pname, params))
+#define dglGetFloatv(pname, params) DGL_CALL(glGetFloatv(pname, params), DGL_RecGetFloatv(pname, params))
+#define dglGetIntegerv(pname, params) DGL_CALL(glGetIntegerv(pname, params), DGL_RecGetIntegerv(pname, params))
+#define dglGetString(name) DGL_CALL(glGetString(name), DGL_RecGetString(name))
+#define dglHint(target, mode) DGL_CALL(glHint(target, mode), DGL_RecCmd(DGLREC_HINT, "ii", DGL_I(target), DGL_I(mode)))
+#define dglLoadIdentity() DGL_CALL(glLoadIdentity(), DGL_RecLoadIdentity())
+#define dglLockArraysEXT(first, count) DGL_CALL(_glLockArraysEXT(first, count), (void)0)
+#define dglMatrixMode(mode) DGL_CALL(glMatrixMode(mode), DGL_RecMatrixMode(mode))
+#define dglMultMatrixf(m) DGL_CALL(glMultMatrixf(m), DGL_RecMultMatrixf(m))
+#define dglOrtho(left, right, bottom, top, zNear, zFar) DGL_CALL(glOrtho(left, right, bottom, top, zNear, zFar), DGL_RecOrtho(left, right, bottom, top, zNear, zFar))
+#define dglPixelStorei(pname, param) DGL_CALL(glPixelStorei(pname, param), DGL_RecCmd(DGLREC_PIXELSTOREI, "ii", DGL_I(pname), DGL_I(param)))
+#define dglPolygonMode(face, mode) DGL_CALL(glPolygonMode(face, mode), DGL_RecCmd(DGLREC_POLYGONMODE, "ii", DGL_I(face), DGL_I(mode)))
+#define dglPopMatrix() DGL_CALL(glPopMatrix(), DGL_RecPopMatrix())
+#define dglPushMatrix() DGL_CALL(glPushMatrix(), DGL_RecPushMatrix())
+#define dglReadPixels(x, y, width, height, format, type, pixels) DGL_CALL(glReadPixels(x, y, width, height, format, type, pixels), DGL_RecReadPixels(width, height, format, pixels))
+#define dglRectf(x1, y1, x2, y2) DGL_CALL(glRectf(x1, y1, x2, y2), DGL_RecCmd(DGLREC_RECTF, "ffff", DGL_F(x1), DGL_F(y1), DGL_F(x2), DGL_F(y2)))
+#define dglRecti(x1, y1, x2, y2) DGL_CALL(glRecti(x1, y1, x2, y2), DGL_RecCmd(DGLREC_RECTI, "iiii", DGL_I(x1), DGL_I(y1), DGL_I(x2), DGL_I(y2)))
+#define dglRotatef(angle, x, y, z) DGL_CALL(glRotatef(angle, x, y, z), DGL_RecRotate(angle, x, y, z))
+#define dglScissor(x, y, width, height) DGL_CALL(glScissor(x, y, width, height), DGL_RecCmd(DGLREC_SCISSOR, "iiii", DGL_I(x), DGL_I(y), DGL_I(width), DGL_I(height)))
+#define dglShadeModel(mode) DGL_CALL(glShadeModel(mode), DGL_RecCmd(DGLREC_SHADEMODEL, "i", DGL_I(mode)))
+#define dglTexCoord2f(s, t) DGL_CALL(glTexCoord2f(s, t), DGL_RecCmd(DGLREC_TEXCOORD2F, "ff", DGL_F(s), DGL_F(t)))
+#define dglTexCoordPointer(size, type, stride, pointer) DGL_CALL(glTexCoordPointer(size, type, stride, pointer), (void)0)
+#define dglTexEnvfv(target, pname, params) DGL_CALL(glTexEnvfv(target, pname, params), DGL_RecCmd(DGLREC_TEXENVFV, "iiffff", DGL_I(target), DGL_I(pname), DGL_F((params)[0]), DGL_F((params)[1]), DGL_F((params)[2]), DGL_F((params)[3])))
+#define dglTexEnvi(target, pname, param) DGL_CALL(glTexEnvi(target, pname, param), DGL_RecCmd(DGLREC_TEXENVI, "iii", DGL_I(target), DGL_I(pname), DGL_I(param)))
+#define dglTexImage2D(target, level, internalformat, width, height, border, format, type, pixels) DGL_CALL(glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels), DGL_RecTexImage2D(DGLREC_TEXIMAGE2D, level, internalformat, 0, 0, width, height, format, type, pixels))
+#define dglTexParameterf(target, pname, param) DGL_CALL(glTexParameterf(target, pname, param), DGL_RecCmd(DGLREC_TEXPARAMETERF, "iif", DGL_I(target), DGL_I(pname), DGL_F(param)))
+#define dglTexParameteri(target, pname, param) DGL_CALL(glTexParameteri(target, pname, param), DGL_RecCmd(DGLREC_TEXPARAMETERI, "iii", DGL_I(target), DGL_I(pname), DGL_I(param)))
+#define dglTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels) DGL_CALL(glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels), DGL_RecTexImage2D(DGLREC_TEXSUBIMAGE2D, level, 0, xoffset, yoffset, width, height, format, type, pixels))
+#define dglTranslated(x, y, z) DGL_CALL(glTranslated(x, y, z), DGL_RecTranslate(x, y, z))
+#define dglTranslatef(x, y, z) DGL_CALL(glTranslatef(x, y, z), DGL_RecTranslate(x, y, z))
+#define dglUnlockArraysEXT() DGL_CALL(_glUnlockArraysEXT(), (void)0)
+#define dglVertex2f(x, y) DGL_CALL(glVertex2f(x, y), DGL_RecCmd(DGLREC_VERTEX2F, "ff", DGL_F(x), DGL_F(y)))
+#define dglVertex2i(x, y) DGL_CALL(glVertex2i(x, y), DGL_RecCmd(DGLREC_VERTEX2I, "ii", DGL_I(x), DGL_I(y)))
+#define dglVertex3f(x, y, z) DGL_CALL(glVertex3f(x, y, z), DGL_RecCmd(DGLREC_VERTEX3F, "fff", DGL_F(x), DGL_F(y), DGL_F(z)))
+#define dglVertexPointer(size, type, stride, pointer) DGL_CALL(glVertexPointer(size, type, stride, pointer), DGL_RecVertexPointer(pointer))
+#define dglViewport(x, y, width, height) DGL_CALL(glViewport(x, y, width, height), DGL_RecCmd(DGLREC_VIEWPORT, "iiii", DGL_I(x), DGL_I(y), DGL_I(width), DGL_I(height)))
+
+#endif // USE_DEBUG_GLFUNCS
+
 #endif // __DGL_H__
 
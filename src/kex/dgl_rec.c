@@ -0,0 +1,1008 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2013 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Recording backend for the dgl layer. Takes the place of
+//              OpenGL so the renderer can run without a GL context,
+//              turning every call into a command stream that can be
+//              written out and later replayed against OpenGL.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "z_zone.h"
+#include "m_misc.h"
+#include "i_system.h"
+#include "i_video.h"
+#include "con_console.h"
+
+#define DGLREC_MAGIC        0x524c4744  // "DGLR"
+#define DGLREC_VERSION      1
+#define DGLREC_MAXSTACK     32
+#define DGLREC_MAXCAPS      32
+
+typedef struct {
+    int     draws;
+    int     binds;
+    int     states;
+    int     vertices;
+    int     indices;
+    int     uploads;
+} dglrecstats_t;
+
+typedef struct {
+    GLenum      cap;
+    int         unit;
+    dboolean    enabled;
+} dglreccap_t;
+
+dboolean dglrecording = false;
+
+// current frame
+static dword*           recbuf = NULL;
+static int              recsize = 0;
+static int              recmax = 0;
+static dglrecstats_t    recframe;
+
+static FILE*            recfile = NULL;
+static dglrecstats_t    rectotal;
+static int              recframes = 0;
+
+// state that the getters need to answer for
+static const vtx_t*     recvertices = NULL;
+static int              recunit = 0;
+static GLuint           rectexture = 0;
+static double           recmatrix[2][DGLREC_MAXSTACK][16];
+static int              recdepth[2];
+static int              recmode = 0;
+static dglreccap_t      reccaps[DGLREC_MAXCAPS];
+static int              numreccaps = 0;
+
+static char             recextensions[] =
+    "GL_ARB_multitexture GL_ARB_texture_env_combine GL_EXT_texture_env_combine "
+    "GL_ARB_texture_non_power_of_two GL_EXT_texture_filter_anisotropic";
+
+static const double     recidentity[16] = {
+    1, 0, 0, 0,
+    0, 1, 0, 0,
+    0, 0, 1, 0,
+    0, 0, 0, 1
+};
+
+//
+// DGL_RecFloatBits
+//
+
+static dword DGL_RecFloatBits(float f) {
+    union {
+        float   f;
+        dword   w;
+    } u;
+
+    u.f = f;
+    return u.w;
+}
+
+//
+// DGL_RecBitsFloat
+//
+
+static float DGL_RecBitsFloat(dword w) {
+    union {
+        float   f;
+        dword   w;
+    } u;
+
+    u.w = w;
+    return u.f;
+}
+
+//
+// DGL_RecAlloc
+// Adds a command to the stream and returns where its
+// numwords worth of arguments go
+//
+
+static dword* DGL_RecAlloc(int op, int numwords) {
+    dword* cmd;
+
+    if(recsize + numwords + 1 > recmax) {
+        while(recsize + numwords + 1 > recmax) {
+            recmax = recmax ? recmax * 2 : 0x10000;
+        }
+
+        recbuf = realloc(recbuf, recmax * sizeof(dword));
+
+        if(!recbuf) {
+            I_Error("DGL_RecAlloc: Out of memory");
+        }
+    }
+
+    cmd = &recbuf[recsize];
+    cmd[0] = (dword)op | ((dword)numwords << 8);
+    recsize += numwords + 1;
+
+    return cmd + 1;
+}
+
+//
+// DGL_RecCmd
+// Records a command whose arguments are all plain values. args has
+// an 'i' for every int and an 'f' for every double that follows
+//
+
+void DGL_RecCmd(int op, const char* args, ...) {
+    va_list va;
+    dword*  a;
+    int     i;
+    int     count = dstrlen(args);
+
+    a = DGL_RecAlloc(op, count);
+
+    va_start(va, args);
+
+    for(i = 0; i < count; i++) {
+        if(args[i] == 'f') {
+            a[i] = DGL_RecFloatBits((float)va_arg(va, double));
+        }
+        else {
+            a[i] = (dword)va_arg(va, int);
+        }
+    }
+
+    va_end(va);
+
+    switch(op) {
+    case DGLREC_BINDTEXTURE:
+        recframe.binds++;
+        break;
+    case DGLREC_VERTEX2F:
+    case DGLREC_VERTEX2I:
+    case DGLREC_VERTEX3F:
+        recframe.vertices++;
+        break;
+    case DGLREC_END:
+    case DGLREC_RECTF:
+    case DGLREC_RECTI:
+        recframe.draws++;
+        break;
+    default:
+        recframe.states++;
+        break;
+    }
+}
+
+//
+// DGL_RecEnable
+//
+
+void DGL_RecEnable(GLenum cap, dboolean enable) {
+    int i;
+    int unit = (cap == GL_TEXTURE_2D) ? recunit : 0;
+
+    for(i = 0; i < numreccaps; i++) {
+        if(reccaps[i].cap == cap && reccaps[i].unit == unit) {
+            break;
+        }
+    }
+
+    if(i == numreccaps && numreccaps < DGLREC_MAXCAPS) {
+        reccaps[numreccaps].cap = cap;
+        reccaps[numreccaps].unit = unit;
+        numreccaps++;
+    }
+
+    if(i < numreccaps) {
+        reccaps[i].enabled = enable;
+    }
+
+    DGL_RecCmd(enable ? DGLREC_ENABLE : DGLREC_DISABLE, "i", (int)cap);
+}
+
+//
+// DGL_RecMultMatrix
+// current = current * m, same as OpenGL
+//
+
+static void DGL_RecMultMatrix(const double* m) {
+    double* cur = recmatrix[recmode][recdepth[recmode]];
+    double  res[16];
+    int     c;
+    int     r;
+
+    for(c = 0; c < 4; c++) {
+        for(r = 0; r < 4; r++) {
+            res[c * 4 + r] =
+                cur[0 * 4 + r] * m[c * 4 + 0] +
+                cur[1 * 4 + r] * m[c * 4 + 1] +
+                cur[2 * 4 + r] * m[c * 4 + 2] +
+                cur[3 * 4 + r] * m[c * 4 + 3];
+        }
+    }
+
+    dmemcpy(cur, res, sizeof(res));
+}
+
+//
+// DGL_RecMatrixMode
+//
+
+void DGL_RecMatrixMode(GLenum mode) {
+    recmode = (mode == GL_PROJECTION) ? 1 : 0;
+    DGL_RecCmd(DGLREC_MATRIXMODE, "i", (int)mode);
+}
+
+//
+// DGL_RecLoadIdentity
+//
+
+void DGL_RecLoadIdentity(void) {
+    dmemcpy(recmatrix[recmode][recdepth[recmode]], recidentity, sizeof(recidentity));
+    DGL_RecCmd(DGLREC_LOADIDENTITY, "");
+}
+
+//
+// DGL_RecPushMatrix
+//
+
+void DGL_RecPushMatrix(void) {
+    int depth = recdepth[recmode];
+
+    if(depth < DGLREC_MAXSTACK - 1) {
+        dmemcpy(recmatrix[recmode][depth + 1], recmatrix[recmode][depth], sizeof(double) * 16);
+        recdepth[recmode]++;
+    }
+
+    DGL_RecCmd(DGLREC_PUSHMATRIX, "");
+}
+
+//
+// DGL_RecPopMatrix
+//
+
+void DGL_RecPopMatrix(void) {
+    if(recdepth[recmode] > 0) {
+        recdepth[recmode]--;
+    }
+
+    DGL_RecCmd(DGLREC_POPMATRIX, "");
+}
+
+//
+// DGL_RecMultMatrixf
+//
+
+void DGL_RecMultMatrixf(const GLfloat* m) {
+    double  md[16];
+    dword*  a;
+    int     i;
+
+    a = DGL_RecAlloc(DGLREC_MULTMATRIXF, 16);
+
+    for(i = 0; i < 16; i++) {
+        md[i] = m[i];
+        a[i] = DGL_RecFloatBits(m[i]);
+    }
+
+    DGL_RecMultMatrix(md);
+    recframe.states++;
+}
+
+//
+// DGL_RecRotate
+//
+
+void DGL_RecRotate(double angle, double x, double y, double z) {
+    double m[16];
+    double len;
+    double s;
+    double c;
+    double t;
+
+    DGL_RecCmd(DGLREC_ROTATEF, "ffff", angle, x, y, z);
+
+    len = sqrt(x * x + y * y + z * z);
+    if(len == 0) {
+        return;
+    }
+
+    x /= len;
+    y /= len;
+    z /= len;
+
+    s = sin(angle * M_PI / 180.0);
+    c = cos(angle * M_PI / 180.0);
+    t = 1.0 - c;
+
+    m[ 0] = x * x * t + c;
+    m[ 1] = y * x * t + z * s;
+    m[ 2] = x * z * t - y * s;
+    m[ 3] = 0;
+
+    m[ 4] = x * y * t - z * s;
+    m[ 5] = y * y * t + c;
+    m[ 6] = y * z * t + x * s;
+    m[ 7] = 0;
+
+    m[ 8] = x * z * t + y * s;
+    m[ 9] = y * z * t - x * s;
+    m[10] = z * z * t + c;
+    m[11] = 0;
+
+    m[12] = 0;
+    m[13] = 0;
+    m[14] = 0;
+    m[15] = 1;
+
+    DGL_RecMultMatrix(m);
+}
+
+//
+// DGL_RecTranslate
+//
+
+void DGL_RecTranslate(double x, double y, double z) {
+    double m[16];
+
+    DGL_RecCmd(DGLREC_TRANSLATEF, "fff", x, y, z);
+
+    dmemcpy(m, recidentity, sizeof(m));
+    m[12] = x;
+    m[13] = y;
+    m[14] = z;
+
+    DGL_RecMultMatrix(m);
+}
+
+//
+// DGL_RecOrtho
+//
+
+void DGL_RecOrtho(double left, double right, double bottom, double top, double znear, double zfar) {
+    double m[16];
+
+    DGL_RecCmd(DGLREC_ORTHO, "ffffff", left, right, bottom, top, znear, zfar);
+
+    dmemset(m, 0, sizeof(m));
+    m[ 0] = 2.0 / (right - left);
+    m[ 5] = 2.0 / (top - bottom);
+    m[10] = -2.0 / (zfar - znear);
+    m[12] = -(right + left) / (right - left);
+    m[13] = -(top + bottom) / (top - bottom);
+    m[14] = -(zfar + znear) / (zfar - znear);
+    m[15] = 1;
+
+    DGL_RecMultMatrix(m);
+}
+
+//
+// DGL_RecActiveTexture
+//
+
+void DGL_RecActiveTexture(GLenum texture) {
+    recunit = texture - GL_TEXTURE0_ARB;
+    DGL_RecCmd(DGLREC_ACTIVETEXTURE, "i", (int)texture);
+}
+
+//
+// DGL_RecVertexPointer
+// Only ever called from dglSetVertex, so the texture
+// coords and colors are interleaved in the same vtx_t
+//
+
+void DGL_RecVertexPointer(const GLvoid* pointer) {
+    recvertices = (const vtx_t*)pointer;
+}
+
+//
+// DGL_RecDrawElements
+// Copies the vertices the draw uses into the stream along
+// with the indices, so that it can stand on its own
+//
+
+void DGL_RecDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+    const word* idx = (const word*)indices;
+    dword*      a;
+    int         numverts = 0;
+    int         vtxwords;
+    int         i;
+
+    if(type != GL_UNSIGNED_SHORT) {
+        I_Error("DGL_RecDrawElements: Unsupported index type 0x%x", type);
+    }
+
+    if(!recvertices) {
+        I_Error("DGL_RecDrawElements: No vertex pointer set");
+    }
+
+    for(i = 0; i < count; i++) {
+        if(idx[i] >= numverts) {
+            numverts = idx[i] + 1;
+        }
+    }
+
+    vtxwords = (numverts * sizeof(vtx_t)) / sizeof(dword);
+
+    a = DGL_RecAlloc(DGLREC_DRAWELEMENTS, 3 + vtxwords + (count + 1) / 2);
+    a[0] = mode;
+    a[1] = numverts;
+    a[2] = count;
+
+    dmemcpy(a + 3, recvertices, numverts * sizeof(vtx_t));
+    dmemcpy(a + 3 + vtxwords, idx, count * sizeof(word));
+
+    recframe.draws++;
+    recframe.vertices += numverts;
+    recframe.indices += count;
+}
+
+//
+// DGL_RecGenTextures
+//
+
+void DGL_RecGenTextures(GLsizei n, GLuint* textures) {
+    int i;
+
+    for(i = 0; i < n; i++) {
+        textures[i] = ++rectexture;
+        DGL_RecCmd(DGLREC_GENTEXTURE, "i", (int)textures[i]);
+    }
+}
+
+//
+// DGL_RecDeleteTextures
+//
+
+void DGL_RecDeleteTextures(GLsizei n, const GLuint* textures) {
+    int i;
+
+    for(i = 0; i < n; i++) {
+        DGL_RecCmd(DGLREC_DELETETEXTURE, "i", (int)textures[i]);
+    }
+}
+
+//
+// DGL_RecPixelSize
+//
+
+static int DGL_RecPixelSize(GLenum format) {
+    switch(format) {
+    case GL_RGBA:
+        return 4;
+    case GL_RGB:
+        return 3;
+    case GL_LUMINANCE_ALPHA:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+//
+// DGL_RecTexImage2D
+// Handles both glTexImage2D and glTexSubImage2D. Rows are
+// kept at the default unpack alignment of 4
+//
+
+void DGL_RecTexImage2D(int op, GLint level, GLint internalformat, GLint x, GLint y,
+                       GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels) {
+    dword*  a;
+    int     size = 0;
+
+    if(type != GL_UNSIGNED_BYTE) {
+        I_Error("DGL_RecTexImage2D: Unsupported pixel type 0x%x", type);
+    }
+
+    if(pixels) {
+        size = ((width * DGL_RecPixelSize(format) + 3) & ~3) * height;
+    }
+
+    a = DGL_RecAlloc(op, 9 + (size + 3) / 4);
+    a[0] = level;
+    a[1] = internalformat;
+    a[2] = x;
+    a[3] = y;
+    a[4] = width;
+    a[5] = height;
+    a[6] = format;
+    a[7] = type;
+    a[8] = size;
+
+    if(size) {
+        dmemcpy(a + 9, pixels, size);
+    }
+
+    recframe.uploads += size;
+}
+
+//
+// DGL_RecReadPixels
+// There's nothing to read back. Expects a pack alignment of 1
+//
+
+void DGL_RecReadPixels(GLsizei width, GLsizei height, GLenum format, GLvoid* pixels) {
+    dmemset(pixels, 0, width * height * DGL_RecPixelSize(format));
+}
+
+//
+// DGL_RecGetString
+//
+
+const GLubyte* DGL_RecGetString(GLenum name) {
+    switch(name) {
+    case GL_VENDOR:
+        return (const GLubyte*)"Doom64EX";
+    case GL_RENDERER:
+        return (const GLubyte*)"DGL command recorder";
+    case GL_VERSION:
+        return (const GLubyte*)"1.3";
+    case GL_EXTENSIONS:
+        return (const GLubyte*)recextensions;
+    default:
+        return (const GLubyte*)"";
+    }
+}
+
+//
+// DGL_RecGetIntegerv
+//
+
+void DGL_RecGetIntegerv(GLenum pname, GLint* params) {
+    switch(pname) {
+    case GL_MAX_TEXTURE_SIZE:
+        *params = 4096;
+        break;
+    case GL_MAX_TEXTURE_UNITS_ARB:
+        *params = 4;
+        break;
+    case GL_PACK_ALIGNMENT:
+    case GL_UNPACK_ALIGNMENT:
+        *params = 4;
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+//
+// DGL_RecGetDoublev
+//
+
+void DGL_RecGetDoublev(GLenum pname, GLdouble* params) {
+    switch(pname) {
+    case GL_MODELVIEW_MATRIX:
+        dmemcpy(params, recmatrix[0][recdepth[0]], sizeof(double) * 16);
+        break;
+    case GL_PROJECTION_MATRIX:
+        dmemcpy(params, recmatrix[1][recdepth[1]], sizeof(double) * 16);
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+//
+// DGL_RecGetFloatv
+//
+
+void DGL_RecGetFloatv(GLenum pname, GLfloat* params) {
+    double  m[16];
+    int     i;
+
+    switch(pname) {
+    case GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT:
+        *params = 16.0f;
+        break;
+    case GL_MODELVIEW_MATRIX:
+    case GL_PROJECTION_MATRIX:
+        DGL_RecGetDoublev(pname, m);
+        for(i = 0; i < 16; i++) {
+            params[i] = (float)m[i];
+        }
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+//
+// DGL_RecGetBooleanv
+//
+
+void DGL_RecGetBooleanv(GLenum pname, GLboolean* params) {
+    int i;
+    int unit = (pname == GL_TEXTURE_2D) ? recunit : 0;
+
+    *params = GL_FALSE;
+
+    for(i = 0; i < numreccaps; i++) {
+        if(reccaps[i].cap == pname && reccaps[i].unit == unit) {
+            *params = reccaps[i].enabled ? GL_TRUE : GL_FALSE;
+            break;
+        }
+    }
+}
+
+//
+// DGL_RecFrame
+// Called in place of swapping buffers
+//
+
+void DGL_RecFrame(void) {
+    DGL_RecAlloc(DGLREC_FRAME, 0);
+
+    if(recfile) {
+        fwrite(recbuf, sizeof(dword), recsize, recfile);
+    }
+
+    rectotal.draws += recframe.draws;
+    rectotal.binds += recframe.binds;
+    rectotal.states += recframe.states;
+    rectotal.vertices += recframe.vertices;
+    rectotal.indices += recframe.indices;
+    rectotal.uploads += recframe.uploads;
+    recframes++;
+
+    dmemset(&recframe, 0, sizeof(recframe));
+    recsize = 0;
+}
+
+//
+// DGL_RecInit
+// Called from GL_Init in place of setting up OpenGL
+//
+
+void DGL_RecInit(void) {
+    dword   header[4];
+    int     p;
+
+    recdepth[0] = recdepth[1] = 0;
+    dmemcpy(recmatrix[0][0], recidentity, sizeof(recidentity));
+    dmemcpy(recmatrix[1][0], recidentity, sizeof(recidentity));
+
+    p = M_CheckParm("-glrecord");
+    if(p && p < myargc-1) {
+        if(!(recfile = fopen(myargv[p+1], "wb"))) {
+            I_Error("DGL_RecInit: Couldn't write %s", myargv[p+1]);
+        }
+
+        header[0] = DGLREC_MAGIC;
+        header[1] = DGLREC_VERSION;
+        header[2] = video_width;
+        header[3] = video_height;
+
+        fwrite(header, sizeof(dword), 4, recfile);
+        I_Printf("DGL_RecInit: Recording to %s\n", myargv[p+1]);
+    }
+}
+
+//
+// DGL_RecShutdown
+//
+
+void DGL_RecShutdown(void) {
+    double frames = recframes ? recframes : 1;
+
+    I_Printf("DGL_RecShutdown: %i frames, per frame %.1f draws, %.1f binds, "
+             "%.1f state changes, %.1f vertices, %.1f indices, %.1f kb uploaded\n",
+             recframes, rectotal.draws / frames, rectotal.binds / frames,
+             rectotal.states / frames, rectotal.vertices / frames,
+             rectotal.indices / frames, rectotal.uploads / frames / 1024.0);
+
+    if(recfile) {
+        fclose(recfile);
+        recfile = NULL;
+    }
+
+    free(recbuf);
+    recbuf = NULL;
+    recsize = recmax = 0;
+}
+
+//
+// DGL_Replay
+// -glreplay <file> plays a stream written with -glrecord back
+// through OpenGL as fast as it can, then quits
+//
+
+void DGL_Replay(const char* filename) {
+    byte*       data;
+    dword*      cmd;
+    dword*      end;
+    dword*      a;
+    GLuint*     textures = NULL;
+    int         numtextures = 0;
+    int         length;
+    int         op;
+    int         size;
+    int         frames = 0;
+    uint64      start;
+    double      ms;
+    vtx_t*      v;
+
+    if(!usingGL || dglrecording) {
+        I_Error("DGL_Replay: OpenGL is needed to replay");
+    }
+
+    length = M_ReadFile(filename, &data);
+    if(length < (int)(sizeof(dword) * 4)) {
+        I_Error("DGL_Replay: Couldn't read %s", filename);
+    }
+
+    cmd = (dword*)data;
+    end = cmd + length / sizeof(dword);
+
+    if(cmd[0] != DGLREC_MAGIC || cmd[1] != DGLREC_VERSION) {
+        I_Error("DGL_Replay: %s is not a version %i recording", filename, DGLREC_VERSION);
+    }
+
+    if((int)cmd[2] != video_width || (int)cmd[3] != video_height) {
+        CON_Warnf("DGL_Replay: Recorded at %ix%i\n", cmd[2], cmd[3]);
+    }
+
+    cmd += 4;
+    start = I_GetTimeUS();
+
+    while(cmd < end) {
+        op = *cmd & 0xff;
+        size = *cmd >> 8;
+        a = cmd + 1;
+
+        if(a + size > end) {
+            I_Error("DGL_Replay: %s is truncated", filename);
+        }
+
+        switch(op) {
+        case DGLREC_FRAME:
+            GL_SwapBuffers();
+            I_StartTic();
+            frames++;
+            break;
+        case DGLREC_ACTIVETEXTURE:
+            dglActiveTextureARB(a[0]);
+            break;
+        case DGLREC_ALPHAFUNC:
+            dglAlphaFunc(a[0], DGL_RecBitsFloat(a[1]));
+            break;
+        case DGLREC_BEGIN:
+            dglBegin(a[0]);
+            break;
+        case DGLREC_BINDTEXTURE:
+            dglBindTexture(a[0], (int)a[1] < numtextures ? textures[a[1]] : 0);
+            break;
+        case DGLREC_BLENDFUNC:
+            dglBlendFunc(a[0], a[1]);
+            break;
+        case DGLREC_CLEAR:
+            dglClear(a[0]);
+            break;
+        case DGLREC_CLEARCOLOR:
+            dglClearColor(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]),
+                          DGL_RecBitsFloat(a[2]), DGL_RecBitsFloat(a[3]));
+            break;
+        case DGLREC_CLEARDEPTH:
+            dglClearDepth(DGL_RecBitsFloat(a[0]));
+            break;
+        case DGLREC_COLOR4F:
+            dglColor4f(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]),
+                       DGL_RecBitsFloat(a[2]), DGL_RecBitsFloat(a[3]));
+            break;
+        case DGLREC_COLOR4UB:
+            dglColor4ub((byte)a[0], (byte)a[1], (byte)a[2], (byte)a[3]);
+            break;
+        case DGLREC_COPYTEXSUBIMAGE2D:
+            dglCopyTexSubImage2D(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+            break;
+        case DGLREC_CULLFACE:
+            dglCullFace(a[0]);
+            break;
+        case DGLREC_DELETETEXTURE:
+            if((int)a[0] < numtextures && textures[a[0]]) {
+                dglDeleteTextures(1, &textures[a[0]]);
+                textures[a[0]] = 0;
+            }
+            break;
+        case DGLREC_DEPTHFUNC:
+            dglDepthFunc(a[0]);
+            break;
+        case DGLREC_DEPTHMASK:
+            dglDepthMask((GLboolean)a[0]);
+            break;
+        case DGLREC_DEPTHRANGE:
+            dglDepthRange(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]));
+            break;
+        case DGLREC_DISABLE:
+            dglDisable(a[0]);
+            break;
+        case DGLREC_DISABLECLIENTSTATE:
+            dglDisableClientState(a[0]);
+            break;
+        case DGLREC_DRAWELEMENTS:
+            v = (vtx_t*)(a + 3);
+            dglVertexPointer(3, GL_FLOAT, sizeof(vtx_t), v);
+            dglTexCoordPointer(2, GL_FLOAT, sizeof(vtx_t), &v->tu);
+            dglColorPointer(4, GL_UNSIGNED_BYTE, sizeof(vtx_t), &v->r);
+            dglDrawElements(a[0], a[2], GL_UNSIGNED_SHORT,
+                            a + 3 + (a[1] * sizeof(vtx_t)) / sizeof(dword));
+            break;
+        case DGLREC_ENABLE:
+            dglEnable(a[0]);
+            break;
+        case DGLREC_ENABLECLIENTSTATE:
+            dglEnableClientState(a[0]);
+            break;
+        case DGLREC_END:
+            dglEnd();
+            break;
+        case DGLREC_FLUSH:
+            dglFlush();
+            break;
+        case DGLREC_FOGF:
+            dglFogf(a[0], DGL_RecBitsFloat(a[1]));
+            break;
+        case DGLREC_FOGFV:
+        case DGLREC_TEXENVFV: {
+            float f[4];
+            int i;
+            int first = (op == DGLREC_FOGFV) ? 1 : 2;
+
+            for(i = 0; i < 4; i++) {
+                f[i] = DGL_RecBitsFloat(a[first + i]);
+            }
+
+            if(op == DGLREC_FOGFV) {
+                dglFogfv(a[0], f);
+            }
+            else {
+                dglTexEnvfv(a[0], a[1], f);
+            }
+        }
+        break;
+        case DGLREC_FOGI:
+            dglFogi(a[0], a[1]);
+            break;
+        case DGLREC_GENTEXTURE:
+            if((int)a[0] >= numtextures) {
+                int newsize = MAX(numtextures * 2, (int)a[0] + 256);
+
+                textures = realloc(textures, newsize * sizeof(GLuint));
+                if(!textures) {
+                    I_Error("DGL_Replay: Out of memory");
+                }
+
+                dmemset(textures + numtextures, 0, (newsize - numtextures) * sizeof(GLuint));
+                numtextures = newsize;
+            }
+            dglGenTextures(1, &textures[a[0]]);
+            break;
+        case DGLREC_HINT:
+            dglHint(a[0], a[1]);
+            break;
+        case DGLREC_LOADIDENTITY:
+            dglLoadIdentity();
+            break;
+        case DGLREC_MATRIXMODE:
+            dglMatrixMode(a[0]);
+            break;
+        case DGLREC_MULTMATRIXF: {
+            float m[16];
+            int i;
+
+            for(i = 0; i < 16; i++) {
+                m[i] = DGL_RecBitsFloat(a[i]);
+            }
+
+            dglMultMatrixf(m);
+        }
+        break;
+        case DGLREC_ORTHO:
+            dglOrtho(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]), DGL_RecBitsFloat(a[2]),
+                     DGL_RecBitsFloat(a[3]), DGL_RecBitsFloat(a[4]), DGL_RecBitsFloat(a[5]));
+            break;
+        case DGLREC_PIXELSTOREI:
+            dglPixelStorei(a[0], a[1]);
+            break;
+        case DGLREC_POLYGONMODE:
+            dglPolygonMode(a[0], a[1]);
+            break;
+        case DGLREC_POPMATRIX:
+            dglPopMatrix();
+            break;
+        case DGLREC_PUSHMATRIX:
+            dglPushMatrix();
+            break;
+        case DGLREC_RECTF:
+            dglRectf(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]),
+                     DGL_RecBitsFloat(a[2]), DGL_RecBitsFloat(a[3]));
+            break;
+        case DGLREC_RECTI:
+            dglRecti(a[0], a[1], a[2], a[3]);
+            break;
+        case DGLREC_ROTATEF:
+            dglRotatef(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]),
+                       DGL_RecBitsFloat(a[2]), DGL_RecBitsFloat(a[3]));
+            break;
+        case DGLREC_SCISSOR:
+            dglScissor(a[0], a[1], a[2], a[3]);
+            break;
+        case DGLREC_SHADEMODEL:
+            dglShadeModel(a[0]);
+            break;
+        case DGLREC_TEXCOORD2F:
+            dglTexCoord2f(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]));
+            break;
+        case DGLREC_TEXENVI:
+            dglTexEnvi(a[0], a[1], a[2]);
+            break;
+        case DGLREC_TEXIMAGE2D:
+            dglTexImage2D(GL_TEXTURE_2D, a[0], a[1], a[4], a[5], 0, a[6], a[7],
+                          a[8] ? (GLvoid*)(a + 9) : NULL);
+            break;
+        case DGLREC_TEXPARAMETERF:
+            dglTexParameterf(a[0], a[1], DGL_RecBitsFloat(a[2]));
+            break;
+        case DGLREC_TEXPARAMETERI:
+            dglTexParameteri(a[0], a[1], a[2]);
+            break;
+        case DGLREC_TEXSUBIMAGE2D:
+            dglTexSubImage2D(GL_TEXTURE_2D, a[0], a[2], a[3], a[4], a[5], a[6], a[7], a + 9);
+            break;
+        case DGLREC_TRANSLATEF:
+            dglTranslatef(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]), DGL_RecBitsFloat(a[2]));
+            break;
+        case DGLREC_VERTEX2F:
+            dglVertex2f(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]));
+            break;
+        case DGLREC_VERTEX2I:
+            dglVertex2i(a[0], a[1]);
+            break;
+        case DGLREC_VERTEX3F:
+            dglVertex3f(DGL_RecBitsFloat(a[0]), DGL_RecBitsFloat(a[1]), DGL_RecBitsFloat(a[2]));
+            break;
+        case DGLREC_VIEWPORT:
+            dglViewport(a[0], a[1], a[2], a[3]);
+            break;
+        default:
+            I_Error("DGL_Replay: Unknown command %i", op);
+            break;
+        }
+
+        cmd = a + size;
+    }
+
+    ms = (I_GetTimeUS() - start) / 1000.0;
+
+    I_Printf("DGL_Replay: %i frames in %.2fms (%.2f fps)\n",
+             frames, ms, ms > 0 ? frames * 1000.0 / ms : 0.0);
+
+    free(textures);
+    Z_Free(data);
+
+    I_Quit();
+}
@@ -0,0 +1,124 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2013 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __DGL_REC_H__
+#define __DGL_REC_H__
+
+#include "doomtype.h"
+
+//
+// recorded commands. every command is a dword holding the op in
+// the low 8 bits and the number of dwords that follow in the high
+// 24 bits, followed by its arguments. ints are stored as is and
+// floats and doubles as 32 bit floats. texture and vertex data is
+// padded out to a whole dword
+//
+typedef enum {
+    DGLREC_FRAME,               // end of a frame, no arguments
+    DGLREC_ACTIVETEXTURE,       // i
+    DGLREC_ALPHAFUNC,           // if
+    DGLREC_BEGIN,               // i
+    DGLREC_BINDTEXTURE,         // ii
+    DGLREC_BLENDFUNC,           // ii
+    DGLREC_CLEAR,               // i
+    DGLREC_CLEARCOLOR,          // ffff
+    DGLREC_CLEARDEPTH,          // f
+    DGLREC_COLOR4F,             // ffff
+    DGLREC_COLOR4UB,            // iiii
+    DGLREC_COPYTEXSUBIMAGE2D,   // iiiiiiii
+    DGLREC_CULLFACE,            // i
+    DGLREC_DELETETEXTURE,       // i
+    DGLREC_DEPTHFUNC,           // i
+    DGLREC_DEPTHMASK,           // i
+    DGLREC_DEPTHRANGE,          // ff
+    DGLREC_DISABLE,             // i
+    DGLREC_DISABLECLIENTSTATE,  // i
+    DGLREC_DRAWELEMENTS,        // mode, numverts, numindices, vtx_t[numverts], word[numindices]
+    DGLREC_ENABLE,              // i
+    DGLREC_ENABLECLIENTSTATE,   // i
+    DGLREC_END,
+    DGLREC_FLUSH,
+    DGLREC_FOGF,                // if
+    DGLREC_FOGFV,               // iffff
+    DGLREC_FOGI,                // ii
+    DGLREC_GENTEXTURE,          // i
+    DGLREC_HINT,                // ii
+    DGLREC_LOADIDENTITY,
+    DGLREC_MATRIXMODE,          // i
+    DGLREC_MULTMATRIXF,         // f[16]
+    DGLREC_ORTHO,               // ffffff
+    DGLREC_PIXELSTOREI,         // ii
+    DGLREC_POLYGONMODE,         // ii
+    DGLREC_POPMATRIX,
+    DGLREC_PUSHMATRIX,
+    DGLREC_RECTF,               // ffff
+    DGLREC_RECTI,               // iiii
+    DGLREC_ROTATEF,             // ffff
+    DGLREC_SCISSOR,             // iiii
+    DGLREC_SHADEMODEL,          // i
+    DGLREC_TEXCOORD2F,          // ff
+    DGLREC_TEXENVFV,            // iiffff
+    DGLREC_TEXENVI,             // iii
+    DGLREC_TEXIMAGE2D,          // iiiiiiii, pixel size, pixels
+    DGLREC_TEXPARAMETERF,       // iif
+    DGLREC_TEXPARAMETERI,       // iii
+    DGLREC_TEXSUBIMAGE2D,       // iiiiiiii, pixel size, pixels
+    DGLREC_TRANSLATEF,          // fff
+    DGLREC_VERTEX2F,            // ff
+    DGLREC_VERTEX2I,            // ii
+    DGLREC_VERTEX3F,            // fff
+    DGLREC_VIEWPORT,            // iiii
+    NUMDGLRECOPS
+} dglrecop_e;
+
+extern dboolean dglrecording;
+
+void DGL_RecInit(void);
+void DGL_RecShutdown(void);
+void DGL_RecFrame(void);
+void DGL_Replay(const char* filename);
+
+void DGL_RecCmd(int op, const char* args, ...);
+void DGL_RecEnable(GLenum cap, dboolean enable);
+void DGL_RecMatrixMode(GLenum mode);
+void DGL_RecLoadIdentity(void);
+void DGL_RecPushMatrix(void);
+void DGL_RecPopMatrix(void);
+void DGL_RecMultMatrixf(const GLfloat* m);
+void DGL_RecRotate(double angle, double x, double y, double z);
+void DGL_RecTranslate(double x, double y, double z);
+void DGL_RecOrtho(double left, double right, double bottom, double top, double znear, double zfar);
+void DGL_RecActiveTexture(GLenum texture);
+void DGL_RecVertexPointer(const GLvoid* pointer);
+void DGL_RecDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+void DGL_RecGenTextures(GLsizei n, GLuint* textures);
+void DGL_RecDeleteTextures(GLsizei n, const GLuint* textures);
+void DGL_RecTexImage2D(int op, GLint level, GLint internalformat, GLint x, GLint y,
+                       GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* pixels);
+void DGL_RecReadPixels(GLsizei width, GLsizei height, GLenum format, GLvoid* pixels);
+const GLubyte* DGL_RecGetString(GLenum name);
+void DGL_RecGetIntegerv(GLenum pname, GLint* params);
+void DGL_RecGetFloatv(GLenum pname, GLfloat* params);
+void DGL_RecGetDoublev(GLenum pname, GLdouble* params);
+void DGL_RecGetBooleanv(GLenum pname, GLboolean* params);
+
+#endif
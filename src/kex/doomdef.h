@@ -274,8 +274,13 @@ enum {
     GF_ALLOWCHEATS      = (1 << 7),
     GF_FRIENDLYFIRE     = (1 << 8),
     GF_KEEPITEMS        = (1 << 9),
+    GF_DORMANTMONSTERS  = (1 << 10),
 };
 
+// [kex] sv_dormantmonsters distance, in blockmap units
+#define GF_DORMANTDISTSHIFT 16
+#define GF_DORMANTDISTMASK  (0xff << GF_DORMANTDISTSHIFT)
+
 // 20120209 villsa - compatibility flags
 enum {
     COMPATF_COLLISION   = (1 << 0),     // don't use maxradius for mobj position checks
@@ -49,6 +49,8 @@ extern  dboolean    respawnitem;
 extern  dboolean    fastparm;       // checkparm of -fast
 extern  dboolean    nolights;
 extern  dboolean    devparm;        // DEBUG: launched with -devparm
+extern  dboolean    nodrawers;      // checkparm of -nodraw
+extern  dboolean    singletics;     // run one tic per frame, ignore the clock
 
 
 // -------------------------------------------
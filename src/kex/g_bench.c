@@ -0,0 +1,356 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2013 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Playsim stress benchmark. Loads a map, fills it with
+//              awake monsters and runs the game tickers with scripted
+//              player input, reporting the results as JSON.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "z_zone.h"
+#include "p_local.h"
+#include "p_tick.h"
+#include "g_game.h"
+#include "g_bench.h"
+#include "m_misc.h"
+#include "r_main.h"
+#include "i_system.h"
+
+void G_DoLoadLevel(void);
+
+#define SIMMAXRUNS      16
+#define SIMMAXTYPES     16
+#define SIMWARMUPTICS   35
+#define SIMSPAWNTRIES   16
+
+static int          simcounts[SIMMAXRUNS] = { 100, 1000, 5000, 20000 };
+static int          numsimcounts = 4;
+static mobjtype_t   simtypes[SIMMAXTYPES] = { MT_POSSESSED1, MT_IMP1, MT_DEMON1, MT_CACODEMON };
+static int          numsimtypes = 4;
+static int          simtics = 700;
+static uint32       simseed = 1;
+static uint32       simrand;
+
+static uint32*      simsamples = NULL;
+
+//
+// G_SimRandom
+// Own generator so that placement doesn't touch the game's rng
+//
+
+static int G_SimRandom(int range) {
+    simrand = simrand * 1664525 + 1013904223;
+    return (int)((simrand >> 8) % (uint32)range);
+}
+
+//
+// G_SimParmList
+// Reads the numbers following a parameter, up to the next switch
+//
+
+static int G_SimParmList(char* parm, int* list, int max) {
+    int p;
+    int count = 0;
+
+    p = M_CheckParm(parm);
+    if(!p) {
+        return 0;
+    }
+
+    while(++p < myargc && myargv[p][0] != '-' && count < max) {
+        list[count++] = datoi(myargv[p]);
+    }
+
+    return count;
+}
+
+//
+// G_SimTypeForDoomedNum
+//
+
+static mobjtype_t G_SimTypeForDoomedNum(int doomednum) {
+    int i;
+
+    for(i = 0; i < NUMMOBJTYPES; i++) {
+        if(mobjinfo[i].doomednum == doomednum) {
+            return i;
+        }
+    }
+
+    I_Error("G_SimBenchmark: No thing type for doomednum %i", doomednum);
+    return MT_PLAYER;
+}
+
+//
+// G_SimSpawnMonster
+// Drops a monster at a random spot inside a random subsector.
+// Returns false if it had to be left overlapping something
+//
+
+static dboolean G_SimSpawnMonster(mobjtype_t type) {
+    int         tries;
+    int         i;
+    subsector_t *sub;
+    leaf_t      *leaf;
+    sector_t    *sec;
+    fixed_t     x;
+    fixed_t     y;
+    fixed_t     frac;
+    mobj_t      *mo = NULL;
+
+    for(tries = 0; tries < SIMSPAWNTRIES; tries++) {
+        sub = &subsectors[G_SimRandom(numsubsectors)];
+        sec = sub->sector;
+
+        if(sub->numleafs < 3 ||
+                sec->ceilingheight - sec->floorheight < mobjinfo[type].height) {
+            continue;
+        }
+
+        // the leaf is convex, so anything between its
+        // center and one of its corners is inside of it
+        x = y = 0;
+        for(i = 0; i < sub->numleafs; i++) {
+            leaf = &leafs[sub->leaf + i];
+            x += leaf->vertex->x / sub->numleafs;
+            y += leaf->vertex->y / sub->numleafs;
+        }
+
+        leaf = &leafs[sub->leaf + G_SimRandom(sub->numleafs)];
+        frac = G_SimRandom(FRACUNIT - (FRACUNIT / 8));
+
+        x += FixedMul(leaf->vertex->x - x, frac);
+        y += FixedMul(leaf->vertex->y - y, frac);
+
+        if(mo) {
+            P_RemoveMobj(mo);
+        }
+
+        mo = P_SpawnMobj(x, y, ONFLOORZ, type);
+
+        if(P_CheckPosition(mo, x, y)) {
+            break;
+        }
+    }
+
+    if(!mo) {
+        return false;
+    }
+
+    // wake it up and point it at the player
+    P_SetTarget(&mo->target, players[consoleplayer].mo);
+    P_SetMobjState(mo, (statenum_t)mobjinfo[type].seestate);
+
+    return tries < SIMSPAWNTRIES;
+}
+
+//
+// G_SimBuildTiccmd
+// Walks back and forth while turning, firing in bursts
+//
+
+static void G_SimBuildTiccmd(ticcmd_t* cmd, int tic) {
+    dmemset(cmd, 0, sizeof(ticcmd_t));
+
+    cmd->forwardmove = ((tic / 70) & 1) ? -25 : 25;
+    cmd->angleturn = 320;
+
+    if((tic % 35) < 10) {
+        cmd->buttons |= BT_ATTACK;
+    }
+}
+
+//
+// G_SimRunTic
+//
+
+static void G_SimRunTic(int tic) {
+    G_SimBuildTiccmd(&netcmds[consoleplayer][(gametic / ticdup) % BACKUPTICS], tic);
+
+    G_Ticker();
+    P_Ticker();
+
+    gametic++;
+    Z_FreeAlloca();
+
+    // exits, deaths and the like are of no interest here
+    gameaction = ga_nothing;
+}
+
+//
+// G_SimCompare
+//
+
+static int G_SimCompare(const void* a, const void* b) {
+    uint32 x = *(uint32*)a;
+    uint32 y = *(uint32*)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+//
+// G_SimRun
+// Runs a single pass with the given number of monsters
+//
+
+static void G_SimRun(int map, int count) {
+    int         i;
+    int         overlapping = 0;
+    int         numtics;
+    int         allocs;
+    int         mobjs = 0;
+    uint64      start;
+    uint64      tic;
+    double      wallms;
+    double      avgms;
+    mobj_t      *mo;
+
+    // free the previous pass, as P_Stop would
+    Z_FreeTags(PU_LEVEL, PU_PURGELEVEL-1);
+
+    simrand = simseed;
+    menuactive = false;
+
+    G_InitNew(sk_medium, map);
+    G_DoLoadLevel();
+
+    if(gameaction == ga_title) {
+        I_Error("G_SimBenchmark: Map %i not found", map);
+    }
+
+    P_Start();
+    players[consoleplayer].cheats |= CF_GODMODE;
+
+    for(i = 0; i < count; i++) {
+        if(!G_SimSpawnMonster(simtypes[i % numsimtypes])) {
+            overlapping++;
+        }
+    }
+
+    for(i = 0; i < SIMWARMUPTICS; i++) {
+        G_SimRunTic(i);
+    }
+
+    dmemset(tickertime, 0, sizeof(tickertime));
+    tickertiming = true;
+
+    // only this pass's peaks
+    Z_ResetTagPeaks();
+
+    numtics = 0;
+    allocs = Z_AllocCount();
+    start = I_GetTimeUS();
+
+    for(i = 0; i < simtics; i++) {
+        tic = I_GetTimeUS();
+        G_SimRunTic(SIMWARMUPTICS + i);
+        simsamples[numtics++] = (uint32)(I_GetTimeUS() - tic);
+    }
+
+    wallms = (I_GetTimeUS() - start) / 1000.0;
+    allocs = Z_AllocCount() - allocs;
+    tickertiming = false;
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        mobjs++;
+    }
+
+    avgms = wallms / numtics;
+    qsort(simsamples, numtics, sizeof(uint32), G_SimCompare);
+
+    I_Printf("{\"simbench\":%i,\"monsters\":%i,\"overlapping\":%i,\"seed\":%u,"
+             "\"tics\":%i,\"mobjs\":%i,\"wall_ms\":%.3f,"
+             "\"ms_per_tic\":{\"avg\":%.3f,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f},"
+             "\"subsystem_ms\":{\"players\":%.4f,\"thinkers\":%.4f,\"sights\":%.4f,"
+             "\"mobjs\":%.4f,\"specials\":%.4f,\"macros\":%.4f},"
+             "\"allocs_per_tic\":%.2f,"
+             "\"zone_peak_kb\":{\"static\":%i,\"level\":%i,\"levspec\":%i,\"cache\":%i}}\n",
+             map, count, overlapping, simseed, numtics, mobjs, wallms, avgms,
+             simsamples[(numtics - 1) * 50 / 100] / 1000.0,
+             simsamples[(numtics - 1) * 95 / 100] / 1000.0,
+             simsamples[(numtics - 1) * 99 / 100] / 1000.0,
+             tickertime[TICK_PLAYERS] / 1000.0 / numtics,
+             tickertime[TICK_THINKERS] / 1000.0 / numtics,
+             tickertime[TICK_SIGHTS] / 1000.0 / numtics,
+             tickertime[TICK_MOBJS] / 1000.0 / numtics,
+             tickertime[TICK_SPECIALS] / 1000.0 / numtics,
+             tickertime[TICK_MACROS] / 1000.0 / numtics,
+             (double)allocs / numtics,
+             Z_TagPeakUsage(PU_STATIC) >> 10, Z_TagPeakUsage(PU_LEVEL) >> 10,
+             Z_TagPeakUsage(PU_LEVSPEC) >> 10, Z_TagPeakUsage(PU_CACHE) >> 10);
+}
+
+//
+// G_SimBenchmark
+// -simbench <map> runs the playsim on its own for each of the
+// monster counts given with -simcount and prints a line of
+// JSON for every pass, then quits
+//
+
+void G_SimBenchmark(int map) {
+    int i;
+    int p;
+    int list[SIMMAXTYPES];
+    int num;
+
+    if((num = G_SimParmList("-simcount", list, SIMMAXRUNS))) {
+        numsimcounts = num;
+        for(i = 0; i < num; i++) {
+            simcounts[i] = MAX(list[i], 0);
+        }
+    }
+
+    if((num = G_SimParmList("-simtype", list, SIMMAXTYPES))) {
+        numsimtypes = num;
+        for(i = 0; i < num; i++) {
+            simtypes[i] = G_SimTypeForDoomedNum(list[i]);
+        }
+    }
+
+    p = M_CheckParm("-simtics");
+    if(p && p < myargc-1) {
+        simtics = MAX(datoi(myargv[p+1]), 1);
+    }
+
+    p = M_CheckParm("-simseed");
+    if(p && p < myargc-1) {
+        simseed = (uint32)datoi(myargv[p+1]);
+    }
+
+    // not using the zone so that the samples don't show up in the peak usage
+    if(!(simsamples = (uint32*)malloc(simtics * sizeof(uint32)))) {
+        I_Error("G_SimBenchmark: Out of memory");
+    }
+
+    for(i = 0; i < numsimcounts; i++) {
+        G_SimRun(map, simcounts[i]);
+    }
+
+    free(simsamples);
+    simsamples = NULL;
+
+    I_Quit();
+}
@@ -35,6 +35,8 @@
 #include "m_misc.h"
 #include "m_random.h"
 #include "con_console.h"
+#include "i_system.h"
+#include "p_saveg.h"
 
 void        G_DoLoadLevel(void);
 dboolean    G_CheckDemoStatus(void);
@@ -53,6 +55,16 @@ byte*           demoend;
 dboolean        singledemo      = false;    // quit after playing a demo from cmdline
 dboolean        endDemo;
 dboolean        iwadDemo        = false;
+dboolean        timingdemo      = false;    // run demo as fast as possible and report stats
+
+static uint32   *timedemo_samples;          // wall time of each tic, in microseconds
+static int      timedemo_numsamples;
+static int      timedemo_maxsamples;
+static uint64   timedemo_starttime;
+
+static FILE     *demohashfp;                // per-tic state hashes (-demohash / -demoverify)
+static dboolean demohashverify;
+static int      demohashtic;
 
 extern int      starttime;
 
@@ -219,6 +231,10 @@ void G_PlayDemo(const char* name) {
     endDemo = false;
 
     p = M_CheckParm("-playdemo");
+    if(!p) {
+        p = M_CheckParm("-timedemo");
+    }
+
     if(p && p < myargc-1) {
         // 20120107 bkw: add .lmp extension if missing.
         if(dstrrchr(myargv[p+1], '.')) {
@@ -329,6 +345,10 @@ dboolean G_CheckDemoStatus(void) {
 
     if(demoplayback) {
         if(singledemo) {
+            if(timingdemo) {
+                G_TimeDemoSummary();
+            }
+
             I_Quit();
         }
 
@@ -350,3 +370,210 @@ dboolean G_CheckDemoStatus(void) {
 
     return false;
 }
+
+//
+// TIMEDEMO
+//
+
+//
+// G_TimeDemo
+// Plays back a demo without waiting on the clock
+//
+
+void G_TimeDemo(const char* name) {
+    timingdemo = true;
+    singletics = true;
+    singledemo = true;  // quit after one demo
+
+    dstrncpy(demoname, name, sizeof(demoname) - 1);
+
+    timedemo_numsamples = 0;
+    timedemo_starttime = I_GetTimeUS();
+
+    G_PlayDemo(name);
+
+    if(gameaction == ga_exitdemo) {
+        I_Error("G_TimeDemo: Couldn't play demo %s", name);
+        return;
+    }
+
+    // playback ended without going through G_CheckDemoStatus
+    G_TimeDemoSummary();
+    I_Quit();
+}
+
+//
+// G_TimeDemoTic
+// Records how long a single tic took to run
+//
+
+void G_TimeDemoTic(uint32 usec) {
+    if(timedemo_numsamples >= timedemo_maxsamples) {
+        timedemo_maxsamples = timedemo_maxsamples ? timedemo_maxsamples * 2 : 4096;
+
+        // not using the zone so that the samples don't show up in the peak usage
+        timedemo_samples = realloc(timedemo_samples, timedemo_maxsamples * sizeof(uint32));
+
+        if(!timedemo_samples) {
+            I_Error("G_TimeDemoTic: Out of memory");
+        }
+    }
+
+    timedemo_samples[timedemo_numsamples++] = usec;
+}
+
+//
+// G_TimeDemoCompare
+//
+
+static int G_TimeDemoCompare(const void* a, const void* b) {
+    uint32 x = *(uint32*)a;
+    uint32 y = *(uint32*)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+//
+// G_TimeDemoPercentile
+// Returns a percentile (in milliseconds) from the sorted samples
+//
+
+static double G_TimeDemoPercentile(int pct) {
+    if(!timedemo_numsamples) {
+        return 0;
+    }
+
+    return timedemo_samples[(timedemo_numsamples - 1) * pct / 100] / 1000.0;
+}
+
+//
+// G_TimeDemoSummary
+// Prints the results as a single line of JSON so it can be
+// collected by scripts
+//
+
+void G_TimeDemoSummary(void) {
+    double wallms;
+    double ticrate;
+
+    wallms = (I_GetTimeUS() - timedemo_starttime) / 1000.0;
+    ticrate = wallms > 0 ? timedemo_numsamples * 1000.0 / wallms : 0;
+
+    if(timedemo_numsamples) {
+        qsort(timedemo_samples, timedemo_numsamples, sizeof(uint32), G_TimeDemoCompare);
+    }
+
+    I_Printf("{\"timedemo\":\"%s\",\"nodraw\":%i,\"tics\":%i,\"wall_ms\":%.3f,"
+             "\"tics_per_sec\":%.2f,\"ms_per_tic\":{\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f},"
+             "\"zone_peak_kb\":{\"static\":%i,\"level\":%i,\"levspec\":%i,\"cache\":%i}}\n",
+             demoname, nodrawers ? 1 : 0, timedemo_numsamples, wallms, ticrate,
+             G_TimeDemoPercentile(50), G_TimeDemoPercentile(95), G_TimeDemoPercentile(99),
+             Z_TagPeakUsage(PU_STATIC) >> 10, Z_TagPeakUsage(PU_LEVEL) >> 10,
+             Z_TagPeakUsage(PU_LEVSPEC) >> 10, Z_TagPeakUsage(PU_CACHE) >> 10);
+
+    timingdemo = false;
+}
+
+//
+// DETERMINISM CHECKING
+//
+
+//
+// G_DemoHashInit
+// -demohash <file> writes a hash of the game state for every tic
+// of the demo, -demoverify <file> compares against such a file
+//
+
+void G_DemoHashInit(void) {
+    int p;
+
+    demohashtic = 0;
+
+    p = M_CheckParm("-demohash");
+    if(p && p < myargc-1) {
+        if(!(demohashfp = fopen(myargv[p+1], "w"))) {
+            I_Error("G_DemoHashInit: Couldn't write %s", myargv[p+1]);
+        }
+
+        demohashverify = false;
+        return;
+    }
+
+    p = M_CheckParm("-demoverify");
+    if(p && p < myargc-1) {
+        if(!(demohashfp = fopen(myargv[p+1], "r"))) {
+            I_Error("G_DemoHashInit: Couldn't read %s", myargv[p+1]);
+        }
+
+        demohashverify = true;
+    }
+}
+
+//
+// G_DemoHashTic
+// Called at the end of every game tic
+//
+
+void G_DemoHashTic(void) {
+    unsigned int hashes[NUMSTATEHASH];
+    unsigned int expected[NUMSTATEHASH];
+    int tic, map, time;
+    int i;
+
+    if(!demohashfp || !(demoplayback || demorecording)) {
+        return;
+    }
+
+    P_HashGameState(hashes);
+
+    if(!demohashverify) {
+        fprintf(demohashfp, "%i %i %i", demohashtic, gamemap, leveltime);
+
+        for(i = 0; i < NUMSTATEHASH; i++) {
+            fprintf(demohashfp, " %08x", hashes[i]);
+        }
+
+        fprintf(demohashfp, "\n");
+        demohashtic++;
+        return;
+    }
+
+    if(fscanf(demohashfp, "%i %i %i", &tic, &map, &time) != 3) {
+        I_Printf("G_DemoHashTic: Hash file ends at tic %i\n", demohashtic);
+        fclose(demohashfp);
+        demohashfp = NULL;
+        return;
+    }
+
+    for(i = 0; i < NUMSTATEHASH; i++) {
+        if(fscanf(demohashfp, "%x", &expected[i]) != 1) {
+            I_Error("G_DemoHashTic: Malformed hash file at tic %i", tic);
+        }
+    }
+
+    for(i = 0; i < NUMSTATEHASH; i++) {
+        if(hashes[i] != expected[i]) {
+            I_Error("G_DemoHashTic: Desync at tic %i (map %i, leveltime %i): %s differs (%08x, expected %08x)",
+                    demohashtic, gamemap, leveltime, statehashnames[i], hashes[i], expected[i]);
+        }
+    }
+
+    demohashtic++;
+}
+
+//
+// G_DemoHashShutdown
+//
+
+void G_DemoHashShutdown(void) {
+    if(!demohashfp) {
+        return;
+    }
+
+    if(demohashverify) {
+        I_Printf("G_DemoHashShutdown: %i tics verified\n", demohashtic);
+    }
+
+    fclose(demohashfp);
+    demohashfp = NULL;
+}
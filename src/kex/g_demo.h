@@ -32,6 +32,12 @@ void G_RecordDemo(const char* name);
 void G_PlayDemo(const char* name);
 void G_ReadDemoTiccmd(ticcmd_t* cmd);
 void G_WriteDemoTiccmd(ticcmd_t* cmd);
+void G_TimeDemo(const char* name);
+void G_TimeDemoTic(uint32 usec);
+void G_TimeDemoSummary(void);
+void G_DemoHashInit(void);
+void G_DemoHashTic(void);
+void G_DemoHashShutdown(void);
 
 extern char             demoname[256];  // name of demo lump
 extern dboolean         demorecording;  // currently recording a demo
@@ -43,5 +49,6 @@ extern byte*            demoend;
 extern dboolean         singledemo;
 extern dboolean         endDemo;        // signal recorder to stop on next tick
 extern dboolean         iwadDemo;       // hide hud, end playback after one level
+extern dboolean         timingdemo;     // -timedemo
 
 #endif
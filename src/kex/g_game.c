@@ -59,6 +59,7 @@
 #include "m_password.h"
 #include "i_video.h"
 #include "g_demo.h"
+#include "d_prof.h"
 
 #define DCLICK_TIME     20
 
@@ -150,6 +151,17 @@ NETCVAR_PARAM(compat_mobjpass,  1,  compatflags,    COMPATF_MOBJPASS);
 NETCVAR_PARAM(compat_limitpain, 1,  compatflags,    COMPATF_LIMITPAIN);
 NETCVAR_PARAM(compat_grabitems, 1,  compatflags,    COMPATF_REACHITEMS);
 
+static int G_DormancyFlags(float distance);
+
+//
+// [kex] distance past which idle monsters stop thinking, 0 to disable.
+// it is packed into gameflags so demos and netgames carry it along
+//
+NETCVAR_CMD(sv_dormantmonsters, 0) {
+    gameflags &= ~(GF_DORMANTMONSTERS|GF_DORMANTDISTMASK);
+    gameflags |= G_DormancyFlags(cvar->value);
+}
+
 CVAR_EXTERNAL(v_mlook);
 CVAR_EXTERNAL(v_mlookinvert);
 CVAR_EXTERNAL(v_yaxismove);
@@ -170,6 +182,7 @@ void G_RegisterCvars(void) {
     CON_CvarRegister(&sv_fastmonsters);
     CON_CvarRegister(&sv_respawnitems);
     CON_CvarRegister(&sv_lockmonsters);
+    CON_CvarRegister(&sv_dormantmonsters);
     CON_CvarRegister(&sv_respawn);
     CON_CvarRegister(&sv_skill);
     CON_CvarRegister(&sv_allowcheats);
@@ -860,6 +873,29 @@ void G_ClearInput(void) {
     }
 }
 
+//
+// G_DormancyFlags
+//
+
+static int G_DormancyFlags(float distance) {
+    int blocks;
+
+    if(distance <= 0) {
+        return 0;
+    }
+
+    blocks = (int)distance / MAPBLOCKUNITS;
+
+    if(blocks < 1) {
+        blocks = 1;
+    }
+    else if(blocks > 0xff) {
+        blocks = 0xff;
+    }
+
+    return GF_DORMANTMONSTERS | (blocks << GF_DORMANTDISTSHIFT);
+}
+
 //
 // G_SetGameFlags
 //
@@ -875,6 +911,8 @@ static void G_SetGameFlags(void) {
     if(p_allowjump.value > 0)      gameflags |= GF_ALLOWJUMP;
     if(p_autoaim.value > 0)        gameflags |= GF_ALLOWAUTOAIM;
 
+    gameflags |= G_DormancyFlags(sv_dormantmonsters.value);
+
     if(compat_collision.value > 0) compatflags |= COMPATF_COLLISION;
     if(compat_mobjpass.value > 0)  compatflags |= COMPATF_MOBJPASS;
     if(compat_limitpain.value > 0) compatflags |= COMPATF_LIMITPAIN;
@@ -1031,6 +1069,8 @@ void G_Ticker(void) {
     int         buf;
     ticcmd_t*   cmd;
 
+    PROF_BEGIN(PROF_GTICKER);
+
     G_ActionTicker();
     CON_Ticker();
 
@@ -1118,6 +1158,8 @@ void G_Ticker(void) {
             }
         }
     }
+
+    PROF_END(PROF_GTICKER);
 }
 
 //
@@ -1636,6 +1678,8 @@ void G_Init(void) {
     G_AddCommand("setcamerastatic", CMD_PlayerCamera, 0);
     G_AddCommand("setcamerachase", CMD_PlayerCamera, 1);
     G_AddCommand("enddemo", CMD_EndDemo, 0);
+
+    D_ProfRegisterCommands();
 }
 
 //
@@ -32,6 +32,7 @@
 #include "gl_texture.h"
 #include "gl_draw.h"
 #include "r_main.h"
+#include "z_zone.h"
 
 //
 // Draw_GfxImage
@@ -106,50 +107,322 @@ void Draw_Sprite2D(int type, int rot, int frame, int x, int y,
 //
 //
 
-static vtx_t vtxstring[MAX_MESSAGE_SIZE];
+//
+// Text is laid out once into a mesh that is kept in a small cache
+// keyed by the string, so that text which stays the same from one
+// frame to the next skips the layout. Meshes are copied into a
+// vertex stream per font, with the ortho scale worked in, and each
+// stream is drawn in one go when it gets flushed. Outside of
+// Draw_BeginText/Draw_EndText that happens right away. Inside,
+// the streams are held until Draw_EndText and drawn in the order
+// their fonts were first used, so only text may be drawn in between
+//
+
+enum {
+    TF_SMALL,       // Draw_Text
+    TF_BIG,         // Draw_BigText
+    TF_CONSOLE,     // Draw_ConsoleText
+    NUMTEXTFONTS
+};
+
+#define TEXTCACHESIZE   256
+#define TEXTMAXVERTS    (MAX_MESSAGE_SIZE * 4)
+#define TEXTSTREAMVERTS (TEXTMAXVERTS * 2)
+
+typedef struct {
+    const char* name;
+    dboolean    nearest;    // point filtered
+    dboolean    fill;       // still drawn filled in wireframe mode
+    dboolean    reverse;    // glyph quads are wound the other way
+} textfont_t;
+
+typedef struct {
+    uint32      hash;
+    int         font;
+    int         x;          // tabs and wrapping depend on where the text starts
+    float       scale;
+    dboolean    wrap;
+    char*       string;
+    vtx_t*      vtx;
+    int         numverts;
+    float       end;
+} textmesh_t;
+
+typedef struct {
+    vtx_t       vtx[TEXTSTREAMVERTS];
+    int         numverts;
+    dboolean    queued;
+} textstream_t;
+
+static const textfont_t textfonts[NUMTEXTFONTS] = {
+    { "SFONT",      false,  true,   false },
+    { "SYMBOLS",    false,  false,  true },
+    { "CONFONT",    true,   false,  true }
+};
+
+static textmesh_t   textcache[TEXTCACHESIZE];
+static textstream_t textstreams[NUMTEXTFONTS];
+static int          textorder[NUMTEXTFONTS];
+static int          numtextorder = 0;
+static int          textbatch = 0;
+static vtx_t        textbuild[TEXTMAXVERTS];
+
+int textHits = 0;
+int textMisses = 0;
 
 //
-// Draw_Text
+// Draw_TextHash
 //
 
-int Draw_Text(int x, int y, rcolor color, float scale,
-              dboolean wrap, const char* string, ...) {
-    int c;
-    int i;
-    int vi = 0;
-    int    col;
-    const float size = 0.03125f;
-    float fcol, frow;
-    int start = 0;
-    dboolean fill = false;
-    char msg[MAX_MESSAGE_SIZE];
-    va_list    va;
-    const int ix = x;
+static uint32 Draw_TextHash(int font, const char* string, int x, float scale, dboolean wrap) {
+    uint32 hash = 2166136261U;
+    uint32 bits;
 
-    va_start(va, string);
-    vsprintf(msg, string, va);
-    va_end(va);
+    dmemcpy(&bits, &scale, sizeof(bits));
+
+    hash = (hash ^ (uint32)font) * 16777619;
+    hash = (hash ^ (uint32)x) * 16777619;
+    hash = (hash ^ bits) * 16777619;
+    hash = (hash ^ (uint32)wrap) * 16777619;
+
+    while(*string) {
+        hash = (hash ^ (byte)*string++) * 16777619;
+    }
+
+    return hash;
+}
+
+//
+// Draw_GetTextMesh
+// Returns the cache slot for the string. hit is
+// set if it already holds the string's mesh
+//
+
+static textmesh_t* Draw_GetTextMesh(int font, const char* string, int x,
+                                    float scale, dboolean wrap, dboolean* hit) {
+    uint32      hash;
+    textmesh_t* mesh;
+
+    hash = Draw_TextHash(font, string, x, scale, wrap);
+    mesh = &textcache[hash & (TEXTCACHESIZE - 1)];
+
+    *hit = (mesh->string && mesh->hash == hash && mesh->font == font &&
+            mesh->x == x && mesh->scale == scale && mesh->wrap == wrap &&
+            !dstrcmp(mesh->string, string));
+
+    if(*hit) {
+        textHits++;
+    }
+    else {
+        textMisses++;
+
+        if(mesh->string) {
+            Z_Free(mesh->string);
+        }
+
+        if(mesh->vtx) {
+            Z_Free(mesh->vtx);
+        }
+
+        mesh->hash = hash;
+        mesh->font = font;
+        mesh->x = x;
+        mesh->scale = scale;
+        mesh->wrap = wrap;
+        mesh->string = NULL;
+        mesh->vtx = NULL;
+        mesh->numverts = 0;
+        mesh->end = 0;
+    }
+
+    return mesh;
+}
+
+//
+// Draw_SetTextMesh
+// Keeps the vertices just laid out in textbuild
+//
+
+static void Draw_SetTextMesh(textmesh_t* mesh, const char* string, int numverts, float end) {
+    mesh->string = Z_Strdup(string, PU_STATIC, 0);
+    mesh->numverts = numverts;
+    mesh->end = end;
+
+    if(numverts) {
+        mesh->vtx = (vtx_t*)Z_Malloc(sizeof(vtx_t) * numverts, PU_STATIC, 0);
+        dmemcpy(mesh->vtx, textbuild, sizeof(vtx_t) * numverts);
+    }
+}
+
+//
+// Draw_FlushFont
+//
+
+static void Draw_FlushFont(int font) {
+    const textfont_t*   f = &textfonts[font];
+    textstream_t*       stream = &textstreams[font];
+    float               scale;
+    dboolean            fill = false;
+    int                 i;
+
+    if(!stream->numverts) {
+        return;
+    }
 
     GL_SetState(GLSTATE_BLEND, 1);
 
-    if(!r_fillmode.value) {
+    if(f->fill && !r_fillmode.value) {
         dglEnable(GL_TEXTURE_2D);
         dglPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
         r_fillmode.value = 1.0f;
         fill = true;
     }
 
-    GL_BindGfxTexture("SFONT", true);
+    GL_BindGfxTexture(f->name, true);
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
 
-    GL_SetOrthoScale(scale);
+    if(f->nearest) {
+        dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+
+    // the scale is already worked into the vertices
+    scale = GL_GetOrthoScale();
+    GL_SetOrthoScale(1.0f);
     GL_SetOrtho(0);
 
-    dglSetVertex(vtxstring);
+    dglSetVertex(stream->vtx);
+
+    for(i = 0; i < stream->numverts; i += 4) {
+        if(f->reverse) {
+            dglTriangle(i + 2, i + 1, i + 0);
+            dglTriangle(i + 3, i + 2, i + 0);
+        }
+        else {
+            dglTriangle(i + 0, i + 1, i + 2);
+            dglTriangle(i + 0, i + 2, i + 3);
+        }
+    }
+
+    dglDrawGeometry(stream->numverts, stream->vtx);
+
+    if(devparm) {
+        vertCount += stream->numverts;
+    }
+
+    GL_ResetViewport();
+
+    if(fill) {
+        dglDisable(GL_TEXTURE_2D);
+        dglPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        r_fillmode.value = 0.0f;
+    }
+
+    GL_SetOrthoScale(scale);
+    GL_SetState(GLSTATE_BLEND, 0);
+
+    stream->numverts = 0;
+}
+
+//
+// Draw_FlushText
+//
+
+static void Draw_FlushText(void) {
+    int i;
+
+    for(i = 0; i < numtextorder; i++) {
+        Draw_FlushFont(textorder[i]);
+        textstreams[textorder[i]].queued = false;
+    }
+
+    numtextorder = 0;
+}
+
+//
+// Draw_AddTextMesh
+// Copies a mesh into its font's stream at x, y
+//
+
+static void Draw_AddTextMesh(textmesh_t* mesh, float x, float y, float scale, rcolor color) {
+    textstream_t*   stream = &textstreams[mesh->font];
+    vtx_t*          src;
+    vtx_t*          dst;
+    int             i;
+
+    if(mesh->numverts) {
+        if(stream->numverts + mesh->numverts > TEXTSTREAMVERTS) {
+            Draw_FlushFont(mesh->font);
+        }
+
+        if(!stream->queued) {
+            stream->queued = true;
+            textorder[numtextorder++] = mesh->font;
+        }
+
+        src = mesh->vtx;
+        dst = &stream->vtx[stream->numverts];
+
+        for(i = 0; i < mesh->numverts; i++, src++, dst++) {
+            dst->x = (src->x + x) * scale;
+            dst->y = (src->y + y) * scale;
+            dst->z = 0;
+            dst->tu = src->tu;
+            dst->tv = src->tv;
+        }
+
+        dglSetVertexColor(&stream->vtx[stream->numverts], color, mesh->numverts);
+        stream->numverts += mesh->numverts;
+    }
+
+    if(!textbatch) {
+        Draw_FlushText();
+    }
+}
+
+//
+// Draw_BeginText
+// Holds back text until Draw_EndText. Only
+// text may be drawn until then
+//
+
+void Draw_BeginText(void) {
+    textbatch++;
+}
+
+//
+// Draw_EndText
+//
+
+void Draw_EndText(void) {
+    if(textbatch > 0 && --textbatch == 0) {
+        Draw_FlushText();
+    }
+}
+
+//
+// Draw_LayoutSmallText
+// Lays out SFONT glyphs starting at x. Returns where the text ends
+//
 
-    for(i = 0, vi = 0; i < dstrlen(msg); i++, vi += 4) {
+static int Draw_LayoutSmallText(const char* msg, int x, dboolean wrap, int* numverts) {
+    int c;
+    int i;
+    int len;
+    int vi = 0;
+    int col;
+    const float size = 0.03125f;
+    float fcol, frow;
+    int start = 0;
+    int y = 0;
+    const int ix = x;
+    vtx_t* v;
+
+    len = dstrlen(msg);
+
+    for(i = 0; i < len; i++) {
         c = toupper(msg[i]);
         if(c == '\t') {
             while(x % 64) {
@@ -178,53 +451,62 @@ int Draw_Text(int x, int y, rcolor color, float scale,
             fcol = (col * size);
             frow = (start >= ST_FONTNUMSET) ? 0.5f : 0.0f;
 
-            vtxstring[vi + 0].x     = (float)x;
-            vtxstring[vi + 0].y     = (float)y;
-            vtxstring[vi + 0].tu    = fcol + 0.0015f;
-            vtxstring[vi + 0].tv    = frow + size;
-            vtxstring[vi + 1].x     = (float)x + ST_FONTWHSIZE;
-            vtxstring[vi + 1].y     = (float)y;
-            vtxstring[vi + 1].tu    = (fcol + size) - 0.0015f;
-            vtxstring[vi + 1].tv    = frow + size;
-            vtxstring[vi + 2].x     = (float)x + ST_FONTWHSIZE;
-            vtxstring[vi + 2].y     = (float)y + ST_FONTWHSIZE;
-            vtxstring[vi + 2].tu    = (fcol + size) - 0.0015f;
-            vtxstring[vi + 2].tv    = frow + 0.5f;
-            vtxstring[vi + 3].x     = (float)x;
-            vtxstring[vi + 3].y     = (float)y + ST_FONTWHSIZE;
-            vtxstring[vi + 3].tu    = fcol + 0.0015f;
-            vtxstring[vi + 3].tv    = frow + 0.5f;
-
-            dglSetVertexColor(vtxstring + vi, color, 4);
-
-            dglTriangle(vi + 0, vi + 1, vi + 2);
-            dglTriangle(vi + 0, vi + 2, vi + 3);
-
-            if(devparm) {
-                vertCount += 4;
-            }
-
-
+            v = &textbuild[vi];
+
+            v[0].x     = (float)x;
+            v[0].y     = (float)y;
+            v[0].tu    = fcol + 0.0015f;
+            v[0].tv    = frow + size;
+            v[1].x     = (float)x + ST_FONTWHSIZE;
+            v[1].y     = (float)y;
+            v[1].tu    = (fcol + size) - 0.0015f;
+            v[1].tv    = frow + size;
+            v[2].x     = (float)x + ST_FONTWHSIZE;
+            v[2].y     = (float)y + ST_FONTWHSIZE;
+            v[2].tu    = (fcol + size) - 0.0015f;
+            v[2].tv    = frow + 0.5f;
+            v[3].x     = (float)x;
+            v[3].y     = (float)y + ST_FONTWHSIZE;
+            v[3].tu    = fcol + 0.0015f;
+            v[3].tv    = frow + 0.5f;
+
+            vi += 4;
         }
         x += ST_FONTWHSIZE;
     }
 
-    if(vi) {
-        dglDrawGeometry(vi, vtxstring);
-    }
+    *numverts = vi;
+    return x;
+}
 
-    GL_ResetViewport();
+//
+// Draw_Text
+//
 
-    if(fill) {
-        dglDisable(GL_TEXTURE_2D);
-        dglPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        r_fillmode.value = 0.0f;
+int Draw_Text(int x, int y, rcolor color, float scale,
+              dboolean wrap, const char* string, ...) {
+    char        msg[MAX_MESSAGE_SIZE];
+    va_list     va;
+    textmesh_t* mesh;
+    dboolean    hit;
+    int         numverts;
+    int         end;
+
+    va_start(va, string);
+    vsprintf(msg, string, va);
+    va_end(va);
+
+    mesh = Draw_GetTextMesh(TF_SMALL, msg, x, 0, wrap, &hit);
+
+    if(!hit) {
+        end = Draw_LayoutSmallText(msg, x, wrap, &numverts);
+        Draw_SetTextMesh(mesh, msg, numverts, (float)end);
     }
 
-    GL_SetState(GLSTATE_BLEND, 0);
+    Draw_AddTextMesh(mesh, 0, (float)y, scale, color);
     GL_SetOrthoScale(1.0f);
 
-    return x;
+    return (int)mesh->end;
 }
 
 const symboldata_t symboldata[] = {  //0x5B9BC
@@ -394,13 +676,17 @@ int Center_Text(const char* string) {
 }
 
 //
-// Draw_BigText
+// Draw_LayoutBigText
+// Lays out SYMBOLS glyphs from 0, 0. Returns false if
+// the string has an unknown symbol in it
 //
 
-int Draw_BigText(int x, int y, rcolor color, const char* string) {
+static dboolean Draw_LayoutBigText(const char* string, int* numverts, int* width) {
     int c = 0;
     int i = 0;
+    int len = 0;
     int vi = 0;
+    int x = 0;
     int index = 0;
     float vx1 = 0.0f;
     float vy1 = 0.0f;
@@ -413,29 +699,18 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
     float smbwidth;
     float smbheight;
     int pic;
-
-    if(x <= -1) {
-        x = Center_Text(string);
-    }
-
-    y += 14;
+    vtx_t* v;
 
     pic = GL_BindGfxTexture("SYMBOLS", true);
 
     smbwidth = (float)gfxwidth[pic];
     smbheight = (float)gfxheight[pic];
 
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
-
-    dglSetVertex(vtxstring);
-
-    GL_SetState(GLSTATE_BLEND, 1);
-    GL_SetOrtho(0);
+    len = dstrlen(string);
 
-    for(i = 0, vi = 0; i < dstrlen(string); i++, vi += 4) {
+    for(i = 0; i < len; i++) {
         vx1 = (float)x;
-        vy1 = (float)y;
+        vy1 = 0.0f;
 
         c = string[i];
         if(c == '\n' || c == '\t') {
@@ -508,7 +783,7 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
                     index = SM_THERMO + 1;
                     break;
                 default:
-                    return 0;
+                    return false;
                 }
             }
 
@@ -521,44 +796,65 @@ int Draw_BigText(int x, int y, rcolor color, const char* string) {
             ty1 = ((float)symboldata[index].y / smbheight);
             ty2 = ty1 + (((float)symboldata[index].h / smbheight));
 
-            vtxstring[vi + 0].x     = vx1;
-            vtxstring[vi + 0].y     = vy1;
-            vtxstring[vi + 0].tu    = tx1;
-            vtxstring[vi + 0].tv    = ty2;
-            vtxstring[vi + 1].x     = vx2;
-            vtxstring[vi + 1].y     = vy1;
-            vtxstring[vi + 1].tu    = tx2;
-            vtxstring[vi + 1].tv    = ty2;
-            vtxstring[vi + 2].x     = vx2;
-            vtxstring[vi + 2].y     = vy2;
-            vtxstring[vi + 2].tu    = tx2;
-            vtxstring[vi + 2].tv    = ty1;
-            vtxstring[vi + 3].x     = vx1;
-            vtxstring[vi + 3].y     = vy2;
-            vtxstring[vi + 3].tu    = tx1;
-            vtxstring[vi + 3].tv    = ty1;
-
-            dglSetVertexColor(vtxstring + vi, color, 4);
-
-            dglTriangle(vi + 2, vi + 1, vi + 0);
-            dglTriangle(vi + 3, vi + 2, vi + 0);
-
-            if(devparm) {
-                vertCount += 4;
-            }
-
+            v = &textbuild[vi];
+
+            v[0].x     = vx1;
+            v[0].y     = vy1;
+            v[0].tu    = tx1;
+            v[0].tv    = ty2;
+            v[1].x     = vx2;
+            v[1].y     = vy1;
+            v[1].tu    = tx2;
+            v[1].tv    = ty2;
+            v[2].x     = vx2;
+            v[2].y     = vy2;
+            v[2].tu    = tx2;
+            v[2].tv    = ty1;
+            v[3].x     = vx1;
+            v[3].y     = vy2;
+            v[3].tu    = tx1;
+            v[3].tv    = ty1;
+
+            vi += 4;
             x += symboldata[index].w;
         }
     }
 
-    if(vi) {
-        dglDrawGeometry(vi, vtxstring);
+    *numverts = vi;
+    *width = x;
+
+    return true;
+}
+
+//
+// Draw_BigText
+//
+
+int Draw_BigText(int x, int y, rcolor color, const char* string) {
+    textmesh_t* mesh;
+    dboolean    hit;
+    int         numverts;
+    int         width;
+
+    if(x <= -1) {
+        x = Center_Text(string);
     }
 
-    GL_ResetViewport();
-    GL_SetState(GLSTATE_BLEND, 0);
+    y += 14;
 
-    return x;
+    mesh = Draw_GetTextMesh(TF_BIG, string, 0, 0, false, &hit);
+
+    if(!hit) {
+        if(!Draw_LayoutBigText(string, &numverts, &width)) {
+            return 0;
+        }
+
+        Draw_SetTextMesh(mesh, string, numverts, (float)width);
+    }
+
+    Draw_AddTextMesh(mesh, (float)x, (float)y, GL_GetOrthoScale(), color);
+
+    return x + (int)mesh->end;
 }
 
 //
@@ -882,58 +1178,42 @@ static const symboldata_t confontmap[256] = {
 };
 
 //
-// Draw_ConsoleText
+// Draw_LayoutConsoleText
+// Lays out CONFONT glyphs from 0, 0. Returns where the text ends
 //
 
-float Draw_ConsoleText(float x, float y, rcolor color,
-                       float scale, const char* string, ...) {
+static float Draw_LayoutConsoleText(const char* msg, float scale, int* numverts) {
     int c = 0;
     int i = 0;
+    int len = 0;
     int vi = 0;
-    float vx1 = 0.0f;
-    float vy1 = 0.0f;
+    float x = 0.0f;
     float vx2 = 0.0f;
     float vy2 = 0.0f;
     float tx1 = 0.0f;
     float tx2 = 0.0f;
     float ty1 = 0.0f;
     float ty2 = 0.0f;
-    char msg[MAX_MESSAGE_SIZE];
-    va_list    va;
     float width;
     float height;
     int pic;
-
-    va_start(va, string);
-    vsprintf(msg, string, va);
-    va_end(va);
+    vtx_t* v;
 
     pic = GL_BindGfxTexture("CONFONT", true);
 
     width = (float)gfxwidth[pic];
     height = (float)gfxheight[pic];
 
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    dglSetVertex(vtxstring);
-
-    GL_SetState(GLSTATE_BLEND, 1);
-    GL_SetOrtho(0);
-
-    for(i = 0, vi = 0; i < dstrlen(msg); i++, vi += 4) {
-        vx1 = x;
-        vy1 = y;
+    len = dstrlen(msg);
 
+    for(i = 0; i < len; i++) {
         c = msg[i];
         if(c == '\n' || c == '\t') {
             continue;    // villsa: safety check
         }
         else {
-            vx2 = vx1 + ((float)confontmap[c].w * scale);
-            vy2 = vy1 - ((float)confontmap[c].h * scale);
+            vx2 = x + ((float)confontmap[c].w * scale);
+            vy2 = -((float)confontmap[c].h * scale);
 
             tx1 = ((float)confontmap[c].x / width) + 0.001f;
             tx2 = (tx1 + (float)confontmap[c].w / width) - 0.002f;
@@ -941,43 +1221,61 @@ float Draw_ConsoleText(float x, float y, rcolor color,
             ty1 = ((float)confontmap[c].y / height);
             ty2 = ty1 + (((float)confontmap[c].h / height));
 
-            vtxstring[vi + 0].x     = vx1;
-            vtxstring[vi + 0].y     = vy1;
-            vtxstring[vi + 0].tu    = tx1;
-            vtxstring[vi + 0].tv    = ty2;
-            vtxstring[vi + 1].x     = vx2;
-            vtxstring[vi + 1].y     = vy1;
-            vtxstring[vi + 1].tu    = tx2;
-            vtxstring[vi + 1].tv    = ty2;
-            vtxstring[vi + 2].x     = vx2;
-            vtxstring[vi + 2].y     = vy2;
-            vtxstring[vi + 2].tu    = tx2;
-            vtxstring[vi + 2].tv    = ty1;
-            vtxstring[vi + 3].x     = vx1;
-            vtxstring[vi + 3].y     = vy2;
-            vtxstring[vi + 3].tu    = tx1;
-            vtxstring[vi + 3].tv    = ty1;
-
-            dglSetVertexColor(vtxstring + vi, color, 4);
-
-            dglTriangle(vi + 2, vi + 1, vi + 0);
-            dglTriangle(vi + 3, vi + 2, vi + 0);
-
-            if(devparm) {
-                vertCount += 4;
-            }
-
+            v = &textbuild[vi];
+
+            v[0].x     = x;
+            v[0].y     = 0.0f;
+            v[0].tu    = tx1;
+            v[0].tv    = ty2;
+            v[1].x     = vx2;
+            v[1].y     = 0.0f;
+            v[1].tu    = tx2;
+            v[1].tv    = ty2;
+            v[2].x     = vx2;
+            v[2].y     = vy2;
+            v[2].tu    = tx2;
+            v[2].tv    = ty1;
+            v[3].x     = x;
+            v[3].y     = vy2;
+            v[3].tu    = tx1;
+            v[3].tv    = ty1;
+
+            vi += 4;
             x += ((float)confontmap[c].w * scale);
         }
     }
 
-    if(vi) {
-        dglDrawGeometry(vi, vtxstring);
+    *numverts = vi;
+
+    return x;
+}
+
+//
+// Draw_ConsoleText
+//
+
+float Draw_ConsoleText(float x, float y, rcolor color,
+                       float scale, const char* string, ...) {
+    char        msg[MAX_MESSAGE_SIZE];
+    va_list     va;
+    textmesh_t* mesh;
+    dboolean    hit;
+    int         numverts;
+    float       end;
+
+    va_start(va, string);
+    vsprintf(msg, string, va);
+    va_end(va);
+
+    mesh = Draw_GetTextMesh(TF_CONSOLE, msg, 0, scale, false, &hit);
+
+    if(!hit) {
+        end = Draw_LayoutConsoleText(msg, scale, &numverts);
+        Draw_SetTextMesh(mesh, msg, numverts, end);
     }
 
-    GL_ResetViewport();
-    GL_SetState(GLSTATE_BLEND, 0);
+    Draw_AddTextMesh(mesh, x, y, GL_GetOrthoScale(), color);
 
-    return x;
+    return x + mesh->end;
 }
 
@@ -60,6 +60,11 @@ int Draw_BigText(int x, int y, rcolor color, const char* string);
 void Draw_Number(int x, int y, int num, int type, rcolor c);
 float Draw_ConsoleText(float x, float y, rcolor color,
                        float scale, const char* string, ...);
+void Draw_BeginText(void);
+void Draw_EndText(void);
+
+extern int textHits;
+extern int textMisses;
 
 #endif
 
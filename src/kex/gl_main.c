@@ -159,7 +159,14 @@ dboolean GL_CheckExtension(const char *ext) {
 //
 
 void* GL_RegisterProc(const char *address) {
-    void *proc = SDL_GL_GetProcAddress(address);
+    void *proc;
+
+    // nothing to get them from
+    if(dglrecording) {
+        return NULL;
+    }
+
+    proc = SDL_GL_GetProcAddress(address);
 
     if(!proc) {
         CON_Warnf("GL_RegisterProc: Failed to get proc address: %s", address);
@@ -248,6 +255,11 @@ float GL_GetOrthoScale(void) {
 //
 
 void GL_SwapBuffers(void) {
+    if(dglrecording) {
+        DGL_RecFrame();
+        return;
+    }
+
     SDL_GL_SwapBuffers();
 }
 
@@ -613,7 +625,19 @@ void GL_Init(void) {
         flags |= SDL_FULLSCREEN;
     }
 
-    if(SDL_SetVideoMode(video_width, video_height, SDL_BPP, flags) == NULL) {
+    if(dglrecording) {
+#ifdef USE_DEBUG_GLFUNCS
+        I_Error("GL_Init: -nullgl and -glrecord can't be used with USE_DEBUG_GLFUNCS");
+#endif
+        // no GL context, but the rest of the
+        // game still expects a video surface
+        if(SDL_SetVideoMode(video_width, video_height, 0, SDL_SWSURFACE) == NULL) {
+            I_Error("GL_Init: Failed to set video mode");
+        }
+
+        DGL_RecInit();
+    }
+    else if(SDL_SetVideoMode(video_width, video_height, SDL_BPP, flags) == NULL) {
         // re-adjust depth size if video can't run it
         if(v_depthsize.value >= 24) {
             CON_CvarSetValue(v_depthsize.name, 16);
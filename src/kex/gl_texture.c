@@ -36,6 +36,8 @@
 #include "p_local.h"
 #include "con_console.h"
 #include "g_actions.h"
+#include "i_thread.h"
+#include "d_prof.h"
 
 #define GL_MAX_TEX_UNITS    4
 
@@ -139,7 +141,6 @@ static void InitWorldTextures(void) {
     textureheight       = Z_Calloc(numtextures * sizeof(word), PU_STATIC, NULL);
 
     for(i = 0; i < numtextures; i++) {
-        byte* png;
         int w;
         int h;
 
@@ -154,19 +155,38 @@ static void InitWorldTextures(void) {
         texturetranslation[i] = i;
         palettetranslation[i] = 0;
 
-        // read PNG and setup global width and heights
-        png = I_PNGReadData(t_start + i, true, true, false, &w, &h, NULL, 0);
+        // read PNG header and setup global width and heights
+        I_PNGReadInfo(t_start + i, &w, &h, NULL);
 
         textureptr[i][0] = 0;
         texturewidth[i] = w;
         textureheight[i] = h;
-
-        Z_Free(png);
     }
 
     CON_DPrintf("%i world textures initialized\n", numtextures);
 }
 
+//
+// GL_UploadWorldTexture
+// Creates and binds the video ram copy of a decoded world texture
+//
+
+static void GL_UploadWorldTexture(int texnum, int pal, byte* png, int w, int h) {
+    dglGenTextures(1, &textureptr[texnum][pal]);
+    dglBindTexture(GL_TEXTURE_2D, textureptr[texnum][pal]);
+    dglTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, png);
+
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    GL_CheckFillMode();
+    GL_SetTextureFilter();
+
+    // update global width and heights
+    texturewidth[texnum] = w;
+    textureheight[texnum] = h;
+}
+
 //
 // GL_BindWorldTexture
 //
@@ -207,23 +227,13 @@ void GL_BindWorldTexture(int texnum, int *width, int *height) {
         return;
     }
 
+    PROF_BEGIN(PROF_TEXTUREMISS);
+
     // create a new texture
     png = I_PNGReadData(t_start + texnum, false, true, true,
                         &w, &h, NULL, palettetranslation[texnum]);
 
-    dglGenTextures(1, &textureptr[texnum][palettetranslation[texnum]]);
-    dglBindTexture(GL_TEXTURE_2D, textureptr[texnum][palettetranslation[texnum]]);
-    dglTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, png);
-
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    GL_CheckFillMode();
-    GL_SetTextureFilter();
-
-    // update global width and heights
-    texturewidth[texnum] = w;
-    textureheight[texnum] = h;
+    GL_UploadWorldTexture(texnum, palettetranslation[texnum], png, w, h);
 
     if(width) {
         *width = texturewidth[texnum];
@@ -234,6 +244,8 @@ void GL_BindWorldTexture(int texnum, int *width, int *height) {
 
     Z_Free(png);
 
+    PROF_END(PROF_TEXTUREMISS);
+
     if(devparm) {
         glBindCalls++;
     }
@@ -334,19 +346,16 @@ static void InitGfxTextures(void) {
     gfxorigheight   = Z_Calloc(numgfx * sizeof(short), PU_STATIC, NULL);
 
     for(i = 0; i < numgfx; i++) {
-        byte* png;
         int w;
         int h;
 
-        png = I_PNGReadData(g_start + i, true, true, false, &w, &h, NULL, 0);
+        I_PNGReadInfo(g_start + i, &w, &h, NULL);
 
         gfxptr[i] = 0;
         gfxwidth[i] = w;
         gfxorigwidth[i] = w;
         gfxorigheight[i] = h;
         gfxheight[i] = h;
-
-        Z_Free(png);
     }
 
     CON_DPrintf("%i generic textures initialized\n", numgfx);
@@ -384,6 +393,8 @@ int GL_BindGfxTexture(const char* name, dboolean alpha) {
         return gfxid;
     }
 
+    PROF_BEGIN(PROF_TEXTUREMISS);
+
     png = I_PNGReadData(lump, false, true, alpha, &width, &height, NULL, 0);
 
     // check for non-power of two textures
@@ -406,6 +417,8 @@ int GL_BindGfxTexture(const char* name, dboolean alpha) {
     gfxwidth[gfxid] = width;
     gfxheight[gfxid] = height;
 
+    PROF_END(PROF_TEXTUREMISS);
+
     if(devparm) {
         glBindCalls++;
     }
@@ -463,7 +476,6 @@ static void InitSpriteTextures(void) {
     CON_DPrintf("%i external palettes initialized\n", palcnt);
 
     for(i = 0; i < numsprtex; i++) {
-        byte* png;
         int w;
         int h;
         size_t x;
@@ -476,16 +488,37 @@ static void InitSpriteTextures(void) {
             spriteptr[i][x] = 0;
         }
 
-        // read data and setup globals
-        png = I_PNGReadData(s_start + i, true, true, false, &w, &h, offset, 0);
+        // read header and setup globals
+        I_PNGReadInfo(s_start + i, &w, &h, offset);
 
         spritewidth[i]      = w;
         spriteheight[i]     = h;
         spriteoffset[i]     = (float)offset[0];
         spritetopoffset[i]  = (float)offset[1];
+    }
+}
+
+//
+// GL_UploadSpriteTexture
+// Creates and binds the video ram copy of a decoded sprite
+//
 
-        Z_Free(png);
+static void GL_UploadSpriteTexture(int spritenum, int pal, byte* png, int w, int h) {
+    // check for non-power of two textures
+    if(!has_GL_ARB_texture_non_power_of_two && r_texnonpowresize.value <= 0) {
+        CON_CvarSetValue(r_texnonpowresize.name, 1.0f);
     }
+
+    dglGenTextures(1, &spriteptr[spritenum][pal]);
+    dglBindTexture(GL_TEXTURE_2D, spriteptr[spritenum][pal]);
+
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
+    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
+
+    SetTextureImage(png, 4, &w, &h, GL_RGBA8, GL_RGBA);
+
+    spritewidth[spritenum] = w;
+    spriteheight[spritenum] = h;
 }
 
 //
@@ -494,7 +527,6 @@ static void InitSpriteTextures(void) {
 
 void GL_BindSpriteTexture(int spritenum, int pal) {
     byte* png;
-    dboolean npot;
     int w;
     int h;
 
@@ -525,30 +557,189 @@ void GL_BindSpriteTexture(int spritenum, int pal) {
         return;
     }
 
+    PROF_BEGIN(PROF_TEXTUREMISS);
+
     png = I_PNGReadData(s_start + spritenum, false, true, true, &w, &h, NULL, pal);
 
-    // check for non-power of two textures
-    npot = has_GL_ARB_texture_non_power_of_two;
+    GL_UploadSpriteTexture(spritenum, pal, png, w, h);
+    Z_Free(png);
 
-    if(!npot && r_texnonpowresize.value <= 0) {
-        CON_CvarSetValue(r_texnonpowresize.name, 1.0f);
+    PROF_END(PROF_TEXTUREMISS);
+
+    if(devparm) {
+        glBindCalls++;
     }
+}
 
-    dglGenTextures(1, &spriteptr[spritenum][pal]);
-    dglBindTexture(GL_TEXTURE_2D, spriteptr[spritenum][pal]);
+//
+// TEXTURE PRECACHING
+//
+// Level textures are decoded on the worker threads and handed back
+// to the main thread for upload as they finish. Decoded but not yet
+// uploaded images are capped at PRECACHE_BUDGET bytes.
+//
 
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, DGL_CLAMP);
-    dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, DGL_CLAMP);
+#define PRECACHE_BUDGET     (32 << 20)
 
-    SetTextureImage(png, 4, &w, &h, GL_RGBA8, GL_RGBA);
-    Z_Free(png);
+enum {
+    TD_WORLD,
+    TD_SPRITE
+};
 
-    spritewidth[spritenum] = w;
-    spriteheight[spritenum] = h;
+typedef struct {
+    pngdecode_t dec;
+    int         type;
+    int         num;
+    int         pal;
+    int         size;
+} texdecode_t;
+
+static jobgroup_t*  precachejobs = NULL;
+static byte*        precacheworld;
+static byte*        precachesprite;
+static int          precachebytes;
+
+//
+// GL_DecodeTextureJob
+//
+
+static void GL_DecodeTextureJob(void *data) {
+    I_PNGDecode(&((texdecode_t*)data)->dec);
+}
+
+//
+// GL_UploadNextDecode
+// Waits for a decode and uploads it. Returns false when none are left
+//
+
+static dboolean GL_UploadNextDecode(void) {
+    texdecode_t* td;
+
+    if(!(td = (texdecode_t*)I_WaitAnyJob(precachejobs))) {
+        return false;
+    }
+
+    I_PNGFinishDecode(&td->dec);
+
+    if(td->type == TD_WORLD) {
+        GL_UploadWorldTexture(td->num, td->pal, td->dec.out, td->dec.width, td->dec.height);
+    }
+    else {
+        GL_UploadSpriteTexture(td->num, td->pal, td->dec.out, td->dec.width, td->dec.height);
+    }
 
     if(devparm) {
         glBindCalls++;
     }
+
+    precachebytes -= td->size;
+
+    free(td->dec.out);
+    free(td);
+
+    return true;
+}
+
+//
+// GL_QueueTextureDecode
+//
+
+static void GL_QueueTextureDecode(int type, int num, int pal, int lump, int size) {
+    texdecode_t* td;
+
+    // drain finished images before going over budget
+    while(precachebytes > 0 && precachebytes + size > PRECACHE_BUDGET) {
+        if(!GL_UploadNextDecode()) {
+            break;
+        }
+    }
+
+    if(!(td = (texdecode_t*)malloc(sizeof(texdecode_t)))) {
+        I_Error("GL_QueueTextureDecode: out of memory");
+    }
+
+    I_PNGSetupDecode(&td->dec, lump, false, true, true, pal);
+    td->dec.threaded = true;
+    td->type = type;
+    td->num = num;
+    td->pal = pal;
+    td->size = size;
+
+    precachebytes += size;
+
+    I_QueueJob(precachejobs, GL_DecodeTextureJob, td);
+}
+
+//
+// GL_BeginTexturePrecache
+//
+
+void GL_BeginTexturePrecache(void) {
+    precachejobs = I_CreateJobGroup();
+    precacheworld = (byte*)Z_Calloc(numtextures, PU_STATIC, 0);
+    precachesprite = (byte*)Z_Calloc(numsprtex, PU_STATIC, 0);
+    precachebytes = 0;
+}
+
+//
+// GL_PrecacheWorldTexture
+//
+
+void GL_PrecacheWorldTexture(int texnum) {
+    int pal;
+
+    if(r_fillmode.value <= 0) {
+        return;
+    }
+
+    texnum = texturetranslation[texnum];
+    pal = palettetranslation[texnum];
+
+    if(textureptr[texnum][pal] || precacheworld[texnum]) {
+        return;
+    }
+
+    precacheworld[texnum] = true;
+
+    GL_QueueTextureDecode(TD_WORLD, texnum, pal, t_start + texnum,
+                          texturewidth[texnum] * textureheight[texnum] * 4);
+}
+
+//
+// GL_PrecacheSpriteTexture
+//
+
+void GL_PrecacheSpriteTexture(int spritenum) {
+    if(r_fillmode.value <= 0) {
+        return;
+    }
+
+    if(spriteptr[spritenum][0] || precachesprite[spritenum]) {
+        return;
+    }
+
+    precachesprite[spritenum] = true;
+
+    GL_QueueTextureDecode(TD_SPRITE, spritenum, 0, s_start + spritenum,
+                          spritewidth[spritenum] * spriteheight[spritenum] * 4);
+}
+
+//
+// GL_FinishTexturePrecache
+// Uploads everything still in flight
+//
+
+void GL_FinishTexturePrecache(void) {
+    while(GL_UploadNextDecode());
+
+    I_DestroyJobGroup(precachejobs);
+    precachejobs = NULL;
+
+    Z_Free(precacheworld);
+    Z_Free(precachesprite);
+
+    // the uploads left other textures bound
+    GL_ResetTextures();
 }
 
 //
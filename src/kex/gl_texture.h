@@ -71,6 +71,10 @@ void        GL_SetCombineOperandRGB(int operand, int target);
 void        GL_SetCombineOperandAlpha(int operand, int target);
 void        GL_BindWorldTexture(int texnum, int *width, int *height);
 void        GL_BindSpriteTexture(int spritenum, int pal);
+void        GL_BeginTexturePrecache(void);
+void        GL_PrecacheWorldTexture(int texnum);
+void        GL_PrecacheSpriteTexture(int spritenum);
+void        GL_FinishTexturePrecache(void);
 int         GL_BindGfxTexture(const char* name, dboolean alpha);
 int         GL_PadTextureDims(int size);
 void        GL_SetNewPalette(int id, byte palID);
@@ -1062,7 +1062,7 @@ static dboolean Seq_RegisterSongs(doomseq_t* seq) {
         song_t* song;
 
         song = &seq->songs[i];
-        song->data = W_CacheLumpNum(start + i, PU_STATIC);
+        song->data = W_LumpView(start + i);
         song->length = W_LumpLength(start + i);
 
         if(!song->length) {
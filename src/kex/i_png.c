@@ -37,9 +37,9 @@
 #include "gl_texture.h"
 #include "con_console.h"
 #include "i_png.h"
+#include "d_prof.h"
 
 static byte*    pngWriteData;
-static byte*    pngReadData;
 static size_t   pngWritePos = 0;
 
 CVAR_CMD(i_gamma, 0) {
@@ -64,8 +64,10 @@ d_inline static size_t I_PNGRowSize(int width, byte bits) {
 //
 
 static void I_PNGReadFunc(png_structp ctx, byte* area, size_t size) {
-    dmemcpy(area, pngReadData, size);
-    pngReadData += size;
+    byte** readpos = (byte**)png_get_io_ptr(ctx);
+
+    dmemcpy(area, *readpos, size);
+    *readpos += size;
 }
 
 //
@@ -109,11 +111,63 @@ static void I_TranslatePalette(png_colorp dest) {
 }
 
 //
-// I_PNGReadData
+// I_PNGSetupDecode
+// Gets the lump data (and external palette) ready for I_PNGDecode.
+// Must be called from the main thread
 //
 
-byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
-                    int* w, int* h, int* offset, int palindex) {
+void I_PNGSetupDecode(pngdecode_t* dec, int lump, dboolean palette, dboolean nopack,
+                      dboolean alpha, int palindex) {
+    dmemset(dec, 0, sizeof(pngdecode_t));
+
+    dec->lump = lump;
+    dec->data = (byte*)W_LumpView(lump);
+    dec->palette = palette;
+    dec->nopack = nopack;
+    dec->alpha = alpha;
+    dec->palindex = palindex;
+
+    if(palindex) {
+        char palname[9];
+        int pallump;
+        int size;
+
+        sprintf(palname, "PAL");
+        dstrncpy(palname + 3, lumpinfo[lump].name, 4);
+        sprintf(palname + 7, "%i", palindex);
+
+        // copied out, other decodes in flight may share the lump
+        if((pallump = W_CheckNumForName(palname)) != -1) {
+            size = MIN(W_LumpLength(pallump), (int)sizeof(dec->paldata));
+
+            dmemcpy(dec->paldata, W_LumpView(pallump), size);
+            W_ReleaseLumpView(pallump);
+            dec->haspal = true;
+        }
+    }
+}
+
+//
+// I_PNGFail
+//
+
+static void I_PNGFail(pngdecode_t* dec, const char* msg) {
+    if(dec->threaded) {
+        dec->error = msg;
+        return;
+    }
+
+    I_Error("I_PNGReadData: %s (%s)", msg, lumpinfo[dec->lump].name);
+}
+
+//
+// I_PNGDecode
+// Decodes a lump set up by I_PNGSetupDecode. With dec->threaded set
+// this can run on a worker thread: the output is malloc'd instead of
+// zone allocated and errors are left in dec->error
+//
+
+void I_PNGDecode(pngdecode_t* dec) {
     png_structp png_ptr;
     png_infop   info_ptr;
     png_uint_32 width;
@@ -122,47 +176,51 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
     int         color_type;
     int         interlace_type;
     int         pixel_depth;
-    byte*       png;
+    byte*       readpos;
     byte*       out;
     size_t      row;
     size_t      rowSize;
-    byte**      row_pointers;
+    byte** volatile row_pointers = NULL;
 
-    // get lump data
-    png = W_CacheLumpNum(lump, PU_STATIC);
-    pngReadData = png;
+    readpos = dec->data;
+    dec->out = NULL;
 
     // setup struct
     png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
     if(png_ptr == NULL) {
-        I_Error("I_PNGReadData: Failed to read struct");
-        return NULL;
+        I_PNGFail(dec, "Failed to read struct");
+        return;
     }
 
     // setup info struct
     info_ptr = png_create_info_struct(png_ptr);
     if(info_ptr == NULL) {
         png_destroy_read_struct(&png_ptr, NULL, NULL);
-        I_Error("I_PNGReadData: Failed to create info struct");
-        return NULL;
+        I_PNGFail(dec, "Failed to create info struct");
+        return;
     }
 
     if(setjmp(png_jmpbuf(png_ptr))) {
         png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-        I_Error("I_PNGReadData: Failed on setjmp");
-        return NULL;
+        free(row_pointers);
+
+        if(dec->out && dec->threaded) {
+            free(dec->out);
+            dec->out = NULL;
+        }
+
+        I_PNGFail(dec, "Failed on setjmp");
+        return;
     }
 
     // setup callback function for reading data
-    png_set_read_fn(png_ptr, NULL, I_PNGReadFunc);
+    png_set_read_fn(png_ptr, &readpos, I_PNGReadFunc);
 
-    // look for offset chunk if specified
-    if(offset) {
-        offset[0] = 0;
-        offset[1] = 0;
+    // look for offset chunk
+    dec->offset[0] = 0;
+    dec->offset[1] = 0;
 
-        png_set_read_user_chunk_fn(png_ptr, offset, I_PNGFindChunk);
-    }
+    png_set_read_user_chunk_fn(png_ptr, dec->offset, I_PNGFindChunk);
 
     // read png information
     png_read_info(png_ptr, info_ptr);
@@ -179,19 +237,21 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
         NULL,
         NULL);
 
-    if(usingGL && !alpha) {
+    if(usingGL && !dec->alpha) {
         int num_trans = 0;
         png_get_tRNS(png_ptr, info_ptr, NULL, &num_trans, NULL);
         if(num_trans)
             //if(usingGL && !alpha && info_ptr->num_trans)
         {
-            I_Error("I_PNGReadData: RGB8 PNG image (%s) has transparency", lumpinfo[lump].name);
+            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+            I_PNGFail(dec, "RGB8 PNG image has transparency");
+            return;
         }
     }
 
     // if the data will be outputted as palette index data (non RGB(A))
-    if(palette) {
-        if(bit_depth == 4 && nopack) {
+    if(dec->palette) {
+        if(bit_depth == 4 && dec->nopack) {
             png_set_packing(png_ptr);
         }
     }
@@ -206,24 +266,17 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
             int num_pal = 0;
             png_get_PLTE(png_ptr, info_ptr, &pal, &num_pal);  // FIXME: num_pal not used??
 
-            if(palindex) {
+            if(dec->palindex) {
                 // palindex specifies each row (16 colors per row) in the palette for 4 bit color textures
                 if(bit_depth == 4) {
                     for(i = 0; i < 16; i++) {
-                        dmemcpy(&pal[i], &pal[(16 * palindex) + i], sizeof(png_color));
+                        dmemcpy(&pal[i], &pal[(16 * dec->palindex) + i], sizeof(png_color));
                     }
                 }
                 else if(bit_depth >= 8) {  // 8 bit and up requires an external palette lump
-                    png_colorp pallump;
-                    char palname[9];
-
-                    sprintf(palname, "PAL");
-                    dstrncpy(palname + 3, lumpinfo[lump].name, 4);
-                    sprintf(palname + 7, "%i", palindex);
-
                     // villsa 12/04/13: don't abort if external palette is not found
-                    if(W_CheckNumForName(palname) != -1) {
-                        pallump = W_CacheLumpName(palname, PU_STATIC);
+                    if(dec->haspal) {
+                        png_colorp pallump = dec->paldata;
 
                         // swap out current palette with the new one
                         for(i = 0; i < 256; i++) {
@@ -231,15 +284,13 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
                             pal[i].green = pallump[i].green;
                             pal[i].blue = pallump[i].blue;
                         }
-
-                        Z_Free(pallump);
                     }
                     // villsa 12/04/13: if we're loading texture palette as normal
                     // but palindex is not zero, then just copy out a single row from the
                     // palette in case world textures have a 8-32 bit depth color table
                     else {
                         for(i = 0; i < 16; i++) {
-                            dmemcpy(&pal[i], &pal[(16 * palindex) + i], sizeof(png_color));
+                            dmemcpy(&pal[i], &pal[(16 * dec->palindex) + i], sizeof(png_color));
                         }
                     }
                 }
@@ -249,7 +300,7 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
             png_set_palette_to_rgb(png_ptr);
         }
 
-        if(alpha) {
+        if(dec->alpha) {
             // add alpha values to the RGB data
             png_set_swap_alpha(png_ptr);
             png_set_add_alpha(png_ptr, 0xff, 0);
@@ -283,16 +334,29 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
 
     rowSize = I_PNGRowSize(width, pixel_depth /*info_ptr->pixel_depth*/);
 
-    if(w) {
-        *w = width;
+    dec->width = width;
+    dec->height = height;
+
+    // allocate output and row pointers
+    if(dec->threaded) {
+        out = (byte*)calloc(rowSize * height, 1);
+
+        if(out == NULL) {
+            png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+            I_PNGFail(dec, "Out of memory");
+            return;
+        }
     }
-    if(h) {
-        *h = height;
+    else {
+        out = (byte*)Z_Calloc(rowSize * height, PU_STATIC, 0);
     }
 
-    // allocate output and row pointers
-    out = (byte*)Z_Calloc(rowSize * height, PU_STATIC, 0);
-    row_pointers = (byte**)Z_Malloc(sizeof(byte*)*height, PU_STATIC, 0);
+    dec->out = out;
+    row_pointers = (byte**)malloc(sizeof(byte*)*height);
+
+    if(row_pointers == NULL) {
+        png_error(png_ptr, "Out of memory");
+    }
 
     for(row = 0; row < height; row++) {
         row_pointers[row] = out + (row * rowSize);
@@ -301,7 +365,7 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
     png_read_image(png_ptr, row_pointers);
     png_read_end(png_ptr, info_ptr);
 
-    if(alpha) {
+    if(dec->alpha) {
         size_t i;
         int* check = (int*)out;
 
@@ -321,11 +385,182 @@ byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
     }
 
     //cleanup
-    Z_Free(row_pointers);
-    Z_Free(png);
+    free(row_pointers);
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+}
 
-    return out;
+//
+// I_PNGFinishDecode
+// Releases the lump data and reports errors from a threaded decode.
+// Must be called from the main thread
+//
+
+void I_PNGFinishDecode(pngdecode_t* dec) {
+    W_ReleaseLumpView(dec->lump);
+
+    dec->data = NULL;
+
+    if(dec->error) {
+        I_Error("I_PNGReadData: %s (%s)", dec->error, lumpinfo[dec->lump].name);
+    }
+}
+
+//
+// I_PNGReadData
+//
+
+byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
+                    int* w, int* h, int* offset, int palindex) {
+    pngdecode_t dec;
+
+    PROF_BEGIN(PROF_PNGREAD);
+
+    I_PNGSetupDecode(&dec, lump, palette, nopack, alpha, palindex);
+    I_PNGDecode(&dec);
+    I_PNGFinishDecode(&dec);
+
+    PROF_END(PROF_PNGREAD);
+
+    if(w) {
+        *w = dec.width;
+    }
+    if(h) {
+        *h = dec.height;
+    }
+    if(offset) {
+        offset[0] = dec.offset[0];
+        offset[1] = dec.offset[1];
+    }
+
+    return dec.out;
+}
+
+//
+// PNG HEADER INDEX
+//
+// The texture setup only needs the dimensions and grAb offsets of each
+// image, which sit in front of the compressed data. They're pulled out
+// of the chunk headers directly and kept per lump for the session.
+//
+
+typedef struct {
+    int     width;
+    int     height;
+    int     offset[2];
+    byte    scanned;
+} pnginfo_t;
+
+static pnginfo_t* pnginfo = NULL;
+static int numpnginfo = 0;
+
+//
+// I_PNGReadInt
+// Unaligned big endian read
+//
+
+d_inline static int I_PNGReadInt(const byte* data) {
+    int val;
+
+    dmemcpy(&val, data, 4);
+    return I_SwapBE32(val);
+}
+
+//
+// I_PNGScanInfo
+//
+
+static void I_PNGScanInfo(int lump, pnginfo_t* info) {
+    byte* data;
+    int length;
+    int pos;
+    dboolean ihdr = false;
+
+    data = (byte*)W_LumpView(lump);
+    length = W_LumpLength(lump);
+
+    if(length < 8 || png_sig_cmp(data, 0, 8)) {
+        I_Error("I_PNGReadInfo: %s is not a PNG image", lumpinfo[lump].name);
+    }
+
+    info->offset[0] = 0;
+    info->offset[1] = 0;
+
+    //
+    // walk the chunks until the image data starts; libpng won't see
+    // a grAb chunk placed after IDAT either
+    //
+    for(pos = 8; pos + 8 <= length;) {
+        int size = I_PNGReadInt(data + pos);
+        byte* chunk = data + pos + 4;
+
+        if(size < 0 || pos + 12 + size > length) {
+            break;
+        }
+
+        if(!dstrncmp((char*)chunk, "IHDR", 4) && size >= 8) {
+            info->width = I_PNGReadInt(chunk + 4);
+            info->height = I_PNGReadInt(chunk + 8);
+            ihdr = true;
+        }
+        else if(!dstrncmp((char*)chunk, "grAb", 4) && size >= 8) {
+            info->offset[0] = I_PNGReadInt(chunk + 4);
+            info->offset[1] = I_PNGReadInt(chunk + 8);
+        }
+        else if(!dstrncmp((char*)chunk, "IDAT", 4) ||
+                !dstrncmp((char*)chunk, "IEND", 4)) {
+            break;
+        }
+
+        pos += 12 + size;
+    }
+
+    W_ReleaseLumpView(lump);
+
+    if(!ihdr) {
+        I_Error("I_PNGReadInfo: %s has no IHDR chunk", lumpinfo[lump].name);
+    }
+
+    info->scanned = true;
+}
+
+//
+// I_PNGReadInfo
+// Gets the size and grAb offsets of a PNG lump without decoding it
+//
+
+void I_PNGReadInfo(int lump, int* w, int* h, int* offset) {
+    pnginfo_t* info;
+
+    if(lump < 0 || lump >= numlumps) {
+        I_Error("I_PNGReadInfo: lump %i out of range", lump);
+    }
+
+    if(numpnginfo != numlumps) {
+        pnginfo = (pnginfo_t*)Z_Realloc(pnginfo, numlumps * sizeof(pnginfo_t), PU_STATIC, 0);
+
+        if(numlumps > numpnginfo) {
+            dmemset(pnginfo + numpnginfo, 0, (numlumps - numpnginfo) * sizeof(pnginfo_t));
+        }
+
+        numpnginfo = numlumps;
+    }
+
+    info = &pnginfo[lump];
+
+    if(!info->scanned) {
+        I_PNGScanInfo(lump, info);
+    }
+
+    if(w) {
+        *w = info->width;
+    }
+    if(h) {
+        *h = info->height;
+    }
+    if(offset) {
+        offset[0] = info->offset[0];
+        offset[1] = info->offset[1];
+    }
 }
 
 //
@@ -26,9 +26,36 @@
 #include "png.h"
 #include "doomtype.h"
 
+//
+// Decode state, for decoding lumps off the main thread
+//
+
+typedef struct {
+    int         lump;
+    byte*       data;
+    dboolean    haspal;         // paldata holds an external palette
+    png_color   paldata[256];
+    dboolean    palette;
+    dboolean    nopack;
+    dboolean    alpha;
+    int         palindex;
+    dboolean    threaded;
+    byte*       out;
+    int         width;
+    int         height;
+    int         offset[2];
+    const char* error;
+} pngdecode_t;
+
+void I_PNGSetupDecode(pngdecode_t* dec, int lump, dboolean palette, dboolean nopack,
+                      dboolean alpha, int palindex);
+void I_PNGDecode(pngdecode_t* dec);
+void I_PNGFinishDecode(pngdecode_t* dec);
+
 byte* I_PNGReadData(int lump, dboolean palette, dboolean nopack, dboolean alpha,
                     int* w, int* h, int* offset, int palindex);
 
+void I_PNGReadInfo(int lump, int* w, int* h, int* offset);
 byte* I_PNGCreate(int width, int height, byte* data, int* size);
 
 #endif // __I_PNG_H__
\ No newline at end of file
@@ -31,6 +31,9 @@
 #ifdef _WIN32
 #include <direct.h>
 #include <io.h>
+#else
+#include <time.h>
+#include <sys/time.h>
 #endif
 
 #include <stdarg.h>
@@ -46,6 +49,8 @@
 #include "i_system.h"
 #include "i_audio.h"
 #include "gl_draw.h"
+#include "i_thread.h"
+#include "p_saveg.h"
 
 #ifdef _WIN32
 #include "i_xinput.h"
@@ -464,6 +469,40 @@ int I_GetTimeMS(void) {
     return ticks - basetime;
 }
 
+//
+// I_GetTimeUS
+//
+// High resolution clock in microseconds. Only meant for measuring
+// elapsed time (benchmarks, timedemo), not for game timing
+//
+
+uint64 I_GetTimeUS(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if(!freq.QuadPart) {
+        QueryPerformanceFrequency(&freq);
+    }
+
+    QueryPerformanceCounter(&now);
+
+    // split to avoid overflowing on long uptimes
+    return (uint64)(now.QuadPart / freq.QuadPart) * 1000000 +
+           (uint64)(now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
 //
 // I_GetRandomTimeSeed
 //
@@ -482,8 +521,16 @@ void I_Init(void) {
     //I_SpawnLauncher(hwndMain);
 #endif
 
-    I_InitVideo();
+    if(nodrawers) {
+        // headless; no window, but the timer is still needed
+        SDL_Init(0);
+    }
+    else {
+        I_InitVideo();
+    }
+
     I_InitClockRate();
+    I_InitThreads();
 }
 
 //
@@ -506,7 +553,7 @@ void I_Error(char* string, ...) {
     I_Printf("\n********* ERROR *********\n");
     I_Printf(buff);
 
-    if(usingGL) {
+    if(usingGL && !dglrecording) {
         while(1) {
             GL_ClearView(0xFF000000);
             Draw_Text(0, 0, WHITE, 1, 1, "Error - %s\n", buff);
@@ -551,13 +598,22 @@ void I_Quit(void) {
         G_CheckDemoStatus();
     }
 
+    G_DemoHashShutdown();
+
+    P_FinishSaveGame();
     M_SaveDefaults();
 
 #ifdef USESYSCONSOLE
     I_DestroySysConsole();
 #endif
 
+    I_ShutdownThreads();
     I_ShutdownSound();
+
+    if(dglrecording) {
+        DGL_RecShutdown();
+    }
+
     I_ShutdownVideo();
 
     exit(0);
@@ -56,6 +56,7 @@ extern fixed_t rendertic_frac;
 extern int (*I_GetTime)(void);
 void            I_InitClockRate(void);
 int             I_GetTimeMS(void);
+uint64          I_GetTimeUS(void);
 void            I_Sleep(unsigned long usecs);
 dboolean        I_StartDisplay(void);
 void            I_EndDisplay(void);
@@ -0,0 +1,385 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+//
+// DESCRIPTION:
+//    Worker thread pool
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "SDL.h"
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "m_misc.h"
+#include "i_system.h"
+#include "i_thread.h"
+
+#define MAXWORKERS  16
+
+typedef struct job_s job_t;
+
+struct job_s {
+    jobfunc_t   func;
+    void        *data;
+    jobgroup_t  *group;
+    job_t       *next;
+};
+
+struct jobgroup_s {
+    int         pending;    // queued or running
+    job_t       *finished;  // done but not collected by I_WaitAnyJob
+    job_t       *lastfinished;
+};
+
+static SDL_Thread   *workers[MAXWORKERS];
+static int          numworkers = 0;
+static SDL_mutex    *jobmutex;
+static SDL_cond     *jobcond;       // signaled when a job is queued
+static SDL_cond     *donecond;      // signaled when a job is finished
+static job_t        *jobhead;
+static job_t        *jobtail;
+static dboolean     quitworkers = false;
+
+//
+// I_NumCPUs
+//
+
+static int I_NumCPUs(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    return 1;
+#endif
+}
+
+//
+// I_PopJob
+// Takes the next job off the queue. jobmutex must be held
+//
+
+static job_t *I_PopJob(void) {
+    job_t *job = jobhead;
+
+    if(job) {
+        jobhead = job->next;
+
+        if(!jobhead) {
+            jobtail = NULL;
+        }
+
+        job->next = NULL;
+    }
+
+    return job;
+}
+
+//
+// I_FinishJob
+// Moves a job to its group's finished list. jobmutex must be held
+//
+
+static void I_FinishJob(job_t *job) {
+    jobgroup_t *group = job->group;
+
+    if(group->lastfinished) {
+        group->lastfinished->next = job;
+    }
+    else {
+        group->finished = job;
+    }
+
+    group->lastfinished = job;
+    group->pending--;
+
+    SDL_CondBroadcast(donecond);
+}
+
+//
+// I_RunJob
+// Runs a job without holding the lock
+//
+
+static void I_RunJob(job_t *job) {
+    SDL_mutexV(jobmutex);
+    job->func(job->data);
+    SDL_mutexP(jobmutex);
+
+    I_FinishJob(job);
+}
+
+//
+// I_WorkerThread
+//
+
+static int SDLCALL I_WorkerThread(void *unused) {
+    SDL_mutexP(jobmutex);
+
+    while(!quitworkers) {
+        job_t *job = I_PopJob();
+
+        if(!job) {
+            SDL_CondWait(jobcond, jobmutex);
+            continue;
+        }
+
+        I_RunJob(job);
+    }
+
+    SDL_mutexV(jobmutex);
+    return 0;
+}
+
+//
+// I_InitThreads
+// -threads <n> sets the number of workers, 0 disables them.
+// Defaults to one less than the number of CPUs
+//
+
+void I_InitThreads(void) {
+    int p;
+    int i;
+
+    numworkers = I_NumCPUs() - 1;
+
+    if((p = M_CheckParm("-threads")) && p < myargc - 1) {
+        numworkers = datoi(myargv[p + 1]);
+    }
+
+    if(numworkers < 0) {
+        numworkers = 0;
+    }
+
+    if(numworkers > MAXWORKERS) {
+        numworkers = MAXWORKERS;
+    }
+
+    jobmutex = SDL_CreateMutex();
+    jobcond = SDL_CreateCond();
+    donecond = SDL_CreateCond();
+
+    for(i = 0; i < numworkers; i++) {
+        if(!(workers[i] = SDL_CreateThread(I_WorkerThread, NULL))) {
+            break;
+        }
+    }
+
+    numworkers = i;
+
+    I_Printf("I_InitThreads: %i worker threads\n", numworkers);
+}
+
+//
+// I_ShutdownThreads
+//
+
+void I_ShutdownThreads(void) {
+    int i;
+
+    if(!numworkers) {
+        return;
+    }
+
+    SDL_mutexP(jobmutex);
+    quitworkers = true;
+    SDL_CondBroadcast(jobcond);
+    SDL_mutexV(jobmutex);
+
+    for(i = 0; i < numworkers; i++) {
+        SDL_WaitThread(workers[i], NULL);
+    }
+
+    numworkers = 0;
+}
+
+//
+// I_NumWorkers
+//
+
+int I_NumWorkers(void) {
+    return numworkers;
+}
+
+//
+// I_CreateJobGroup
+//
+
+jobgroup_t* I_CreateJobGroup(void) {
+    jobgroup_t *group = (jobgroup_t*)malloc(sizeof(jobgroup_t));
+
+    if(!group) {
+        I_Error("I_CreateJobGroup: out of memory");
+    }
+
+    group->pending = 0;
+    group->finished = NULL;
+    group->lastfinished = NULL;
+
+    return group;
+}
+
+//
+// I_DestroyJobGroup
+//
+
+void I_DestroyJobGroup(jobgroup_t* group) {
+    I_WaitJobGroup(group);
+    free(group);
+}
+
+//
+// I_QueueJob
+//
+
+void I_QueueJob(jobgroup_t* group, jobfunc_t func, void *data) {
+    job_t *job;
+
+    if(!jobmutex) {
+        I_Error("I_QueueJob: threads not initialized");
+    }
+
+    job = (job_t*)malloc(sizeof(job_t));
+
+    if(!job) {
+        I_Error("I_QueueJob: out of memory");
+    }
+
+    job->func = func;
+    job->data = data;
+    job->group = group;
+    job->next = NULL;
+
+    SDL_mutexP(jobmutex);
+
+    group->pending++;
+
+    if(!numworkers) {
+        I_RunJob(job);
+        SDL_mutexV(jobmutex);
+        return;
+    }
+
+    if(jobtail) {
+        jobtail->next = job;
+    }
+    else {
+        jobhead = job;
+    }
+
+    jobtail = job;
+
+    SDL_CondSignal(jobcond);
+    SDL_mutexV(jobmutex);
+}
+
+//
+// I_WaitAnyJob
+// Returns the data of the oldest finished job in the group,
+// waiting for one if needed. NULL once all jobs are collected
+//
+
+void* I_WaitAnyJob(jobgroup_t* group) {
+    job_t *job;
+    void *data = NULL;
+
+    if(jobmutex) {
+        SDL_mutexP(jobmutex);
+    }
+
+    while(!group->finished && group->pending) {
+        job_t *help = I_PopJob();
+
+        if(help) {
+            I_RunJob(help);
+        }
+        else {
+            SDL_CondWait(donecond, jobmutex);
+        }
+    }
+
+    if((job = group->finished)) {
+        group->finished = job->next;
+
+        if(!group->finished) {
+            group->lastfinished = NULL;
+        }
+
+        data = job->data;
+        free(job);
+    }
+
+    if(jobmutex) {
+        SDL_mutexV(jobmutex);
+    }
+
+    return data;
+}
+
+//
+// I_WaitJobGroup
+// Waits for every job in the group to be done
+//
+
+void I_WaitJobGroup(jobgroup_t* group) {
+    job_t *job;
+    job_t *next;
+
+    if(jobmutex) {
+        SDL_mutexP(jobmutex);
+    }
+
+    while(group->pending) {
+        job_t *help = I_PopJob();
+
+        if(help) {
+            I_RunJob(help);
+        }
+        else {
+            SDL_CondWait(donecond, jobmutex);
+        }
+    }
+
+    for(job = group->finished; job != NULL; job = next) {
+        next = job->next;
+        free(job);
+    }
+
+    group->finished = NULL;
+    group->lastfinished = NULL;
+
+    if(jobmutex) {
+        SDL_mutexV(jobmutex);
+    }
+}
@@ -0,0 +1,50 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __I_THREAD_H__
+#define __I_THREAD_H__
+
+#include "doomtype.h"
+
+//
+// Worker thread pool. Jobs are queued into a group and are run by the
+// workers in the order they were queued. The thread that waits on a
+// group helps running queued jobs. With no workers, jobs run right away
+// on the calling thread.
+//
+// Jobs must not touch the zone allocator, the console or call I_Error.
+//
+
+typedef void (*jobfunc_t)(void *data);
+typedef struct jobgroup_s jobgroup_t;
+
+void        I_InitThreads(void);
+void        I_ShutdownThreads(void);
+int         I_NumWorkers(void);
+
+jobgroup_t* I_CreateJobGroup(void);
+void        I_DestroyJobGroup(jobgroup_t* group);
+void        I_QueueJob(jobgroup_t* group, jobfunc_t func, void *data);
+void*       I_WaitAnyJob(jobgroup_t* group);
+void        I_WaitJobGroup(jobgroup_t* group);
+
+#endif // __I_THREAD_H__
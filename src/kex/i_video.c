@@ -198,6 +198,11 @@ void I_InitVideo(void) {
 
     putenv("SDL_VIDEO_CENTERED=1");
 
+    // the recording backend doesn't need a display
+    if(dglrecording) {
+        putenv("SDL_VIDEODRIVER=dummy");
+    }
+
     if(SDL_Init(f) < 0) {
         printf("ERROR - Failed to initialize SDL");
         exit(1);
@@ -90,61 +90,242 @@ void A_Fall(mobj_t *actor);
 
 
 //
-// P_RecursiveSound
+// SOUND PROPAGATION
+//
+// Noise floods through a graph of sector links built at level load,
+// one link per two sided line. Each link caches whether the line
+// blocks sound and whether its opening is closed; the opening is only
+// recomputed after one of the two sectors has moved
+//
+
+#define SNDL_SOUNDBLOCK     0x1
+#define SNDL_CLOSED         0x2
+
+typedef struct {
+    line_t*     line;
+    sector_t*   front;
+    sector_t*   back;
+    int         flags;
+} soundlink_t;
+
+static soundlink_t*     soundlinks = NULL;
+static int              numsoundlinks = 0;
+static int**            sectorlinks = NULL;     // link indexes of each sector
+static int*             sectorlinkcount = NULL;
+static int*             soundqueue = NULL;
+static int*             soundseeds = NULL;
+static sector_t**       sounddirty = NULL;
+static int              numsounddirty = 0;
+static byte*            sounddirtybits = NULL;
+
+mobj_t* soundtarget;
+
 //
-// Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
-// sound blocking lines cut off traversal.
+// P_RefreshSoundLink
 //
 
-mobj_t* soundtarget;
+static void P_RefreshSoundLink(soundlink_t* link) {
+    fixed_t top;
+    fixed_t bottom;
+
+    link->flags = 0;
 
-void P_RecursiveSound(sector_t* sec, int soundblocks) {
-    int        i;
-    line_t*    check;
-    sector_t*    other;
+    // anything not flagged as two sided never let sound through
+    if(!(link->line->flags & ML_TWOSIDED)) {
+        link->flags |= SNDL_CLOSED;
+        return;
+    }
 
-    // wake up all monsters in this sector
-    if(sec->validcount == validcount && sec->soundtraversed <= soundblocks+1) {
-        return;    // already flooded
+    if(link->line->flags & ML_SOUNDBLOCK) {
+        link->flags |= SNDL_SOUNDBLOCK;
     }
 
-    sec->validcount     = validcount;
-    sec->soundtraversed = soundblocks+1;
+    top = MIN(link->front->ceilingheight, link->back->ceilingheight);
+    bottom = MAX(link->front->floorheight, link->back->floorheight);
 
-    P_SetTarget(&sec->soundtarget, soundtarget);
+    if(top - bottom <= 0) {
+        link->flags |= SNDL_CLOSED;    // closed door
+    }
+}
 
-    for(i = 0; i < sec->linecount; i++) {
-        check = sec->lines[i];
-        if(!(check->flags & ML_TWOSIDED)) {
-            continue;
-        }
+//
+// P_RefreshSoundGraph
+// Re-reads every link. Call after line flags have been changed
+//
 
-        P_LineOpening(check);
+void P_RefreshSoundGraph(void) {
+    int i;
 
-        if(openrange <= 0) {
-            continue;    // closed door
-        }
+    for(i = 0; i < numsoundlinks; i++) {
+        P_RefreshSoundLink(&soundlinks[i]);
+    }
+
+    for(i = 0; i < numsounddirty; i++) {
+        sounddirtybits[sounddirty[i] - sectors] = 0;
+    }
+
+    numsounddirty = 0;
+}
+
+//
+// P_InitSoundGraph
+// Called after P_GroupLines
+//
 
-        if(sides[check->sidenum[0] ].sector == sec) {
-            other = sides[check->sidenum[1]].sector;
+void P_InitSoundGraph(void) {
+    int         i;
+    int         j;
+    int         count;
+    int*        linkindex;
+    line_t*     line;
+    sector_t*   sec;
+
+    numsoundlinks = 0;
+    for(i = 0; i < numlines; i++) {
+        if(lines[i].sidenum[1] != NO_SIDE_INDEX) {
+            numsoundlinks++;
         }
-        else {
-            other = sides[check->sidenum[0]].sector;
+    }
+
+    soundlinks = (soundlink_t*)Z_Calloc(sizeof(soundlink_t) * (numsoundlinks + 1), PU_LEVEL, 0);
+    linkindex = (int*)Z_Malloc(sizeof(int) * numlines, PU_STATIC, 0);
+
+    for(i = 0, count = 0; i < numlines; i++) {
+        line = &lines[i];
+        linkindex[i] = -1;
+
+        if(line->sidenum[1] == NO_SIDE_INDEX) {
+            continue;
         }
 
-        if(check->flags & ML_SOUNDBLOCK) {
-            if(!soundblocks) {
-                P_RecursiveSound(other, 1);
+        soundlinks[count].line = line;
+        soundlinks[count].front = sides[line->sidenum[0]].sector;
+        soundlinks[count].back = sides[line->sidenum[1]].sector;
+        linkindex[i] = count++;
+    }
+
+    // build the per sector link lists, keeping the order of sec->lines
+    sectorlinks = (int**)Z_Malloc(sizeof(int*) * numsectors, PU_LEVEL, 0);
+    sectorlinkcount = (int*)Z_Calloc(sizeof(int) * numsectors, PU_LEVEL, 0);
+
+    for(i = 0, sec = sectors; i < numsectors; i++, sec++) {
+        sectorlinks[i] = (int*)Z_Malloc(sizeof(int) * (sec->linecount + 1), PU_LEVEL, 0);
+
+        for(j = 0; j < sec->linecount; j++) {
+            int idx = linkindex[sec->lines[j] - lines];
+
+            if(idx != -1) {
+                sectorlinks[i][sectorlinkcount[i]++] = idx;
             }
         }
-        else {
-            P_RecursiveSound(other, soundblocks);
+    }
+
+    Z_Free(linkindex);
+
+    soundqueue = (int*)Z_Malloc(sizeof(int) * numsectors, PU_LEVEL, 0);
+    soundseeds = (int*)Z_Malloc(sizeof(int) * numsectors, PU_LEVEL, 0);
+    sounddirty = (sector_t**)Z_Malloc(sizeof(sector_t*) * numsectors, PU_LEVEL, 0);
+    sounddirtybits = (byte*)Z_Calloc(numsectors, PU_LEVEL, 0);
+    numsounddirty = 0;
+
+    P_RefreshSoundGraph();
+}
+
+//
+// P_SoundSectorMoved
+// The openings around the sector are refreshed on the next noise
+//
+
+void P_SoundSectorMoved(sector_t* sector) {
+    int secnum = sector - sectors;
+
+    if(!sounddirtybits[secnum]) {
+        sounddirtybits[secnum] = 1;
+        sounddirty[numsounddirty++] = sector;
+    }
+}
+
+//
+// P_FloodSoundPass
+// Breadth first walk from the sectors already in the queue. Links
+// that block sound are only crossed on the first pass, and whatever
+// is behind them is left in the seed list for the second pass
+//
+
+static int P_FloodSoundPass(int* queue, int tail, int traversed, int* seeds, int* numseeds) {
+    int head;
+    int i;
+
+    for(head = 0; head < tail; head++) {
+        int secnum = queue[head];
+
+        P_SetTarget(&sectors[secnum].soundtarget, soundtarget);
+
+        for(i = 0; i < sectorlinkcount[secnum]; i++) {
+            soundlink_t*    link = &soundlinks[sectorlinks[secnum][i]];
+            sector_t*       other;
+
+            if(link->flags & SNDL_CLOSED) {
+                continue;    // closed door
+            }
+
+            other = (link->front == &sectors[secnum]) ? link->back : link->front;
+
+            if(link->flags & SNDL_SOUNDBLOCK) {
+                if(!seeds) {
+                    continue;
+                }
+
+                if(other->validcount != validcount) {
+                    other->validcount = validcount;
+                    other->soundtraversed = traversed + 1;
+                    seeds[(*numseeds)++] = other - sectors;
+                }
+
+                continue;
+            }
+
+            if(other->validcount == validcount && other->soundtraversed <= traversed) {
+                continue;    // already flooded
+            }
+
+            other->validcount = validcount;
+            other->soundtraversed = traversed;
+            queue[tail++] = other - sectors;
         }
     }
+
+    return tail;
 }
 
+//
+// P_FloodSound
+// Sectors reached without crossing a sound blocking line end up with
+// soundtraversed 1 and the ones past a single blocking line with 2,
+// the same as the old recursive flood gave
+//
+
+static void P_FloodSound(sector_t* sec) {
+    int numseeds;
+    int tail;
+    int i;
+
+    sec->validcount = validcount;
+    sec->soundtraversed = 1;
+    soundqueue[0] = sec - sectors;
+    numseeds = 0;
 
+    P_FloodSoundPass(soundqueue, 1, 1, soundseeds, &numseeds);
+
+    // seeds that the first pass got to some other way are done
+    for(i = 0, tail = 0; i < numseeds; i++) {
+        if(sectors[soundseeds[i]].soundtraversed == 2) {
+            soundseeds[tail++] = soundseeds[i];
+        }
+    }
+
+    P_FloodSoundPass(soundseeds, tail, 2, NULL, NULL);
+}
 
 //
 // P_NoiseAlert
@@ -153,9 +334,25 @@ void P_RecursiveSound(sector_t* sec, int soundblocks) {
 //
 
 void P_NoiseAlert(mobj_t* target, mobj_t* emmiter) {
+    int i;
+    int j;
+
+    // catch up on the openings around anything that has moved
+    for(i = 0; i < numsounddirty; i++) {
+        int secnum = sounddirty[i] - sectors;
+
+        for(j = 0; j < sectorlinkcount[secnum]; j++) {
+            P_RefreshSoundLink(&soundlinks[sectorlinks[secnum][j]]);
+        }
+
+        sounddirtybits[secnum] = 0;
+    }
+
+    numsounddirty = 0;
+
     soundtarget = target;
     D_IncValidCount();
-    P_RecursiveSound(emmiter->subsector->sector, 0);
+    P_FloodSound(emmiter->subsector->sector);
 }
 
 
@@ -578,6 +775,18 @@ void P_NewChaseDir(mobj_t* actor) {
 
 
 
+//
+// PIT_BotTarget
+// Anything killable that a player bot can go after
+//
+
+static mobj_t* lookactor;
+
+static dboolean PIT_BotTarget(mobj_t* mobj) {
+    return (mobj->flags & MF_COUNTKILL) && mobj->type > MT_PLAYERBOT3 &&
+           mobj->health > 0 && mobj != lookactor;
+}
+
 //
 // P_LookForPlayers
 // If allaround is false, only look 180 degrees in front.
@@ -623,9 +832,20 @@ dboolean P_LookForPlayers(mobj_t* actor, dboolean allaround) {
             fixed_t dist2 = D_MAXINT;
             mobj_t* mobj;
 
+            lookactor = actor;
+
+            // demos keep the original sweep over every mobj, as
+            // targets at the same distance are picked in list order
+            if(!demoplayback && !demorecording) {
+                if((mobj = P_FindNearestMobj(actor->x, actor->y, 0, PIT_BotTarget))) {
+                    P_SetTarget(&actor->target, mobj);
+                }
+
+                return false;
+            }
+
             for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
-                if(!(mobj->flags & MF_COUNTKILL) || mobj->type <= MT_PLAYERBOT3 ||
-                        mobj->health <= 0 || mobj == actor) {
+                if(!PIT_BotTarget(mobj)) {
                     continue;
                 }
 
@@ -49,6 +49,8 @@ result_e T_MovePlane(sector_t* sector, fixed_t speed, fixed_t dest,
     dboolean flag;
     fixed_t lastpos;
 
+    P_SectorMoved(sector);
+
     switch(floorOrCeiling) {
     case 0:
         // FLOOR
@@ -465,6 +467,8 @@ void T_MoveSplitPlane(splitmove_t *split) {
     dboolean cdone      = false;
     dboolean fdone      = false;
 
+    P_SectorMoved(sector);
+
     if(split->ceildir == -1) {
         lastceilpos = sector->ceilingheight;
 
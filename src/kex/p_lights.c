@@ -558,6 +558,8 @@ void T_LightMorph(lightmorph_t *lt) {
     lt->dest->active_r = (lt->r + ((lt->inc * (lt->src->base_r - lt->r)) >> 8));
     lt->dest->active_g = (lt->g + ((lt->inc * (lt->src->base_g - lt->g)) >> 8));
     lt->dest->active_b = (lt->b + ((lt->inc * (lt->src->base_b - lt->b)) >> 8));
+
+    P_LightChanged(lt->dest);
 }
 
 //
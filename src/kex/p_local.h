@@ -154,6 +154,15 @@ void        P_SpawnPlayer(mapthing_t* mthing);
 void        P_SetTarget(mobj_t **mop, mobj_t *targ);
 dboolean    P_SetMobjState(mobj_t* mobj, statenum_t state);
 void        P_MobjThinker(mobj_t* mobj);
+dboolean    P_MobjIsDormant(mobj_t* mobj);
+void        P_ClearMobjHot(void);
+void        P_AddMobjHot(mobj_t* mobj);
+void        P_RemoveMobjHot(mobj_t* mobj);
+void        P_SyncMobjHot(mobj_t* mobj);
+void        P_UpdateMobjFrames(void);
+void        P_RegisterMobjCommands(void);
+
+extern int  dormantmobjs;   // skipped by P_RunMobjs last tic
 dboolean    P_OnMobjZ(mobj_t* mobj);
 void        P_NightmareRespawn(mobj_t* mobj);
 void        P_RespawnSpecials(mobj_t* special);
@@ -171,6 +180,10 @@ mobj_t*     P_SpawnMissile(mobj_t* source, mobj_t* dest, mobjtype_t type,
 // P_ENEMY
 //
 void P_NoiseAlert(mobj_t* target, mobj_t* emmiter);
+void A_Look(mobj_t* actor);
+void P_InitSoundGraph(void);
+void P_RefreshSoundGraph(void);
+void P_SoundSectorMoved(sector_t* sector);
 
 
 //
@@ -195,8 +208,9 @@ typedef struct {
 
 #define MAXINTERCEPTS    128
 
-extern intercept_t    intercepts[MAXINTERCEPTS];
+extern intercept_t*    intercepts;
 extern intercept_t*    intercept_p;
+extern int            maxintercepts;
 
 typedef dboolean(*traverser_t)(intercept_t *in);
 
@@ -216,6 +230,9 @@ extern fixed_t        lowfloor;
 void         P_LineOpening(line_t* linedef);
 dboolean    P_BlockLinesIterator(int x, int y, dboolean(*func)(line_t*));
 dboolean    P_BlockThingsIterator(int x, int y, dboolean(*func)(mobj_t*));
+dboolean    P_BlockThingsIteratorNear(int x, int y, fixed_t cx, fixed_t cy, fixed_t radius,
+                                      dboolean(*func)(mobj_t*));
+mobj_t*     P_FindNearestMobj(fixed_t x, fixed_t y, fixed_t radius, dboolean(*func)(mobj_t*));
 
 #define PT_ADDLINES        1
 #define PT_ADDTHINGS    2
@@ -246,6 +263,7 @@ dboolean    P_TeleportMove(mobj_t* thing, fixed_t x, fixed_t y);
 void        P_SlideMove(mobj_t* mo);
 dboolean    P_CheckSight(mobj_t* t1, mobj_t* t2);
 void        P_ScanSights(void);
+void        P_InitSight(void);
 dboolean    P_UseLines(player_t* player, dboolean showcontext);
 dboolean    P_ChangeSector(sector_t* sector, dboolean crunch);
 mobj_t*     P_CheckOnMobj(mobj_t *thing);
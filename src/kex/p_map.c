@@ -447,7 +447,7 @@ dboolean P_CheckPosition(mobj_t* thing, fixed_t x, fixed_t y) {
 
     for(bx = bbox[BOXLEFT]; bx <= bbox[BOXRIGHT]; bx++) {
         for(by = bbox[BOXBOTTOM]; by <= bbox[BOXTOP]; by++) {
-            if(!P_BlockThingsIterator(bx, by, PIT_CheckThing)) {
+            if(!P_BlockThingsIteratorNear(bx, by, tmx, tmy, tmthing->radius, PIT_CheckThing)) {
                 return false;
             }
         }
@@ -611,7 +611,7 @@ dboolean P_TeleportMove(mobj_t* thing, fixed_t x, fixed_t y) {
     for(bx = bbox[BOXLEFT]; bx <= bbox[BOXRIGHT]; bx++) {
         for(by = bbox[BOXBOTTOM]; by <= bbox[BOXTOP]; by++) {
             // [d64] do stomping in actual teleport function
-            if(!P_BlockThingsIterator(bx, by, PIT_CheckThing)) {
+            if(!P_BlockThingsIteratorNear(bx, by, tmx, tmy, tmthing->radius, PIT_CheckThing)) {
                 return false;
             }
         }
@@ -664,6 +664,8 @@ static dboolean P_ThingHeightClip(mobj_t* thing) {
         }
     }
 
+    P_SyncMobjHot(thing);
+
     if(thing->ceilingz - thing->floorz < thing->height) {
         return false;
     }
@@ -1807,6 +1809,7 @@ static dboolean PTR_ChaseCamTraverse(intercept_t* in) {
 
         tmcamera->x = x;
         tmcamera->y = y;
+        P_SyncMobjHot(tmcamera);
 
         return false; // don't go any farther
     }
@@ -1824,6 +1827,7 @@ void P_CheckChaseCamPosition(mobj_t* target, mobj_t* camera, fixed_t x, fixed_t
     if(P_PathTraverse(target->x, target->y, x, y, PT_ADDLINES, PTR_ChaseCamTraverse)) {
         camera->x = x;
         camera->y = y;
+        P_SyncMobjHot(camera);
     }
 }
 
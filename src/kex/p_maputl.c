@@ -354,6 +354,7 @@ void P_UnsetThingPosition(mobj_t* thing) {
 
         if(thing->bprev) {
             thing->bprev->bnext = thing->bnext;
+            mobjhot.bnext[thing->bprev->hotindex] = thing->bnext ? thing->bnext->hotindex : -1;
         }
         else {
             blockx = (thing->x - bmaporgx)>>MAPBLOCKSHIFT;
@@ -425,7 +426,11 @@ P_SetThingPosition(mobj_t* thing) {
             // thing is off the map
             thing->bnext = thing->bprev = NULL;
         }
+
+        mobjhot.bnext[thing->hotindex] = thing->bnext ? thing->bnext->hotindex : -1;
     }
+
+    P_SyncMobjHot(thing);
 }
 
 
@@ -517,17 +522,186 @@ P_BlockThingsIterator
 }
 
 
+//
+// P_BlockThingsIteratorNear
+// Same as P_BlockThingsIterator, but walks the block through
+// mobjhot and only calls func for things whose bounding box
+// overlaps the one given by cx/cy/radius
+//
+dboolean
+P_BlockThingsIteratorNear
+(int            x,
+ int            y,
+ fixed_t        cx,
+ fixed_t        cy,
+ fixed_t        radius,
+ dboolean(*func)(mobj_t*)) {
+    mobj_t*        mobj;
+    fixed_t        blockdist;
+    int            i;
+
+    if(x<0
+            || y<0
+            || x>=bmapwidth
+            || y>=bmapheight) {
+        return true;
+    }
+
+    mobj = blocklinks[y*bmapwidth+x];
+    if(!mobj) {
+        return true;
+    }
+
+    // func may spawn things and grow the
+    // arrays, so never hold on to them
+    for(i = mobj->hotindex; i != -1; i = mobjhot.bnext[i]) {
+        blockdist = mobjhot.radius[i] + radius;
+
+        if(D_abs(mobjhot.x[i] - cx) >= blockdist ||
+                D_abs(mobjhot.y[i] - cy) >= blockdist) {
+            continue;
+        }
+
+        if(!func(mobjhot.mobj[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+//
+// P_FindNearestMobj
+// Returns the closest thing to x/y (going by P_AproxDistance) that func
+// accepts, or NULL if there is none. A radius of 0 searches the whole
+// map. The blockmap is walked outward one ring of blocks at a time and
+// the search stops at the first ring that can't hold anything closer
+// than the best hit so far. Things that are not linked into the
+// blockmap are never found
+//
+
+mobj_t* P_FindNearestMobj(fixed_t x, fixed_t y, fixed_t radius, dboolean(*func)(mobj_t*)) {
+    int         bx;
+    int         by;
+    int         ring;
+    int         maxring;
+    int         i;
+    mobj_t*     best;
+    fixed_t     bestdist;
+
+    bx = (x - bmaporgx) >> MAPBLOCKSHIFT;
+    by = (y - bmaporgy) >> MAPBLOCKSHIFT;
+
+    // furthest ring that still touches the blockmap
+    maxring = MAX(MAX(bx, bmapwidth - 1 - bx), MAX(by, bmapheight - 1 - by));
+
+    if(radius > 0) {
+        maxring = MIN(maxring, (radius >> MAPBLOCKSHIFT) + 1);
+    }
+
+    best = NULL;
+    bestdist = D_MAXINT;
+
+    for(ring = 0; ring <= maxring; ring++) {
+        int x1 = bx - ring;
+        int x2 = bx + ring;
+        int y1 = by - ring;
+        int y2 = by + ring;
+        int cells = ring ? ring * 8 : 1;
+
+        // everything in this ring is at least (ring - 1) blocks away
+        if(best && ring - 1 > (bestdist >> MAPBLOCKSHIFT)) {
+            break;
+        }
+
+        for(i = 0; i < cells; i++) {
+            int         cx;
+            int         cy;
+            mobj_t*     mo;
+
+            // walk the top and bottom rows, then the columns in between
+            if(!ring) {
+                cx = bx;
+                cy = by;
+            }
+            else if(i < (ring * 2 + 1) * 2) {
+                cx = x1 + (i >> 1);
+                cy = (i & 1) ? y2 : y1;
+            }
+            else {
+                int j = i - (ring * 2 + 1) * 2;
+
+                cx = (j & 1) ? x2 : x1;
+                cy = y1 + 1 + (j >> 1);
+            }
+
+            if(cx < 0 || cy < 0 || cx >= bmapwidth || cy >= bmapheight) {
+                continue;
+            }
+
+            for(mo = blocklinks[cy * bmapwidth + cx]; mo; mo = mo->bnext) {
+                fixed_t dist = P_AproxDistance(mo->x - x, mo->y - y);
+
+                if(!(dist < bestdist) || (radius > 0 && dist > radius)) {
+                    continue;
+                }
+
+                if(!func(mo)) {
+                    continue;
+                }
+
+                best = mo;
+                bestdist = dist;
+            }
+        }
+    }
+
+    return best;
+}
 
 //
 // INTERCEPT ROUTINES
 //
-intercept_t    intercepts[MAXINTERCEPTS];
-intercept_t*    intercept_p;
+intercept_t*    intercepts = NULL;
+intercept_t*    intercept_p = NULL;
+int             maxintercepts = 0;
+
+static intercept_t* sortintercepts = NULL;
 
 divline_t     trace;
 dboolean     earlyout;
 int        ptflags;
 
+//
+// P_NewIntercept
+// Returns the next free slot in the intercept list, growing
+// it as needed. Returns NULL if the hit should be dropped
+//
+
+static intercept_t* P_NewIntercept(void) {
+    int count = intercept_p - intercepts;
+
+    // [d64] the original game drops anything past MAXINTERCEPTS.
+    // keep doing so for demos so that old recordings still play back
+    if(count >= MAXINTERCEPTS && (demoplayback || demorecording)) {
+        return NULL;
+    }
+
+    if(count >= maxintercepts) {
+        maxintercepts = maxintercepts ? maxintercepts * 2 : MAXINTERCEPTS;
+
+        intercepts = (intercept_t*)Z_Realloc(intercepts,
+                                             sizeof(intercept_t) * maxintercepts, PU_STATIC, 0);
+        sortintercepts = (intercept_t*)Z_Realloc(sortintercepts,
+                         sizeof(intercept_t) * maxintercepts, PU_STATIC, 0);
+
+        intercept_p = intercepts + count;
+    }
+
+    return intercept_p++;
+}
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -544,6 +718,7 @@ PIT_AddLineIntercepts(line_t* ld) {
     int            s2;
     fixed_t        frac;
     divline_t        dl;
+    intercept_t*    in;
 
     // avoid precision problems with two routines
     if(trace.dx > FRACUNIT*16
@@ -577,16 +752,13 @@ PIT_AddLineIntercepts(line_t* ld) {
         return false;    // stop checking
     }
 
-    // [d64] exit out if max intercepts has been hit
-    if((intercept_p - intercepts) >= MAXINTERCEPTS) {
+    if(!(in = P_NewIntercept())) {
         return true;
     }
 
-
-    intercept_p->frac = frac;
-    intercept_p->isaline = true;
-    intercept_p->d.line = ld;
-    intercept_p++;
+    in->frac = frac;
+    in->isaline = true;
+    in->d.line = ld;
 
     return true;    // continue
 }
@@ -611,6 +783,8 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
 
     fixed_t        frac;
 
+    intercept_t*    in;
+
     tracepositive = (trace.dx ^ trace.dy)>0;
 
     // check a corner to corner crossection for hit
@@ -647,20 +821,99 @@ dboolean PIT_AddThingIntercepts(mobj_t* thing) {
         return true;    // behind source
     }
 
-    // [d64] exit out if max intercepts has been hit
-    if((intercept_p - intercepts) >= MAXINTERCEPTS) {
+    if(!(in = P_NewIntercept())) {
         return true;
     }
 
-    intercept_p->frac = frac;
-    intercept_p->isaline = false;
-    intercept_p->d.thing = thing;
-    intercept_p++;
+    in->frac = frac;
+    in->isaline = false;
+    in->d.thing = thing;
 
     return true;        // keep going
 }
 
 
+//
+// P_SortIntercepts
+// Stable sort of the intercept list by frac. Intercepts are added
+// block by block along the trace so the list is usually close to
+// sorted already; short lists are insertion sorted and longer ones
+// go through a bottom-up merge sort. Equal fracs keep the order they
+// were added in, which is what the old nearest-first scan returned
+//
+
+static void P_SortIntercepts(void) {
+    int             count;
+    int             width;
+    int             i;
+    int             j;
+    intercept_t*    src;
+    intercept_t*    dst;
+    intercept_t*    tmp;
+    intercept_t     in;
+
+    count = intercept_p - intercepts;
+
+    if(count <= 16) {
+        for(i = 1; i < count; i++) {
+            in = intercepts[i];
+
+            for(j = i - 1; j >= 0 && intercepts[j].frac > in.frac; j--) {
+                intercepts[j + 1] = intercepts[j];
+            }
+
+            intercepts[j + 1] = in;
+        }
+
+        return;
+    }
+
+    src = intercepts;
+    dst = sortintercepts;
+
+    for(width = 1; width < count; width *= 2) {
+        for(i = 0; i < count; i += width * 2) {
+            int left = i;
+            int mid = MIN(i + width, count);
+            int right = MIN(i + width * 2, count);
+            int k = i;
+
+            // already in order, copy the run across as is
+            if(mid >= right || src[mid - 1].frac <= src[mid].frac) {
+                dmemcpy(&dst[i], &src[i], sizeof(intercept_t) * (right - i));
+                continue;
+            }
+
+            j = mid;
+
+            while(left < mid && j < right) {
+                if(src[j].frac < src[left].frac) {
+                    dst[k++] = src[j++];
+                }
+                else {
+                    dst[k++] = src[left++];
+                }
+            }
+
+            while(left < mid) {
+                dst[k++] = src[left++];
+            }
+
+            while(j < right) {
+                dst[k++] = src[j++];
+            }
+        }
+
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if(src != intercepts) {
+        dmemcpy(intercepts, src, sizeof(intercept_t) * count);
+    }
+}
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
@@ -670,46 +923,18 @@ dboolean
 P_TraverseIntercepts
 (traverser_t    func,
  fixed_t    maxfrac) {
-    int            count;
-    fixed_t        dist;
-    intercept_t*    scan;
     intercept_t*    in;
 
-    count = intercept_p - intercepts;
-
-    in = 0;            // shut up compiler warning
+    P_SortIntercepts();
 
-    while(count--) {
-        dist = D_MAXINT;
-        for(scan = intercepts ; scan<intercept_p ; scan++) {
-            if(scan->frac < dist) {
-                dist = scan->frac;
-                in = scan;
-            }
-        }
-
-        if(dist > maxfrac) {
+    for(in = intercepts; in < intercept_p; in++) {
+        if(in->frac > maxfrac) {
             return true;    // checked everything in range
         }
 
-#if 0  // UNUSED
-        {
-            // don't check these yet, there may be others inserted
-            in = scan = intercepts;
-            for(scan = intercepts ; scan<intercept_p ; scan++)
-                if(scan->frac > maxfrac) {
-                    *in++ = *scan;
-                }
-            intercept_p = in;
-            return false;
-        }
-#endif
-
         if(!func(in)) {
             return false;    // don't bother going farther
         }
-
-        in->frac = D_MAXINT;
     }
 
     return true;        // everything was traversed
@@ -44,6 +44,7 @@
 #include "m_misc.h"
 #include "con_console.h"
 #include "m_password.h"
+#include "g_actions.h"
 
 mapthing_t* spawnlist;
 int         numspawnlist;
@@ -523,6 +524,63 @@ dboolean P_OnMobjZ(mobj_t* mobj) {
 }
 
 
+//
+// P_MobjIsDormant
+// [kex] With sv_dormantmonsters set, monsters idling in A_Look that are
+// far away from every player are left alone until a noise, damage or
+// a player coming close wakes them up. Only game state is looked at
+// here so demos and netgames stay in sync
+//
+
+int dormantmobjs = 0;
+
+dboolean P_MobjIsDormant(mobj_t* mobj) {
+    fixed_t dist;
+    int     i;
+
+    if(!(gameflags & GF_DORMANTMONSTERS)) {
+        return false;
+    }
+
+    if(mobj->player || !(mobj->flags & MF_COUNTKILL) || mobj->mobjfunc) {
+        return false;
+    }
+
+    if(mobj->state->action.acp1 != (actionf_p1)A_Look) {
+        return false;
+    }
+
+    // anything that would move it needs the thinker
+    if(mobj->momx || mobj->momy || mobj->momz) {
+        return false;
+    }
+
+    if(mobj->flags & MF_GRAVITY && mobj->z > mobj->floorz) {
+        return false;
+    }
+
+    // heard something
+    if(mobj->subsector->sector->soundtarget) {
+        return false;
+    }
+
+    dist = ((gameflags & GF_DORMANTDISTMASK) >> GF_DORMANTDISTSHIFT) << MAPBLOCKSHIFT;
+
+    for(i = 0; i < MAXPLAYERS; i++) {
+        mobj_t* mo;
+
+        if(!playeringame[i] || !(mo = players[i].mo)) {
+            continue;
+        }
+
+        if(P_AproxDistance(mo->x - mobj->x, mo->y - mobj->y) < dist) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 //
 // P_MobjThinker
 //
@@ -581,6 +639,246 @@ void P_MobjThinker(mobj_t* mobj) {
 }
 
 
+//
+// MOBJ HOT FIELDS
+//
+
+mobjhot_t mobjhot;
+
+//
+// P_ClearMobjHot
+// Drops every slot. The arrays are kept around for the next level
+//
+
+void P_ClearMobjHot(void) {
+    mobjhot.count = 0;
+    mobjhot.freeslot = -1;
+}
+
+//
+// P_SyncMobjHot
+//
+
+void P_SyncMobjHot(mobj_t* mobj) {
+    int i = mobj->hotindex;
+
+    mobjhot.x[i] = mobj->x;
+    mobjhot.y[i] = mobj->y;
+    mobjhot.z[i] = mobj->z;
+    mobjhot.radius[i] = mobj->radius;
+}
+
+//
+// P_AddMobjHot
+// Gives a new mobj a slot, reusing freed ones first
+//
+
+void P_AddMobjHot(mobj_t* mobj) {
+    int i;
+
+    if(mobjhot.freeslot != -1) {
+        i = mobjhot.freeslot;
+        mobjhot.freeslot = mobjhot.bnext[i];
+    }
+    else {
+        if(mobjhot.count >= mobjhot.max) {
+            mobjhot.max = mobjhot.max ? mobjhot.max * 2 : 1024;
+
+            mobjhot.mobj = Z_Realloc(mobjhot.mobj, sizeof(mobj_t*) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.x = Z_Realloc(mobjhot.x, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.y = Z_Realloc(mobjhot.y, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.z = Z_Realloc(mobjhot.z, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.radius = Z_Realloc(mobjhot.radius, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.bnext = Z_Realloc(mobjhot.bnext, sizeof(int) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.frame_x = Z_Realloc(mobjhot.frame_x, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.frame_y = Z_Realloc(mobjhot.frame_y, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+            mobjhot.frame_z = Z_Realloc(mobjhot.frame_z, sizeof(fixed_t) * mobjhot.max, PU_STATIC, 0);
+        }
+
+        i = mobjhot.count++;
+    }
+
+    mobj->hotindex = i;
+
+    mobjhot.mobj[i] = mobj;
+    mobjhot.bnext[i] = -1;
+
+    P_SyncMobjHot(mobj);
+
+    mobjhot.frame_x[i] = mobj->x;
+    mobjhot.frame_y[i] = mobj->y;
+    mobjhot.frame_z[i] = mobj->z;
+}
+
+//
+// P_RemoveMobjHot
+// Only called once the mobj is out of the blockmap for good,
+// so nothing can reach the slot through bnext anymore. Free
+// slots are chained through bnext
+//
+
+void P_RemoveMobjHot(mobj_t* mobj) {
+    int i = mobj->hotindex;
+
+    mobjhot.mobj[i] = NULL;
+    mobjhot.bnext[i] = mobjhot.freeslot;
+    mobjhot.freeslot = i;
+}
+
+//
+// P_UpdateMobjFrames
+// Remembers where every thing is at the start of the tic
+//
+
+void P_UpdateMobjFrames(void) {
+    dmemcpy(mobjhot.frame_x, mobjhot.x, sizeof(fixed_t) * mobjhot.count);
+    dmemcpy(mobjhot.frame_y, mobjhot.y, sizeof(fixed_t) * mobjhot.count);
+    dmemcpy(mobjhot.frame_z, mobjhot.z, sizeof(fixed_t) * mobjhot.count);
+}
+
+static int benchhits;
+static mobj_t* benchthing;
+
+//
+// PIT_BenchCheckThing
+// The distance check from P_CheckThingCollision
+//
+
+static dboolean PIT_BenchCheckThing(mobj_t* thing) {
+    fixed_t blockdist = thing->radius + benchthing->radius;
+
+    if(D_abs(thing->x - benchthing->x) >= blockdist ||
+            D_abs(thing->y - benchthing->y) >= blockdist) {
+        return true;
+    }
+
+    benchhits++;
+    return true;
+}
+
+//
+// PIT_BenchCountThing
+//
+
+static dboolean PIT_BenchCountThing(mobj_t* thing) {
+    benchhits++;
+    return true;
+}
+
+//
+// P_BenchThingPass
+// Runs the thing part of P_CheckPosition for every mobj in place
+//
+
+static int P_BenchThingPass(dboolean usehot) {
+    mobj_t* mo;
+    int     bx;
+    int     by;
+    int     xl;
+    int     xh;
+    int     yl;
+    int     yh;
+
+    benchhits = 0;
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        benchthing = mo;
+
+        xl = (mo->x - mo->radius - bmaporgx) >> MAPBLOCKSHIFT;
+        xh = (mo->x + mo->radius - bmaporgx) >> MAPBLOCKSHIFT;
+        yl = (mo->y - mo->radius - bmaporgy) >> MAPBLOCKSHIFT;
+        yh = (mo->y + mo->radius - bmaporgy) >> MAPBLOCKSHIFT;
+
+        for(bx = xl; bx <= xh; bx++) {
+            for(by = yl; by <= yh; by++) {
+                if(usehot) {
+                    P_BlockThingsIteratorNear(bx, by, mo->x, mo->y,
+                                              mo->radius, PIT_BenchCountThing);
+                }
+                else {
+                    P_BlockThingsIterator(bx, by, PIT_BenchCheckThing);
+                }
+            }
+        }
+    }
+
+    return benchhits;
+}
+
+//
+// CMD_MobjBench
+// Times the per-tic interpolation copy and the thing collision
+// pass, once going through the mobjs and once through mobjhot
+//
+
+static CMD(MobjBench) {
+    int     runs = 100;
+    int     i;
+    int     count = 0;
+    int     hits[2];
+    uint64  start;
+    uint64  time[4];
+    fixed_t sum = 0;
+    mobj_t* mo;
+
+    if(gamestate != GS_LEVEL) {
+        return;
+    }
+
+    if(param[0]) {
+        runs = MAX(datoi(param[0]), 1);
+    }
+
+    for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+        count++;
+    }
+
+    // what P_UpdateFrameStates used to do
+    start = I_GetTimeUS();
+    for(i = 0; i < runs; i++) {
+        for(mo = mobjhead.next; mo != &mobjhead; mo = mo->next) {
+            if(mo->flags & MF_NOSECTOR) {
+                continue;
+            }
+
+            sum += mo->x + mo->y + mo->z;
+        }
+    }
+    time[0] = I_GetTimeUS() - start;
+
+    start = I_GetTimeUS();
+    for(i = 0; i < runs; i++) {
+        P_UpdateMobjFrames();
+    }
+    time[1] = I_GetTimeUS() - start;
+
+    start = I_GetTimeUS();
+    for(i = 0; i < runs; i++) {
+        hits[0] = P_BenchThingPass(false);
+    }
+    time[2] = I_GetTimeUS() - start;
+
+    start = I_GetTimeUS();
+    for(i = 0; i < runs; i++) {
+        hits[1] = P_BenchThingPass(true);
+    }
+    time[3] = I_GetTimeUS() - start;
+
+    CON_Printf(WHITE, "mobjbench: %i mobjs, %i runs (%i)\n", count, runs, sum & 1);
+    CON_Printf(WHITE, "frame copy: mobj list %i us, mobjhot %i us\n",
+               (int)(time[0] / runs), (int)(time[1] / runs));
+    CON_Printf(WHITE, "thing collision: mobj list %i us, mobjhot %i us (%i/%i contacts)\n",
+               (int)(time[2] / runs), (int)(time[3] / runs), hits[0], hits[1]);
+}
+
+//
+// P_RegisterMobjCommands
+//
+
+void P_RegisterMobjCommands(void) {
+    G_AddCommand("mobjbench", CMD_MobjBench, 0);
+}
+
 //
 // P_SpawnMobj
 //
@@ -605,8 +903,6 @@ mobj_t* P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type) {
     mobj->health    = info->spawnhealth;
     mobj->alpha     = info->alpha;
     mobj->blockflag = 0;
-    mobj->frame_x   = mobj->x;
-    mobj->frame_y   = mobj->y;
     mobj->mobjfunc  = NULL;
     mobj->extradata = NULL;
     mobj->target    = NULL;
@@ -643,21 +939,26 @@ mobj_t* P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type) {
     mobj->sprite    = st->sprite;
     mobj->frame     = st->frame;
 
+    P_AddMobjHot(mobj);
+
     P_SetThingPosition(mobj);   // set subsector and/or block links
 
     mobj->floorz    = mobj->subsector->sector->floorheight;
     mobj->ceilingz  = mobj->subsector->sector->ceilingheight;
 
     if(z == ONFLOORZ) {
-        mobj->z = mobj->frame_z = mobj->floorz;
+        mobj->z = mobj->floorz;
     }
     else if(z == ONCEILINGZ) {
-        mobj->z = mobj->frame_z = (mobj->ceilingz - mobj->info->height);
+        mobj->z = (mobj->ceilingz - mobj->info->height);
     }
     else {
-        mobj->z = mobj->frame_z = z;
+        mobj->z = z;
     }
 
+    P_SyncMobjHot(mobj);
+    mobjhot.frame_z[mobj->hotindex] = mobj->z;
+
     P_LinkMobj(mobj);       // add to list
 
     return mobj;
@@ -670,6 +971,7 @@ mobj_t* P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type) {
 void P_SafeRemoveMobj(mobj_t* mobj) {
     if(!mobj->refcount) {
         P_UnlinkMobj(mobj); // unlink from mobj list
+        P_RemoveMobjHot(mobj);
         Z_Free(mobj);       // free block
     }
 }
@@ -1372,6 +1674,7 @@ void P_SpawnDartMissile(int tid, int type, mobj_t *target) {
 
             th->x = (th->x + th->momx);
             th->y = (th->y + th->momy);
+            P_SyncMobjHot(th);
             P_SetTarget(&th->tracer, target);
         }
         else {
@@ -248,14 +248,39 @@ typedef struct mobj_s {
     // [d64] misc data for various actions
     void*               extradata;
 
-    // [kex] stuff that happens in between tics
-    fixed_t             frame_x;
-    fixed_t             frame_y;
-    fixed_t             frame_z;
-
     // [kex] mobj reference id
     unsigned int        refcount;
 
+    // slot in mobjhot
+    int                 hotindex;
+
 } mobj_t;
 
+//
+// Mirror of the few mobj fields that get walked over every tic,
+// kept in index-addressed arrays so that the passes over them
+// don't have to drag whole mobjs through the cache. x, y and
+// radius are always up to date (they're refreshed whenever a
+// thing is linked into the blockmap), z only once a thing has
+// had its turn. bnext mirrors the blockmap links, -1 ends the
+// list. frame_* is where things were at the start of the tic,
+// for interpolation. Free slots have a NULL mobj
+//
+typedef struct {
+    int         count;
+    int         max;
+    int         freeslot;
+    mobj_t**    mobj;
+    fixed_t*    x;
+    fixed_t*    y;
+    fixed_t*    z;
+    fixed_t*    radius;
+    int*        bnext;
+    fixed_t*    frame_x;
+    fixed_t*    frame_y;
+    fixed_t*    frame_z;
+} mobjhot_t;
+
+extern mobjhot_t mobjhot;
+
 #endif
@@ -28,6 +28,7 @@
 //-----------------------------------------------------------------------------
 
 #include <time.h> // [kex] - for saving the date and time
+#include <zlib.h>
 
 #include "i_system.h"
 #include "g_game.h"
@@ -40,7 +41,10 @@
 #include "p_saveg.h"
 #include "d_englsh.h"
 #include "m_misc.h"
+#include "m_random.h"
 #include "doomdef.h" // added just so MSVC would shut up about warning C4761
+#include "con_console.h"
+#include "i_thread.h"
 
 void G_DoLoadLevel(void);
 
@@ -51,11 +55,42 @@ void G_DoLoadLevel(void);
 #define SAVEGAME_EOF    0x464F45
 #define SAVEGAME_MOBJ   0x4A424F4D
 
-static FILE*    save_stream;
+//
+// compressed container. the leading byte can't start a
+// description so older, uncompressed saves still load
+//
+
+#define SAVEGAME_ZMAGIC     "\x89" "DSG"
+#define SAVEGAME_ZVERSION   1
+#define SAVEGAME_ZHEADER    12
+
+CVAR_EXTERNAL(p_savecompress);
+CVAR_EXTERNAL(p_savethread);
+
 static byte*    savebuffer;
 
+// the save is serialized into this buffer and written out in one go.
+// it is malloc'd since ownership passes to the write job
+static byte*            save_out = NULL;
+static unsigned long    save_outsize = 0;
+
+typedef struct {
+    byte*           data;
+    unsigned long   size;
+    dboolean        compress;
+    dboolean        failed;
+    char            name[256];
+} savejob_t;
+
+static savejob_t    savejob;
+static jobgroup_t*  savegroup = NULL;
+static dboolean     savepending = false;
+
 static unsigned long save_offset = 0;
 
+// when set, all output is folded into this hash instead of the file
+static unsigned int* save_hash = NULL;
+
 //
 // P_GetSaveGameName
 //
@@ -87,9 +122,31 @@ static byte saveg_read8(void) {
     return result;
 }
 
+static void saveg_grow_output(void) {
+    unsigned long size = save_outsize ? save_outsize * 2 : SAVEGAMESIZE;
+    byte* out = (byte*)realloc(save_out, size);
+
+    if(out == NULL) {
+        I_Error("saveg_grow_output: failed on allocation of %lu bytes", size);
+    }
+
+    save_out = out;
+    save_outsize = size;
+}
+
 static void saveg_write8(byte value) {
-    fwrite(&value, 1, 1, save_stream);
-    save_offset++;
+    if(save_hash) {
+        // FNV-1a
+        save_offset++;
+        *save_hash = (*save_hash ^ value) * 16777619u;
+        return;
+    }
+
+    if(save_offset >= save_outsize) {
+        saveg_grow_output();
+    }
+
+    save_out[save_offset++] = value;
 }
 
 static short saveg_read16(void) {
@@ -366,9 +423,9 @@ static void saveg_write_mobj_t(mobj_t* mo) {
     saveg_write32(mo->player ? mo->player - players + 1 : 0);
     saveg_write_mapthing_t(&mo->spawnpoint);
     saveg_write_mobjindex(mo->tracer);
-    saveg_write32(mo->frame_x);
-    saveg_write32(mo->frame_y);
-    saveg_write32(mo->frame_z);
+    saveg_write32(mobjhot.frame_x[mo->hotindex]);
+    saveg_write32(mobjhot.frame_y[mo->hotindex]);
+    saveg_write32(mobjhot.frame_z[mo->hotindex]);
     saveg_write32(mo->mobjfunc == P_RespawnSpecials ? 1 : 0);
 }
 
@@ -416,9 +473,11 @@ static void saveg_read_mobj_t(mobj_t* mo) {
 
     saveg_set_mobjtarget(&mo->tracer, saveg_read_mobjindex());
 
-    mo->frame_x         = saveg_read32();
-    mo->frame_y         = saveg_read32();
-    mo->frame_z         = saveg_read32();
+    P_AddMobjHot(mo);
+
+    mobjhot.frame_x[mo->hotindex] = saveg_read32();
+    mobjhot.frame_y[mo->hotindex] = saveg_read32();
+    mobjhot.frame_z[mo->hotindex] = saveg_read32();
     mo->mobjfunc        = saveg_read32() ? P_RespawnSpecials : NULL;
 }
 
@@ -1213,22 +1272,111 @@ static void saveg_write_marker(int marker) {
     saveg_write32(marker);
 }
 
+//
+// saveg_write_file
+// Compresses (optionally) and writes out a serialized save. Writes
+// to a temporary file first and renames it over the old save so a
+// failed write never leaves a truncated save behind. Can run on a
+// worker thread, so no zone or console calls in here
+//
+
+static void saveg_write_file(void* data) {
+    savejob_t*      job = (savejob_t*)data;
+    char            tmpname[260];
+    FILE*           fp;
+    byte*           zbuf = NULL;
+    byte*           out = job->data;
+    unsigned long   outsize = job->size;
+    dboolean        ok;
+
+    if(job->compress) {
+        uLongf zsize = compressBound(job->size);
+
+        zbuf = (byte*)malloc(zsize + SAVEGAME_ZHEADER);
+
+        if(zbuf && compress2(zbuf + SAVEGAME_ZHEADER, &zsize, job->data,
+                             job->size, Z_BEST_SPEED) == Z_OK) {
+            memcpy(zbuf, SAVEGAME_ZMAGIC, 4);
+            zbuf[4] = SAVEGAME_ZVERSION;
+            zbuf[5] = zbuf[6] = zbuf[7] = 0;
+            zbuf[8] = job->size & 0xff;
+            zbuf[9] = (job->size >> 8) & 0xff;
+            zbuf[10] = (job->size >> 16) & 0xff;
+            zbuf[11] = (job->size >> 24) & 0xff;
+
+            out = zbuf;
+            outsize = zsize + SAVEGAME_ZHEADER;
+        }
+    }
+
+    sprintf(tmpname, "%s.tmp", job->name);
+
+    if((fp = fopen(tmpname, "wb"))) {
+        ok = (fwrite(out, 1, outsize, fp) == outsize);
+        ok = (fclose(fp) == 0) && ok;
+
+        if(ok) {
+#ifdef _WIN32
+            // rename won't replace an existing file here
+            remove(job->name);
+#endif
+            ok = (rename(tmpname, job->name) == 0);
+        }
+
+        if(!ok) {
+            remove(tmpname);
+        }
+    }
+    else {
+        ok = false;
+    }
+
+    free(zbuf);
+    free(job->data);
+
+    job->data = NULL;
+    job->failed = !ok;
+}
+
+//
+// P_FinishSaveGame
+// Waits for a save being written in the background
+//
+
+void P_FinishSaveGame(void) {
+    if(!savepending) {
+        return;
+    }
+
+    I_WaitJobGroup(savegroup);
+    savepending = false;
+
+    if(savejob.failed) {
+        CON_Warnf("P_FinishSaveGame: couldn't write %s\n", savejob.name);
+    }
+}
+
 //
 // P_WriteSaveGame
 //
 
 dboolean P_WriteSaveGame(char* description, int slot) {
-    //char name[256];
+    char tmpname[260];
+    FILE* fp;
 
-    // setup game save file
-    // sprintf(name, SAVEGAMENAME"%d.dsg", slot);
-    save_stream = fopen(P_GetSaveGameName(slot), "wb");
+    // only one save in flight at a time
+    P_FinishSaveGame();
 
-    // success?
-    if(save_stream == NULL) {
+    // make sure the save can be created before doing the work.
+    // the writer truncates this same temporary file
+    sprintf(tmpname, "%s.tmp", P_GetSaveGameName(slot));
+
+    if(!(fp = fopen(tmpname, "wb"))) {
         return false;
     }
 
+    fclose(fp);
+
     save_offset = 0;
 
     saveg_write_header(description);
@@ -1241,10 +1389,71 @@ dboolean P_WriteSaveGame(char* description, int slot) {
 
     saveg_write_marker(SAVEGAME_EOF);
 
-    // close out file
-    fclose(save_stream);
+    // hand the buffer over to the writer
+    savejob.data = save_out;
+    savejob.size = save_offset;
+    savejob.compress = (p_savecompress.value > 0);
+    savejob.failed = false;
+    dstrncpy(savejob.name, P_GetSaveGameName(slot), sizeof(savejob.name) - 1);
 
-    return true;
+    save_out = NULL;
+    save_outsize = 0;
+
+    if(p_savethread.value > 0 && I_NumWorkers() > 0) {
+        if(!savegroup) {
+            savegroup = I_CreateJobGroup();
+        }
+
+        savepending = true;
+        I_QueueJob(savegroup, saveg_write_file, &savejob);
+
+        return true;
+    }
+
+    saveg_write_file(&savejob);
+
+    return !savejob.failed;
+}
+
+//
+// saveg_read_file
+// Loads a save into savebuffer, inflating it if needed
+//
+
+static int saveg_read_file(char* name) {
+    int     length;
+    uLongf  size;
+    byte*   data;
+
+    // a save to this file may still be on its way out
+    P_FinishSaveGame();
+
+    if((length = M_ReadFile(name, &savebuffer)) == -1) {
+        return -1;
+    }
+
+    if(length < SAVEGAME_ZHEADER || memcmp(savebuffer, SAVEGAME_ZMAGIC, 4)) {
+        return length;
+    }
+
+    if(savebuffer[4] != SAVEGAME_ZVERSION) {
+        I_Error("saveg_read_file: %s has unknown version %i", name, savebuffer[4]);
+    }
+
+    size = savebuffer[8] | (savebuffer[9] << 8) |
+           (savebuffer[10] << 16) | (savebuffer[11] << 24);
+
+    data = (byte*)Z_Malloc(size, PU_STATIC, 0);
+
+    if(uncompress(data, &size, savebuffer + SAVEGAME_ZHEADER,
+                  length - SAVEGAME_ZHEADER) != Z_OK) {
+        I_Error("saveg_read_file: %s is corrupt", name);
+    }
+
+    Z_Free(savebuffer);
+    savebuffer = data;
+
+    return (int)size;
 }
 
 //
@@ -1252,7 +1461,10 @@ dboolean P_WriteSaveGame(char* description, int slot) {
 //
 
 dboolean P_ReadSaveGame(char* name) {
-    M_ReadFile(name, &savebuffer);
+    if(saveg_read_file(name) == -1) {
+        return false;
+    }
+
     save_offset = 0;
 
     saveg_read_header();
@@ -1285,7 +1497,7 @@ dboolean P_QuickReadSaveHeader(char* name, char* date,
     int i;
     int size;
 
-    if(M_ReadFile(name, &savebuffer) == -1) {
+    if(saveg_read_file(name) == -1) {
         return 0;
     }
 
@@ -1490,6 +1702,8 @@ void P_UnArchiveWorld(void) {
         saveg_read_pad();
         light->tag          = saveg_read16();
     }
+
+    P_ResetSectorLists();
 }
 
 
@@ -1943,3 +2157,128 @@ void P_UnArchiveMacros(void) {
 }
 
 
+
+//------------------------------------------------------------------------
+//
+// Game state hashing
+//
+//------------------------------------------------------------------------
+
+const char* statehashnames[NUMSTATEHASH] = {
+    "random",
+    "players",
+    "sectors",
+    "mobj.position",
+    "mobj.momentum",
+    "mobj.state",
+    "mobj.health",
+    "thinkers"
+};
+
+//
+// saveg_hash32
+//
+
+static void saveg_hash32(unsigned int* hash, int value) {
+    save_hash = hash;
+    saveg_write32(value);
+    save_hash = NULL;
+}
+
+//
+// P_HashGameState
+// Computes a hash for each part of the game state, walking
+// everything in the same order as the archive functions. Two
+// runs of the same demo must produce identical hashes every tic
+//
+
+void P_HashGameState(unsigned int* hashes) {
+    int         i;
+    sector_t    *sec;
+    mobj_t      *mobj;
+
+    for(i = 0; i < NUMSTATEHASH; i++) {
+        hashes[i] = 2166136261u;
+    }
+
+    saveg_setup_mobjwrite();
+
+    //
+    // random number generator
+    //
+    for(i = 0; i < NUMPRCLASS; i++) {
+        saveg_hash32(&hashes[sh_random], rng.seed[i]);
+    }
+
+    saveg_hash32(&hashes[sh_random], rng.rndindex);
+    saveg_hash32(&hashes[sh_random], rng.prndindex);
+    saveg_hash32(&hashes[sh_random], basetic);
+
+    //
+    // players
+    //
+    save_hash = &hashes[sh_players];
+    P_ArchivePlayers();
+    save_hash = NULL;
+
+    //
+    // sectors
+    //
+    for(i = 0, sec = sectors; i < numsectors; i++, sec++) {
+        unsigned int* h = &hashes[sh_sectors];
+        int j;
+
+        saveg_hash32(h, sec->floorheight);
+        saveg_hash32(h, sec->ceilingheight);
+        saveg_hash32(h, sec->special);
+        saveg_hash32(h, sec->flags);
+        saveg_hash32(h, sec->lightlevel);
+        saveg_hash32(h, sec->xoffset);
+        saveg_hash32(h, sec->yoffset);
+        saveg_hash32(h, sec->soundtarget != NULL);
+
+        for(j = 0; j < 5; j++) {
+            saveg_hash32(h, sec->colors[j]);
+        }
+    }
+
+    //
+    // mobjs
+    //
+    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
+        // not archived either
+        if(mobj->mobjfunc == P_SafeRemoveMobj) {
+            continue;
+        }
+
+        saveg_hash32(&hashes[sh_mobjpos], mobj->x);
+        saveg_hash32(&hashes[sh_mobjpos], mobj->y);
+        saveg_hash32(&hashes[sh_mobjpos], mobj->z);
+        saveg_hash32(&hashes[sh_mobjpos], mobj->angle);
+
+        saveg_hash32(&hashes[sh_mobjmom], mobj->momx);
+        saveg_hash32(&hashes[sh_mobjmom], mobj->momy);
+        saveg_hash32(&hashes[sh_mobjmom], mobj->momz);
+
+        saveg_hash32(&hashes[sh_mobjstate], mobj->type);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->state - states);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->tics);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->flags);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->movedir);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->movecount);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->reactiontime);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->threshold);
+        saveg_hash32(&hashes[sh_mobjstate], mobj->validcount);
+
+        saveg_hash32(&hashes[sh_mobjhealth], mobj->health);
+        saveg_hash32(&hashes[sh_mobjhealth], mobj->target != NULL);
+    }
+
+    //
+    // thinker payloads and macro state
+    //
+    save_hash = &hashes[sh_thinkers];
+    P_ArchiveSpecials();
+    P_ArchiveMacros();
+    save_hash = NULL;
+}
@@ -39,6 +39,7 @@ char *P_GetSaveGameName(int num);
 dboolean P_WriteSaveGame(char* description, int slot);
 dboolean P_ReadSaveGame(char* name);
 dboolean P_QuickReadSaveHeader(char* name, char* date, int* thumbnail, int* skill, int* map);
+void P_FinishSaveGame(void);
 
 // Persistent storage/archiving.
 // These are the load / save game routines.
@@ -53,4 +54,21 @@ void P_UnArchiveSpecials(void);
 void P_ArchiveMacros(void);
 void P_UnArchiveMacros(void);
 
+// Per-tic state hashing, used for checking demo determinism
+typedef enum {
+    sh_random,
+    sh_players,
+    sh_sectors,
+    sh_mobjpos,
+    sh_mobjmom,
+    sh_mobjstate,
+    sh_mobjhealth,
+    sh_thinkers,
+    NUMSTATEHASH
+} statehash_t;
+
+extern const char* statehashnames[NUMSTATEHASH];
+
+void P_HashGameState(unsigned int* hashes);
+
 #endif
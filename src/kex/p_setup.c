@@ -98,6 +98,9 @@ CVAR(p_sdoubleclick, 0);
 CVAR(p_usecontext, 0);
 CVAR(p_damageindicator, 0);
 CVAR(p_regionmode, 0);
+CVAR(p_savecompress, 1);
+CVAR(p_savethread, 1);
+CVAR(p_sightpvs, 1);
 
 //
 // [kex] sky definition stuff
@@ -1072,6 +1075,8 @@ void P_SetupLevel(int map, int playermask, skill_t skill) {
     P_LoadReject(ML_REJECT);
     P_LoadLights(ML_LIGHTS);
     P_GroupLines();
+    P_InitSight();
+    P_InitSoundGraph();
     P_LoadThings(ML_THINGS);
     W_FreeMapLump();
 
@@ -1470,6 +1475,7 @@ void P_Init(void) {
     R_InitSprites(sprnames);
     P_InitMapInfo();
     P_InitSkyDef();
+    P_RegisterMobjCommands();
 }
 
 //
@@ -1479,6 +1485,9 @@ void P_Init(void) {
 void P_RegisterCvars(void) {
     CON_CvarRegister(&p_features);
     CON_CvarRegister(&p_autorun);
+    CON_CvarRegister(&p_savecompress);
+    CON_CvarRegister(&p_savethread);
+    CON_CvarRegister(&p_sightpvs);
     CON_CvarRegister(&p_fdoubleclick);
     CON_CvarRegister(&p_sdoubleclick);
     CON_CvarRegister(&p_usecontext);
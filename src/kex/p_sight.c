@@ -27,24 +27,61 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <math.h>
+
 #include "doomdef.h"
 #include "m_fixed.h"
 #include "i_system.h"
+#include "i_thread.h"
 #include "p_local.h"
+#include "z_zone.h"
 #include "doomstat.h"
+#include "con_console.h"
 
-//
-// P_CheckSight
-//
-fixed_t     sightzstart;        // eye z of looker
+// slopes to top and bottom of target, also used by the
+// aiming/shooting traces in p_map.c
 fixed_t     topslope;
-fixed_t     bottomslope;        // slopes to top and bottom of target
+fixed_t     bottomslope;
 
-divline_t   strace;             // from t1 to t2
-fixed_t     t2x;
-fixed_t     t2y;
+// rejected by REJECT, traced, culled by the pvs, passed by the pvs
+int         sightcounts[4];
 
-int         sightcounts[2];
+CVAR_EXTERNAL(p_sightpvs);
+
+//
+// sight trace state. one of these per P_CheckSight call so
+// that P_ScanSights can run traces on several threads at once
+//
+
+typedef struct {
+    fixed_t     sightzstart;        // eye z of looker
+    fixed_t     topslope;
+    fixed_t     bottomslope;        // slopes to top and bottom of target
+    divline_t   strace;             // from t1 to t2
+    fixed_t     t2x;
+    fixed_t     t2y;
+    int*        linestamps;         // per line checked stamps. NULL uses line->validcount
+    int         stamp;
+    int         counts[4];          // same as sightcounts
+} sightcontext_t;
+
+#define MAXSIGHTJOBS        16
+#define MINSIGHTSPERJOB     16
+
+typedef struct {
+    sightcontext_t  context;
+    int             start;
+    int             end;
+} sightjob_t;
+
+static sightjob_t   sightjobs[MAXSIGHTJOBS];
+static int          numsightjobs = 0;
+static jobgroup_t*  sightgroup = NULL;
+
+// mobjs queued up by P_ScanSights and their results
+static mobj_t**     sightmobjs = NULL;
+static byte*        sightresults = NULL;
+static int          maxsightmobjs = 0;
 
 
 //
@@ -131,7 +168,7 @@ fixed_t P_InterceptVector2(divline_t* v2, divline_t* v1) {
 // Returns true if strace crosses the given subsector successfully.
 //
 
-dboolean P_CrossSubsector(int num) {
+static dboolean P_CrossSubsector(sightcontext_t* sc, int num) {
     seg_t*          seg;
     line_t*         line;
     int             s1;
@@ -168,16 +205,27 @@ dboolean P_CrossSubsector(int num) {
         }
 
         // allready checked other side?
-        if(line->validcount == validcount) {
-            continue;
+        if(sc->linestamps) {
+            int* stamp = &sc->linestamps[line - lines];
+
+            if(*stamp == sc->stamp) {
+                continue;
+            }
+
+            *stamp = sc->stamp;
         }
+        else {
+            if(line->validcount == validcount) {
+                continue;
+            }
 
-        line->validcount = validcount;
+            line->validcount = validcount;
+        }
 
         v1 = line->v1;
         v2 = line->v2;
-        s1 = P_DivlineSide(v1->x,v1->y, &strace);
-        s2 = P_DivlineSide(v2->x, v2->y, &strace);
+        s1 = P_DivlineSide(v1->x,v1->y, &sc->strace);
+        s2 = P_DivlineSide(v2->x, v2->y, &sc->strace);
 
         // line isn't crossed?
         if(s1 == s2) {
@@ -188,8 +236,8 @@ dboolean P_CrossSubsector(int num) {
         divl.y = v1->y;
         divl.dx = v2->x - v1->x;
         divl.dy = v2->y - v1->y;
-        s1 = P_DivlineSide(strace.x, strace.y, &divl);
-        s2 = P_DivlineSide(t2x, t2y, &divl);
+        s1 = P_DivlineSide(sc->strace.x, sc->strace.y, &divl);
+        s2 = P_DivlineSide(sc->t2x, sc->t2y, &divl);
 
         // line isn't crossed?
         if(s1 == s2) {
@@ -234,23 +282,23 @@ dboolean P_CrossSubsector(int num) {
             return false;    // stop
         }
 
-        frac = P_InterceptVector2(&strace, &divl);
+        frac = P_InterceptVector2(&sc->strace, &divl);
 
         if(front->floorheight != back->floorheight) {
-            slope = FixedDiv(openbottom - sightzstart , frac);
-            if(slope > bottomslope) {
-                bottomslope = slope;
+            slope = FixedDiv(openbottom - sc->sightzstart , frac);
+            if(slope > sc->bottomslope) {
+                sc->bottomslope = slope;
             }
         }
 
         if(front->ceilingheight != back->ceilingheight) {
-            slope = FixedDiv(opentop - sightzstart , frac);
-            if(slope < topslope) {
-                topslope = slope;
+            slope = FixedDiv(opentop - sc->sightzstart , frac);
+            if(slope < sc->topslope) {
+                sc->topslope = slope;
             }
         }
 
-        if(topslope <= bottomslope) {
+        if(sc->topslope <= sc->bottomslope) {
             return false;    // stop
         }
     }
@@ -266,50 +314,587 @@ dboolean P_CrossSubsector(int num) {
 // Returns true if strace crosses the given node successfully.
 //
 
-dboolean P_CrossBSPNode(int bspnum) {
+static dboolean P_CrossBSPNode(sightcontext_t* sc, int bspnum) {
     node_t* bsp;
     int     side;
 
     if(bspnum & NF_SUBSECTOR) {
         if(bspnum == -1) {
-            return P_CrossSubsector(0);
+            return P_CrossSubsector(sc, 0);
         }
         else {
-            return P_CrossSubsector(bspnum&(~NF_SUBSECTOR));
+            return P_CrossSubsector(sc, bspnum&(~NF_SUBSECTOR));
         }
     }
 
     bsp = &nodes[bspnum];
 
     // decide which side the start point is on
-    side = P_DivlineSide(strace.x, strace.y, (divline_t *)bsp);
+    side = P_DivlineSide(sc->strace.x, sc->strace.y, (divline_t *)bsp);
     if(side == 2) {
         side = 0;    // an "on" should cross both sides
     }
 
     // cross the starting side
-    if(!P_CrossBSPNode(bsp->children[side])) {
+    if(!P_CrossBSPNode(sc, bsp->children[side])) {
         return false;
     }
 
     // the partition plane is crossed here
-    if(side == P_DivlineSide(t2x, t2y,(divline_t *)bsp)) {
+    if(side == P_DivlineSide(sc->t2x, sc->t2y,(divline_t *)bsp)) {
         // the line doesn't touch the other side
         return true;
     }
 
     // cross the ending side
-    return P_CrossBSPNode(bsp->children[side^1]);
+    return P_CrossBSPNode(sc, bsp->children[side^1]);
 }
 
 
+//------------------------------------------------------------------------
 //
-// P_CheckSight
+// Subsector visibility
+//
+// A conservative subsector to subsector PVS, built at level setup by
+// flooding through the portals (two sided lines and minisegs) out of
+// each subsector. A portal is only entered if it is partly in front of
+// both the first portal of the chain and the one it was reached from,
+// which any straight line through the chain must satisfy. Portals are
+// only ever closed if both sectors are shut and can never move.
+//
+//------------------------------------------------------------------------
+
+#define MAXPVSSUBSECTORS    8192
+#define PVSEPSILON          2.0     // in map units
+
+typedef struct {
+    int     from;
+    int     to;
+    double  a[2];
+    double  b[2];
+    double  normal[2];  // faces into 'to'
+    double  dist;
+} sightportal_t;
+
+typedef struct {
+    int     ss;
+    int     v1;
+    int     v2;
+    int     matched;
+    seg_t*  seg;
+} pvsedge_t;
+
+static byte*            sightpvs = NULL;
+static int              pvsrowbytes = 0;
+static sightportal_t*   pvsportals = NULL;
+static int              numpvsportals = 0;
+static int*             pvsfirstportal = NULL;  // [numsubsectors + 1]
+
+typedef struct {
+    int     start;
+    int     end;
+} pvsjob_t;
+
+//
+// P_SectorCanMove
+// Anything tagged or sitting behind a special line might
+// have its floor or ceiling moved at some point
+//
+
+static dboolean P_SectorCanMove(sector_t* sec, byte* moving) {
+    return sec->tag || sec->special || moving[sec - sectors];
+}
+
+//
+// P_PortalIsShut
+//
+
+static dboolean P_PortalIsShut(seg_t* seg, byte* moving) {
+    sector_t* front;
+    sector_t* back;
+
+    if(!seg || !seg->linedef) {
+        return false;
+    }
+
+    front = seg->frontsector;
+    back = seg->backsector;
+
+    if(!back || !(seg->linedef->flags & ML_TWOSIDED)) {
+        return true;
+    }
+
+    if(P_SectorCanMove(front, moving) || P_SectorCanMove(back, moving)) {
+        return false;
+    }
+
+    return MAX(front->floorheight, back->floorheight) >=
+           MIN(front->ceilingheight, back->ceilingheight);
+}
+
+//
+// P_EdgeSeg
+// Finds the seg lying on the leaf edge v1 -> v2, NULL if it's a miniseg
+//
+
+static seg_t* P_EdgeSeg(leaf_t* l1, leaf_t* l2) {
+    if(l1->seg && l1->seg->v1 == l1->vertex && l1->seg->v2 == l2->vertex) {
+        return l1->seg;
+    }
+
+    if(l2->seg && l2->seg->v1 == l1->vertex && l2->seg->v2 == l2->vertex) {
+        return l2->seg;
+    }
+
+    return l1->seg;
+}
+
+//
+// P_SortEdges
+//
+
+static int P_SortEdges(const void* a, const void* b) {
+    const pvsedge_t* ea = (const pvsedge_t*)a;
+    const pvsedge_t* eb = (const pvsedge_t*)b;
+    int ka1 = MIN(ea->v1, ea->v2);
+    int ka2 = MAX(ea->v1, ea->v2);
+    int kb1 = MIN(eb->v1, eb->v2);
+    int kb2 = MAX(eb->v1, eb->v2);
+
+    if(ka1 != kb1) {
+        return ka1 - kb1;
+    }
+
+    return ka2 - kb2;
+}
+
+//
+// P_SortPortals
+//
+
+static int P_SortPortals(const void* a, const void* b) {
+    return ((const sightportal_t*)a)->from - ((const sightportal_t*)b)->from;
+}
+
+//
+// P_AddPortal
+// Adds a portal from the subsector of e1 into the subsector of
+// e2, covering the part of e1 that overlaps e2
+//
+
+static void P_AddPortal(pvsedge_t* e1, pvsedge_t* e2) {
+    sightportal_t*  p = &pvsportals[numpvsportals++];
+    vertex_t*       a = &vertexes[e1->v1];
+    vertex_t*       b = &vertexes[e1->v2];
+    subsector_t*    ss = &subsectors[e1->ss];
+    double          dx;
+    double          dy;
+    double          len;
+    double          t1;
+    double          t2;
+    double          t;
+    double          cx = 0;
+    double          cy = 0;
+    int             i;
+
+    dx = F2D3D(b->x - a->x);
+    dy = F2D3D(b->y - a->y);
+    len = dx * dx + dy * dy;
+
+    // clip to the overlapping part of the other edge
+    t1 = ((F2D3D(vertexes[e2->v1].x - a->x) * dx) + (F2D3D(vertexes[e2->v1].y - a->y) * dy)) / len;
+    t2 = ((F2D3D(vertexes[e2->v2].x - a->x) * dx) + (F2D3D(vertexes[e2->v2].y - a->y) * dy)) / len;
+
+    if(t1 > t2) {
+        t = t1;
+        t1 = t2;
+        t2 = t;
+    }
+
+    t1 = MAX(t1, 0);
+    t2 = MIN(t2, 1);
+
+    p->from = e1->ss;
+    p->to = e2->ss;
+    p->a[0] = F2D3D(a->x) + dx * t1;
+    p->a[1] = F2D3D(a->y) + dy * t1;
+    p->b[0] = F2D3D(a->x) + dx * t2;
+    p->b[1] = F2D3D(a->y) + dy * t2;
+
+    len = sqrt(len);
+    p->normal[0] = dy / len;
+    p->normal[1] = -dx / len;
+
+    // make the normal point away from the subsector we start from
+    for(i = 0; i < ss->numleafs; i++) {
+        cx += F2D3D(leafs[ss->leaf + i].vertex->x);
+        cy += F2D3D(leafs[ss->leaf + i].vertex->y);
+    }
+
+    cx /= ss->numleafs;
+    cy /= ss->numleafs;
+
+    if(((cx - F2D3D(a->x)) * p->normal[0]) + ((cy - F2D3D(a->y)) * p->normal[1]) > 0) {
+        p->normal[0] = -p->normal[0];
+        p->normal[1] = -p->normal[1];
+    }
+
+    p->dist = (F2D3D(a->x) * p->normal[0]) + (F2D3D(a->y) * p->normal[1]);
+}
+
+//
+// P_EdgesOverlap
+// True if the two edges are on the same line, facing
+// each other and share more than a point
+//
+
+static dboolean P_EdgesOverlap(pvsedge_t* e1, pvsedge_t* e2) {
+    vertex_t* a = &vertexes[e1->v1];
+    vertex_t* b = &vertexes[e1->v2];
+    vertex_t* c = &vertexes[e2->v1];
+    vertex_t* d = &vertexes[e2->v2];
+    int64 dx = (int64)(b->x - a->x) >> FRACBITS;
+    int64 dy = (int64)(b->y - a->y) >> FRACBITS;
+    int64 t1;
+    int64 t2;
+
+    if(e1->ss == e2->ss) {
+        return false;
+    }
+
+    // collinear?
+    if(dx * (((int64)c->y - a->y) >> FRACBITS) != dy * (((int64)c->x - a->x) >> FRACBITS) ||
+            dx * (((int64)d->y - a->y) >> FRACBITS) != dy * (((int64)d->x - a->x) >> FRACBITS)) {
+        return false;
+    }
+
+    // facing the other way?
+    if(dx * (((int64)d->x - c->x) >> FRACBITS) + dy * (((int64)d->y - c->y) >> FRACBITS) >= 0) {
+        return false;
+    }
+
+    t1 = dx * (((int64)c->x - a->x) >> FRACBITS) + dy * (((int64)c->y - a->y) >> FRACBITS);
+    t2 = dx * (((int64)d->x - a->x) >> FRACBITS) + dy * (((int64)d->y - a->y) >> FRACBITS);
+
+    return MAX(t1, t2) > 0 && MIN(t1, t2) < dx * dx + dy * dy;
+}
+
+//
+// P_BuildSightPortals
+// Returns false if the leafs don't give a closed set of portals
+//
+
+static dboolean P_BuildSightPortals(void) {
+    pvsedge_t*  edges;
+    pvsedge_t*  sorted;
+    int         numedges = 0;
+    int         maxedges = 0;
+    byte*       moving;
+    int         unmatched = 0;
+    dboolean    overflow = false;
+    int         i;
+    int         j;
+
+    moving = (byte*)Z_Calloc(numsectors, PU_STATIC, 0);
+
+    // sectors behind special lines are manual doors, lifts...
+    for(i = 0; i < numlines; i++) {
+        if(lines[i].special && lines[i].backsector) {
+            moving[lines[i].backsector - sectors] = 1;
+        }
+    }
+
+    for(i = 0; i < numsubsectors; i++) {
+        maxedges += subsectors[i].numleafs;
+    }
+
+    edges = (pvsedge_t*)Z_Malloc(sizeof(pvsedge_t) * maxedges, PU_STATIC, 0);
+
+    for(i = 0; i < numsubsectors; i++) {
+        subsector_t* ss = &subsectors[i];
+
+        if(ss->numleafs < 3) {
+            continue;
+        }
+
+        for(j = 0; j < ss->numleafs; j++) {
+            leaf_t* l1 = &leafs[ss->leaf + j];
+            leaf_t* l2 = &leafs[ss->leaf + ((j + 1) % ss->numleafs)];
+            seg_t* seg = P_EdgeSeg(l1, l2);
+
+            if(P_PortalIsShut(seg, moving)) {
+                continue;
+            }
+
+            edges[numedges].ss = i;
+            edges[numedges].v1 = l1->vertex - vertexes;
+            edges[numedges].v2 = l2->vertex - vertexes;
+            edges[numedges].matched = 0;
+            edges[numedges].seg = seg;
+            numedges++;
+        }
+    }
+
+    Z_Free(moving);
+
+    // each portal edge should have a twin going the other way
+    sorted = (pvsedge_t*)Z_Malloc(sizeof(pvsedge_t) * numedges, PU_STATIC, 0);
+    dmemcpy(sorted, edges, sizeof(pvsedge_t) * numedges);
+    qsort(sorted, numedges, sizeof(pvsedge_t), P_SortEdges);
+
+    // two portals per pair at most, plus t-junction pieces
+    pvsportals = (sightportal_t*)Z_Malloc(sizeof(sightportal_t) * numedges * 2, PU_LEVEL, 0);
+    numpvsportals = 0;
+
+    for(i = 0; i < numedges; i = j) {
+        for(j = i + 1; j < numedges && !P_SortEdges(&sorted[i], &sorted[j]); j++);
+
+        if(j - i == 2 && sorted[i].v1 == sorted[i + 1].v2 && sorted[i].ss != sorted[i + 1].ss) {
+            P_AddPortal(&sorted[i], &sorted[i + 1]);
+            P_AddPortal(&sorted[i + 1], &sorted[i]);
+            sorted[i].matched = sorted[i + 1].matched = 1;
+        }
+    }
+
+    // edges split on one side but not the other
+    for(i = 0; i < numedges; i++) {
+        if(sorted[i].matched & 1) {
+            continue;
+        }
+
+        for(j = 0; j < numedges; j++) {
+            if(j == i || (sorted[j].matched & 1)) {
+                continue;
+            }
+
+            if(P_EdgesOverlap(&sorted[i], &sorted[j])) {
+                if(numpvsportals >= numedges * 2) {
+                    overflow = true;
+                    break;
+                }
+
+                P_AddPortal(&sorted[i], &sorted[j]);
+                sorted[i].matched |= 2;
+            }
+        }
+
+        if(!sorted[i].matched) {
+            unmatched++;
+        }
+    }
+
+    Z_Free(sorted);
+    Z_Free(edges);
+
+    if(unmatched || overflow) {
+        CON_DPrintf("P_BuildSightPortals: %i portal edges without a twin, no sight pvs\n", unmatched);
+        return false;
+    }
+
+    // index the portals by the subsector they lead out of
+    qsort(pvsportals, numpvsportals, sizeof(sightportal_t), P_SortPortals);
+
+    pvsfirstportal = (int*)Z_Malloc(sizeof(int) * (numsubsectors + 1), PU_LEVEL, 0);
+
+    for(i = 0, j = 0; i <= numsubsectors; i++) {
+        while(j < numpvsportals && pvsportals[j].from < i) {
+            j++;
+        }
+
+        pvsfirstportal[i] = j;
+    }
+
+    return true;
+}
+
+//
+// P_PortalCanSee
+// True if portal 'next' is partly in front of 'prev' and 'prev'
+// is partly behind 'next'
+//
+
+d_inline static dboolean P_PortalCanSee(sightportal_t* prev, sightportal_t* next) {
+    double a;
+    double b;
+
+    a = (next->a[0] * prev->normal[0]) + (next->a[1] * prev->normal[1]) - prev->dist;
+    b = (next->b[0] * prev->normal[0]) + (next->b[1] * prev->normal[1]) - prev->dist;
+
+    if(a <= -PVSEPSILON && b <= -PVSEPSILON) {
+        return false;
+    }
+
+    a = (prev->a[0] * next->normal[0]) + (prev->a[1] * next->normal[1]) - next->dist;
+    b = (prev->b[0] * next->normal[0]) + (prev->b[1] * next->normal[1]) - next->dist;
+
+    if(a >= PVSEPSILON && b >= PVSEPSILON) {
+        return false;
+    }
+
+    return true;
+}
+
+//
+// P_PVSJob
+// Floods out of each subsector in the job's range. Runs on the
+// worker threads; each job only writes its own rows
+//
+
+static void P_PVSJob(void* data) {
+    pvsjob_t*   job = (pvsjob_t*)data;
+    int*        visited;
+    int*        stack;
+    int         stamp = 0;
+    int         s;
+
+    visited = (int*)calloc(numpvsportals, sizeof(int));
+    stack = (int*)malloc(numpvsportals * sizeof(int));
+
+    if(!visited || !stack) {
+        // can't tell, so everything is visible from here
+        for(s = job->start; s < job->end; s++) {
+            dmemset(&sightpvs[s * pvsrowbytes], 0xff, pvsrowbytes);
+        }
+
+        free(visited);
+        free(stack);
+        return;
+    }
+
+    for(s = job->start; s < job->end; s++) {
+        byte*   row = &sightpvs[s * pvsrowbytes];
+        int     p1;
+
+        row[s >> 3] |= 1 << (s & 7);
+
+        for(p1 = pvsfirstportal[s]; p1 < pvsfirstportal[s + 1]; p1++) {
+            sightportal_t*  first = &pvsportals[p1];
+            int             top = 0;
+
+            stamp++;
+            visited[p1] = stamp;
+            row[first->to >> 3] |= 1 << (first->to & 7);
+            stack[top++] = p1;
+
+            while(top) {
+                sightportal_t*  prev = &pvsportals[stack[--top]];
+                int             r;
+
+                for(r = pvsfirstportal[prev->to]; r < pvsfirstportal[prev->to + 1]; r++) {
+                    sightportal_t* next = &pvsportals[r];
+
+                    if(visited[r] == stamp) {
+                        continue;
+                    }
+
+                    if(!P_PortalCanSee(first, next) || !P_PortalCanSee(prev, next)) {
+                        continue;
+                    }
+
+                    visited[r] = stamp;
+                    row[next->to >> 3] |= 1 << (next->to & 7);
+                    stack[top++] = r;
+                }
+            }
+        }
+    }
+
+    free(visited);
+    free(stack);
+}
+
+//
+// P_BuildSightPVS
+//
+
+static void P_BuildSightPVS(void) {
+    pvsjob_t    jobs[MAXSIGHTJOBS * 4];
+    jobgroup_t* group;
+    int         numjobs;
+    int         starttime;
+    int         i;
+
+    sightpvs = NULL;
+
+    if(p_sightpvs.value <= 0 || numsubsectors > MAXPVSSUBSECTORS) {
+        return;
+    }
+
+    starttime = I_GetTimeMS();
+
+    if(!P_BuildSightPortals()) {
+        return;
+    }
+
+    pvsrowbytes = (numsubsectors + 7) >> 3;
+    sightpvs = (byte*)Z_Calloc(pvsrowbytes * numsubsectors, PU_LEVEL, 0);
+
+    // small chunks so the workers stay busy on uneven maps
+    numjobs = MIN((I_NumWorkers() + 1) * 4, MAXSIGHTJOBS * 4);
+    numjobs = MIN(numjobs, numsubsectors);
+
+    group = I_CreateJobGroup();
+
+    for(i = 0; i < numjobs; i++) {
+        jobs[i].start = (numsubsectors * i) / numjobs;
+        jobs[i].end = (numsubsectors * (i + 1)) / numjobs;
+
+        I_QueueJob(group, P_PVSJob, &jobs[i]);
+    }
+
+    I_DestroyJobGroup(group);
+
+    // subsectors without a proper shape can see and be seen by anything
+    for(i = 0; i < numsubsectors; i++) {
+        if(subsectors[i].numleafs < 3) {
+            int j;
+
+            dmemset(&sightpvs[i * pvsrowbytes], 0xff, pvsrowbytes);
+
+            for(j = 0; j < numsubsectors; j++) {
+                sightpvs[j * pvsrowbytes + (i >> 3)] |= 1 << (i & 7);
+            }
+        }
+    }
+
+    CON_DPrintf("P_BuildSightPVS: %i portals, %i ms\n", numpvsportals, I_GetTimeMS() - starttime);
+}
+
+//
+// P_CheckSightPVS
+// False if t1 can't possibly see t2
+//
+
+d_inline static dboolean P_CheckSightPVS(sightcontext_t* sc, mobj_t* t1, mobj_t* t2) {
+    int s1;
+    int s2;
+
+    // keep demos and netgames on the exact old behavior
+    if(!sightpvs || demoplayback || demorecording || netgame) {
+        return true;
+    }
+
+    s1 = t1->subsector - subsectors;
+    s2 = t2->subsector - subsectors;
+
+    if(sightpvs[s1 * pvsrowbytes + (s2 >> 3)] & (1 << (s2 & 7))) {
+        sc->counts[3]++;
+        return true;
+    }
+
+    sc->counts[2]++;
+    return false;
+}
+
+//
+// P_CheckSightContext
 // Returns true if a straight line between t1 and t2 is unobstructed.
-// Uses REJECT.
+// Uses REJECT. Only reads map and mobj data besides the context,
+// so this is safe to run on a worker thread when the context has
+// its own line stamps.
 //
 
-dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
+static dboolean P_CheckSightContext(sightcontext_t* sc, mobj_t* t1, mobj_t* t2) {
     int     s1;
     int     s2;
     int     pnum;
@@ -327,42 +912,131 @@ dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
 
     // Check in REJECT table.
     if(rejectmatrix[bytenum]&bitnum) {
-        sightcounts[0]++;
+        sc->counts[0]++;
 
         // can't possibly be connected
         return false;
     }
 
+    if(!P_CheckSightPVS(sc, t1, t2)) {
+        return false;
+    }
+
     // An unobstructed LOS is possible.
     // Now look from eyes of t1 to any part of t2.
-    sightcounts[1]++;
+    sc->counts[1]++;
 
-    D_IncValidCount();
+    if(sc->linestamps) {
+        if(++sc->stamp == 0) {
+            // wrapped around, start over
+            dmemset(sc->linestamps, 0, numlines * sizeof(int));
+            sc->stamp = 1;
+        }
+    }
+    else {
+        D_IncValidCount();
+    }
 
-    sightzstart = t1->z + t1->height - (t1->height>>2);
-    topslope = (t2->z+t2->height) - sightzstart;
-    bottomslope = (t2->z) - sightzstart;
+    sc->sightzstart = t1->z + t1->height - (t1->height>>2);
+    sc->topslope = (t2->z+t2->height) - sc->sightzstart;
+    sc->bottomslope = (t2->z) - sc->sightzstart;
 
-    strace.x = t1->x;
-    strace.y = t1->y;
-    t2x = t2->x;
-    t2y = t2->y;
-    strace.dx = t2->x - t1->x;
-    strace.dy = t2->y - t1->y;
+    sc->strace.x = t1->x;
+    sc->strace.y = t1->y;
+    sc->t2x = t2->x;
+    sc->t2y = t2->y;
+    sc->strace.dx = t2->x - t1->x;
+    sc->strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode(numnodes-1);
+    return P_CrossBSPNode(sc, numnodes-1);
+}
+
+//
+// P_CheckSight
+//
+
+dboolean P_CheckSight(mobj_t* t1, mobj_t* t2) {
+    sightcontext_t  sc;
+    dboolean        result;
+
+    sc.linestamps = NULL;
+    dmemset(sc.counts, 0, sizeof(sc.counts));
+
+    result = P_CheckSightContext(&sc, t1, t2);
+
+    sightcounts[0] += sc.counts[0];
+    sightcounts[1] += sc.counts[1];
+    sightcounts[2] += sc.counts[2];
+    sightcounts[3] += sc.counts[3];
+
+    return result;
+}
+
+//
+// P_InitSight
+// Builds the sight pvs and sets up the per job line stamps
+// for the level. Called from P_SetupLevel once the lines
+// are loaded
+//
+
+void P_InitSight(void) {
+    int i;
+
+    P_BuildSightPVS();
+
+    numsightjobs = I_NumWorkers() + 1;
+
+    if(numsightjobs > MAXSIGHTJOBS) {
+        numsightjobs = MAXSIGHTJOBS;
+    }
+
+    // no one to share the work with
+    if(numsightjobs == 1) {
+        return;
+    }
+
+    for(i = 0; i < numsightjobs; i++) {
+        sightcontext_t* sc = &sightjobs[i].context;
+
+        sc->linestamps = (int*)Z_Calloc(numlines * sizeof(int), PU_LEVEL, 0);
+        sc->stamp = 0;
+    }
+
+    if(!sightgroup) {
+        sightgroup = I_CreateJobGroup();
+    }
+}
+
+//
+// P_SightJob
+//
+
+static void P_SightJob(void* data) {
+    sightjob_t* job = (sightjob_t*)data;
+    int i;
+
+    for(i = job->start; i < job->end; i++) {
+        mobj_t* mobj = sightmobjs[i];
+
+        sightresults[i] = P_CheckSightContext(&job->context, mobj, mobj->target);
+    }
 }
 
 //
 // P_ScanSights
 // Optimal mobj sight checking that check sights
 // in main tick loop rather from multiple
-// mobj action routines
+// mobj action routines. With enough monsters the
+// traces are split up across the worker threads and
+// the results applied afterwards in list order
 //
 
 void P_ScanSights(void) {
     mobj_t* mobj;
+    int     count = 0;
+    int     jobs;
+    int     i;
 
     for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
         // must be killable
@@ -377,16 +1051,65 @@ void P_ScanSights(void) {
 
         mobj->flags &= ~MF_SEETARGET;
 
+        // not thinking anyway
+        if(P_MobjIsDormant(mobj)) {
+            continue;
+        }
+
         // must have a target
         if(!mobj->target) {
             continue;
         }
 
-        if(!P_CheckSight(mobj, mobj->target)) {
-            continue;
+        if(count == maxsightmobjs) {
+            maxsightmobjs = maxsightmobjs ? maxsightmobjs * 2 : 256;
+            sightmobjs = (mobj_t**)Z_Realloc(sightmobjs,
+                                             maxsightmobjs * sizeof(mobj_t*), PU_STATIC, NULL);
+            sightresults = (byte*)Z_Realloc(sightresults, maxsightmobjs, PU_STATIC, NULL);
         }
 
-        mobj->flags |= MF_SEETARGET;
+        sightmobjs[count++] = mobj;
     }
-}
 
+    jobs = count / MINSIGHTSPERJOB;
+
+    if(jobs > numsightjobs) {
+        jobs = numsightjobs;
+    }
+
+    if(jobs < 2) {
+        for(i = 0; i < count; i++) {
+            sightresults[i] = P_CheckSight(sightmobjs[i], sightmobjs[i]->target);
+        }
+    }
+    else {
+        for(i = 0; i < jobs; i++) {
+            sightjob_t* job = &sightjobs[i];
+
+            job->start = (count * i) / jobs;
+            job->end = (count * (i + 1)) / jobs;
+            dmemset(job->context.counts, 0, sizeof(job->context.counts));
+
+            I_QueueJob(sightgroup, P_SightJob, job);
+        }
+
+        I_WaitJobGroup(sightgroup);
+
+        for(i = 0; i < jobs; i++) {
+            sightcounts[0] += sightjobs[i].context.counts[0];
+            sightcounts[1] += sightjobs[i].context.counts[1];
+            sightcounts[2] += sightjobs[i].context.counts[2];
+            sightcounts[3] += sightjobs[i].context.counts[3];
+
+            // mobj validcounts end up in saves and state hashes, so
+            // move it along as if the traces had been run here
+            validcount += sightjobs[i].context.counts[1];
+        }
+    }
+
+    for(i = 0; i < count; i++) {
+        if(sightresults[i]) {
+            sightmobjs[i]->flags |= MF_SEETARGET;
+        }
+    }
+}
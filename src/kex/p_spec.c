@@ -614,6 +614,11 @@ static int P_ModifyLine(int tag1, int tag2, int type) {
         }
     }
 
+    // sound blocking may have changed
+    if(type == modl_flags) {
+        P_RefreshSoundGraph();
+    }
+
     return 1;
 }
 
@@ -655,10 +660,12 @@ static int P_ModifySector(line_t *line, int tag, int type) {
                 for(j = 0; j < 5; j++) {
                     sec1->colors[j] = sec2->colors[j];
                 }
+                P_SectorChanged(sec1);
                 break;
             case mods_flats:
                 sec1->ceilingpic = sec2->ceilingpic;
                 sec1->floorpic = sec2->floorpic;
+                P_SectorChanged(sec1);
                 break;
             case mods_special:
                 sec1->special = sec2->special;
@@ -666,12 +673,17 @@ static int P_ModifySector(line_t *line, int tag, int type) {
                 break;
             case mods_flags:
                 sec1->flags = sec2->flags;
+                P_SectorChanged(sec1);
                 break;
             default:
                 break;
         }
     }
 
+    if(rtn && type == mods_flags) {
+        P_RefreshScrollSectors();
+    }
+
     return rtn;
 }
 
@@ -711,6 +723,8 @@ int P_ModifySectorColor(line_t* line, int index, int type) {
                 sec->colors[LIGHT_LWRWALL] = index;
                 break;
         }
+
+        P_SectorChanged(sec);
     }
     
     return rtn;
@@ -848,6 +862,8 @@ static void P_AlertTaggedMobj(mobj_t *activator, int tid) {
             mo->height      = info->height;
             mo->radius      = info->radius;
             mo->blockflag   = BF_MOBJPASS;
+
+            P_SyncMobjHot(mo);
         }
 
         st = &states[mo->info->seestate];
@@ -991,6 +1007,7 @@ void T_MovingCamera(movecamera_t* camera) {
         camtarget->x += camera->slopex;
         camtarget->y += camera->slopey;
         camtarget->z += camera->slopez;
+        P_SyncMobjHot(camtarget);
 
         return;
     }
@@ -1068,6 +1085,7 @@ void P_SetMovingCamera(player_t* player, line_t* line) {
         mo->angle = player->cameratarget->angle;
         mo->x = player->cameratarget->x;
         mo->y = player->cameratarget->y;
+        P_SyncMobjHot(mo);
         player->cameratarget = mo;
 
         // [kex] store player information
@@ -1789,6 +1807,7 @@ void P_PlayerInSpecialSector(player_t* player) {
         player->message = FOUNDSECRET;
         player->messagepic = 40;
         sector->flags &= ~MS_SECRET;
+        P_SectorChanged(sector);
     }
 
     if(sector->flags & MS_DAMAGEX5) {
@@ -1839,6 +1858,190 @@ void P_PlayerInSpecialSector(player_t* player) {
 }
 
 
+//
+// ACTIVE SECTOR LISTS
+//
+// Rather than sweeping every sector each tic, sectors that scroll,
+// move or change how they look are kept in lists of their own.
+// Moving sectors are added by T_MovePlane/T_MoveSplitPlane and only
+// stay on the list for the tic they moved in. The dirty list collects
+// anything that changed since the renderer last looked at it
+//
+
+sector_t**  scrollsectors = NULL;
+int         numscrollsectors = 0;
+sector_t**  movingsectors = NULL;
+int         nummovingsectors = 0;
+sector_t**  dirtysectors = NULL;
+int         numdirtysectors = 0;
+dboolean    allsectorsdirty = true;
+int*        dirtylights = NULL;
+int         numdirtylights = 0;
+
+#define SL_MOVING   0x1
+#define SL_DIRTY    0x2
+
+static byte* sectorlistbits = NULL;
+static byte* lightlistbits = NULL;
+
+//
+// P_RefreshScrollSectors
+// Call whenever sector flags have been changed
+//
+
+void P_RefreshScrollSectors(void) {
+    int i;
+
+    numscrollsectors = 0;
+
+    for(i = 0; i < numsectors; i++) {
+        if(sectors[i].flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
+            scrollsectors[numscrollsectors++] = &sectors[i];
+        }
+    }
+}
+
+//
+// P_ResetSectorLists
+// Clears the moving sectors, resets the interpolation
+// frames of every sector and flags everything as dirty
+//
+
+void P_ResetSectorLists(void) {
+    int i;
+
+    for(i = 0; i < numsectors; i++) {
+        sector_t* sector = &sectors[i];
+
+        sector->frame_z1[0] = sector->frame_z1[1] = sector->floorheight;
+        sector->frame_z2[0] = sector->frame_z2[1] = sector->ceilingheight;
+    }
+
+    dmemset(sectorlistbits, 0, numsectors);
+    dmemset(lightlistbits, 0, numlights);
+    nummovingsectors = 0;
+    numdirtysectors = 0;
+    numdirtylights = 0;
+    allsectorsdirty = true;
+
+    P_RefreshScrollSectors();
+    P_RefreshSoundGraph();
+}
+
+//
+// P_InitSectorLists
+//
+
+void P_InitSectorLists(void) {
+    scrollsectors = (sector_t**)Z_Malloc(sizeof(sector_t*) * numsectors, PU_LEVEL, 0);
+    movingsectors = (sector_t**)Z_Malloc(sizeof(sector_t*) * numsectors, PU_LEVEL, 0);
+    dirtysectors = (sector_t**)Z_Malloc(sizeof(sector_t*) * numsectors, PU_LEVEL, 0);
+    sectorlistbits = (byte*)Z_Malloc(numsectors, PU_LEVEL, 0);
+    dirtylights = (int*)Z_Malloc(sizeof(int) * numlights, PU_LEVEL, 0);
+    lightlistbits = (byte*)Z_Malloc(numlights, PU_LEVEL, 0);
+
+    P_ResetSectorLists();
+}
+
+//
+// P_SectorChanged
+// Flags a sector for the renderer to rebuild
+//
+
+void P_SectorChanged(sector_t* sector) {
+    int secnum = sector - sectors;
+
+    if(!(sectorlistbits[secnum] & SL_DIRTY)) {
+        sectorlistbits[secnum] |= SL_DIRTY;
+        dirtysectors[numdirtysectors++] = sector;
+    }
+}
+
+//
+// P_SectorMoved
+// Called when the floor or ceiling of a sector has changed height
+//
+
+void P_SectorMoved(sector_t* sector) {
+    int secnum = sector - sectors;
+
+    if(!(sectorlistbits[secnum] & SL_MOVING)) {
+        sectorlistbits[secnum] |= SL_MOVING;
+        movingsectors[nummovingsectors++] = sector;
+    }
+
+    P_SoundSectorMoved(sector);
+    P_SectorChanged(sector);
+}
+
+//
+// P_LightChanged
+// Flags a light whose color has changed. The renderer
+// works out which sectors are using it
+//
+
+void P_LightChanged(light_t* light) {
+    int lightnum = light - lights;
+
+    if(!(lightlistbits[lightnum] & SL_DIRTY)) {
+        lightlistbits[lightnum] |= SL_DIRTY;
+        dirtylights[numdirtylights++] = lightnum;
+    }
+}
+
+//
+// P_MarkAllSectorsDirty
+// For changes that can affect any sector, such as the light colors
+//
+
+void P_MarkAllSectorsDirty(void) {
+    allsectorsdirty = true;
+}
+
+//
+// P_ClearDirtySectors
+// Called by the renderer once it has gone through the dirty list
+//
+
+void P_ClearDirtySectors(void) {
+    int i;
+
+    for(i = 0; i < numdirtysectors; i++) {
+        sectorlistbits[dirtysectors[i] - sectors] &= ~SL_DIRTY;
+    }
+
+    for(i = 0; i < numdirtylights; i++) {
+        lightlistbits[dirtylights[i]] &= ~SL_DIRTY;
+    }
+
+    numdirtysectors = 0;
+    numdirtylights = 0;
+    allsectorsdirty = false;
+}
+
+//
+// P_UpdateSectorFrames
+// Called at the start of every tic. Sectors that moved during the
+// last tic get their interpolation frames caught up and drop off the
+// moving list. Everything else is already at rest
+//
+
+void P_UpdateSectorFrames(void) {
+    int i;
+
+    for(i = 0; i < nummovingsectors; i++) {
+        sector_t* sector = movingsectors[i];
+
+        sector->frame_z1[0] = sector->frame_z1[1] = sector->floorheight;
+        sector->frame_z2[0] = sector->frame_z2[1] = sector->ceilingheight;
+
+        sectorlistbits[sector - sectors] &= ~SL_MOVING;
+        P_SectorChanged(sector);
+    }
+
+    nummovingsectors = 0;
+}
+
 //
 // P_UpdateSpecials
 // Animate planes, scroll walls, etc.
@@ -1886,33 +2089,32 @@ void P_UpdateSpecials(void) {
     }
 
     // UPDATE SCROLLING FLATS
-    for(i = 0; i < numsectors; i++) {
-        sector = &sectors[i];
+    for(i = 0; i < numscrollsectors; i++) {
+        fixed_t speed;
 
-        if(sector->flags & (MS_SCROLLFLOOR|MS_SCROLLCEILING)) {
-            fixed_t speed;
+        sector = scrollsectors[i];
 
-            if(sector->flags & MS_SCROLLFAST) {
-                speed = 3*FRACUNIT;
-            }
-            else {
-                speed = FRACUNIT;
-            }
+        if(sector->flags & MS_SCROLLFAST) {
+            speed = 3*FRACUNIT;
+        }
+        else {
+            speed = FRACUNIT;
+        }
 
-            if(sector->flags & MS_SCROLLLEFT) {
-                sector->xoffset += speed;
-            }
-            if(sector->flags & MS_SCROLLRIGHT) {
-                sector->xoffset -= speed;
-            }
-            if(sector->flags & MS_SCROLLUP) {
-                sector->yoffset += speed;
-            }
-            if(sector->flags & MS_SCROLLDOWN) {
-                sector->yoffset -= speed;
-            }
+        if(sector->flags & MS_SCROLLLEFT) {
+            sector->xoffset += speed;
+        }
+        if(sector->flags & MS_SCROLLRIGHT) {
+            sector->xoffset -= speed;
+        }
+        if(sector->flags & MS_SCROLLUP) {
+            sector->yoffset += speed;
+        }
+        if(sector->flags & MS_SCROLLDOWN) {
+            sector->yoffset -= speed;
         }
 
+        P_SectorChanged(sector);
     }
 
     // SKY TICKER
@@ -2130,6 +2332,8 @@ void P_SpawnSpecials(void) {
         }
     }
 
+    P_InitSectorLists();
+
     //    Init line EFFECTs
     numlinespecials = 0;
     linespeciallist = Z_Malloc(sizeof(line_t*) * 1, PU_LEVEL, 0);
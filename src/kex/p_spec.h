@@ -54,6 +54,29 @@ int         P_DoSpecialLine(mobj_t* thing, line_t* line, int side);
 void        P_AddSectorSpecial(sector_t* sector);
 void        P_SpawnDelayTimer(line_t* line, void (*func)(void));
 
+//
+// Active sector lists
+//
+extern sector_t**   scrollsectors;
+extern int          numscrollsectors;
+extern sector_t**   movingsectors;      // moved during the last tic
+extern int          nummovingsectors;
+extern sector_t**   dirtysectors;       // changed since the last rendered frame
+extern int          numdirtysectors;
+extern dboolean     allsectorsdirty;
+extern int*         dirtylights;        // lights that changed color since the last rendered frame
+extern int          numdirtylights;
+
+void        P_InitSectorLists(void);
+void        P_ResetSectorLists(void);
+void        P_RefreshScrollSectors(void);
+void        P_SectorChanged(sector_t* sector);
+void        P_SectorMoved(sector_t* sector);
+void        P_LightChanged(light_t* light);
+void        P_MarkAllSectorsDirty(void);
+void        P_ClearDirtySectors(void);
+void        P_UpdateSectorFrames(void);
+
 // when needed
 dboolean    P_UseSpecialLine(mobj_t* thing, line_t* line, int side);
 void        P_PlayerInSpecialSector(player_t* player);
@@ -30,6 +30,7 @@
 #include "doomstat.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "p_tick.h"
 #include "p_macros.h"
 #include "st_stuff.h"
 #include "am_map.h"
@@ -40,6 +41,8 @@
 #include "r_wipe.h"
 #include "p_setup.h"
 #include "g_demo.h"
+#include "i_system.h"
+#include "d_prof.h"
 
 CVAR_EXTERNAL(i_interpolateframes);
 CVAR_EXTERNAL(p_damageindicator);
@@ -47,6 +50,11 @@ CVAR_EXTERNAL(r_wipe);
 
 int     leveltime;
 
+// time spent in each part of P_Ticker, in microseconds.
+// only gathered while tickertiming is set
+uint64      tickertime[NUMTICKSTATS];
+dboolean    tickertiming = false;
+
 void G_PlayerFinishLevel(int player);
 void G_DoReborn(int playernum);
 
@@ -75,6 +83,7 @@ thinker_t   *currentthinker;
 void P_InitThinkers(void) {
     thinkercap.prev = thinkercap.next  = &thinkercap;
     mobjhead.next = mobjhead.prev = &mobjhead;
+    P_ClearMobjHot();
 }
 
 //
@@ -142,6 +151,8 @@ void P_UnlinkMobj(mobj_t* mobj) {
 //
 
 void P_RunMobjs(void) {
+    int dormant = 0;
+
     for(currentmobj = mobjhead.next; currentmobj != &mobjhead; currentmobj = currentmobj->next) {
         if(!currentmobj) {
             CON_Warnf("P_RunMobjs: Null mobj in linked list!\n");
@@ -157,6 +168,11 @@ void P_RunMobjs(void) {
             continue;
         }
 
+        if(P_MobjIsDormant(currentmobj)) {
+            dormant++;
+            continue;
+        }
+
         if(!currentmobj->player) {
             // [kex] don't bother if about to be removed
             if(currentmobj->mobjfunc != P_SafeRemoveMobj) {
@@ -171,8 +187,12 @@ void P_RunMobjs(void) {
             if(currentmobj->mobjfunc) {
                 currentmobj->mobjfunc(currentmobj);
             }
+
+            P_SyncMobjHot(currentmobj);
         }
     }
+
+    dormantmobjs = dormant;
 }
 
 //
@@ -204,8 +224,6 @@ static void P_UpdateFrameStates(void) {
     pspdef_t    *psp;
     mobj_t      *viewcamera;
     angle_t     pitch;
-    mobj_t      *mobj;
-    int         i;
 
     viewcamera = player->cameratarget;
     pitch = viewcamera->pitch + ANG90;
@@ -233,36 +251,10 @@ static void P_UpdateFrameStates(void) {
     player->psprites[ps_flash].frame_x = psp->sx;
     player->psprites[ps_flash].frame_y = psp->sy;
 
-    //
-    // update sector frames for interpolation
-    //
-    for(i = 0; i < numsectors; i++) {
-        sector_t* sector = &sectors[i];
-
-        sector->frame_z1[0] = sector->floorheight;
-        sector->frame_z2[0] = sector->ceilingheight;
-        sector->frame_z1[1] = sector->frame_z1[0];
-        sector->frame_z2[1] = sector->frame_z1[0];
-    }
-
     //
     // update mobj frames for interpolation
     //
-    for(mobj = mobjhead.next; mobj != &mobjhead; mobj = mobj->next) {
-        if(!mobj) {
-            CON_Warnf("P_UpdateFrameStates: Null mobj in linked list!\n");
-            continue;
-        }
-
-        // Special case only
-        if(mobj->flags & MF_NOSECTOR) {
-            continue;
-        }
-
-        mobj->frame_x = mobj->x;
-        mobj->frame_y = mobj->y;
-        mobj->frame_z = mobj->z;
-    }
+    P_UpdateMobjFrames();
 }
 
 //
@@ -402,12 +394,43 @@ void P_Drawer(void) {
     ST_Drawer();
 }
 
+//
+// P_TickerTime
+// Ends the profiler stage of a ticker stat and starts the next. With
+// tickertiming set, also adds the time since *start to the stat and
+// restarts the clock
+//
+
+static void P_TickerTime(int stat, uint64* start) {
+    uint64 now;
+
+    // the profiler's stages are in the same order
+    PROF_END(PROF_PLAYERS + stat);
+
+    if(stat + 1 < NUMTICKSTATS) {
+        PROF_BEGIN(PROF_PLAYERS + stat + 1);
+    }
+
+    if(!tickertiming) {
+        return;
+    }
+
+    now = I_GetTimeUS();
+    tickertime[stat] += now - *start;
+    *start = now;
+}
+
 //
 // P_Ticker
 //
 
 int P_Ticker(void) {
     int i;
+    uint64 start = 0;
+
+    // sector frames are kept up to date even without interpolation
+    // since only the sectors that moved get touched from here on
+    P_UpdateSectorFrames();
 
     if(i_interpolateframes.value) {
         P_UpdateFrameStates();
@@ -423,6 +446,12 @@ int P_Ticker(void) {
         return 0;
     }
 
+    if(tickertiming) {
+        start = I_GetTimeUS();
+    }
+
+    PROF_BEGIN(PROF_PLAYERS);
+
     for(i = 0; i < MAXPLAYERS; i++) {
         if(playeringame[i]) {
             // do player reborns if needed
@@ -431,14 +460,24 @@ int P_Ticker(void) {
             }
 
             P_PlayerThink(&players[i]);
+
+            if(players[i].mo) {
+                P_SyncMobjHot(players[i].mo);
+            }
         }
     }
 
+    P_TickerTime(TICK_PLAYERS, &start);
     P_RunThinkers();
+    P_TickerTime(TICK_THINKERS, &start);
     P_ScanSights();
+    P_TickerTime(TICK_SIGHTS, &start);
     P_RunMobjs();
+    P_TickerTime(TICK_MOBJS, &start);
     P_UpdateSpecials();
+    P_TickerTime(TICK_SPECIALS, &start);
     P_RunMacros();
+    P_TickerTime(TICK_MACROS, &start);
 
     ST_Ticker();
     AM_Ticker();
@@ -446,6 +485,9 @@ int P_Ticker(void) {
     // for par times
     leveltime++;
 
+    // determinism checking
+    G_DemoHashTic();
+
     return gameaction;
 }
 
@@ -30,6 +30,19 @@
 #pragma interface
 #endif
 
+typedef enum {
+    TICK_PLAYERS,
+    TICK_THINKERS,
+    TICK_SIGHTS,
+    TICK_MOBJS,
+    TICK_SPECIALS,
+    TICK_MACROS,
+    NUMTICKSTATS
+} tickstat_e;
+
+extern uint64   tickertime[NUMTICKSTATS];
+extern dboolean tickertiming;
+
 void P_Start(void);
 void P_Stop(void);
 void P_Drawer(void);
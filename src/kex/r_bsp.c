@@ -39,6 +39,7 @@
 #include "con_console.h"
 #include "p_local.h"
 #include "gl_texture.h"
+#include "r_geom.h"
 
 sector_t    *frontsector;
 
@@ -537,6 +538,38 @@ static dboolean R_GenerateMiddleSegPlane(seg_t *line, vtx_t* v) {
     return true;
 }
 
+//
+// R_CachedLowerSegPlane
+//
+
+static dboolean R_CachedLowerSegPlane(seg_t *line, vtx_t* v) {
+    return R_GetSegGeometry(line, SEGPART_LOWER, R_GenerateLowerSegPlane, v);
+}
+
+//
+// R_CachedUpperSegPlane
+//
+
+static dboolean R_CachedUpperSegPlane(seg_t *line, vtx_t* v) {
+    return R_GetSegGeometry(line, SEGPART_UPPER, R_GenerateUpperSegPlane, v);
+}
+
+//
+// R_CachedMiddleSegPlane
+//
+
+static dboolean R_CachedMiddleSegPlane(seg_t *line, vtx_t* v) {
+    return R_GetSegGeometry(line, SEGPART_MIDDLE, R_GenerateMiddleSegPlane, v);
+}
+
+//
+// R_CachedSwitchPlane
+//
+
+static dboolean R_CachedSwitchPlane(seg_t *line, vtx_t* v) {
+    return R_GetSegGeometry(line, SEGPART_SWITCH, R_GenerateSwitchPlane, v);
+}
+
 //
 // AddSegToDrawlist
 //
@@ -549,16 +582,16 @@ static void AddSegToDrawlist(drawlist_t *dl, seg_t *line, int texid, int sidetyp
 
     switch(sidetype) {
     case 0:
-        list->callback = R_GenerateLowerSegPlane;
+        list->callback = R_CachedLowerSegPlane;
         break;
     case 1:
-        list->callback = R_GenerateUpperSegPlane;
+        list->callback = R_CachedUpperSegPlane;
         break;
     case 2:
-        list->callback = R_GenerateMiddleSegPlane;
+        list->callback = R_CachedMiddleSegPlane;
         break;
     case 3:
-        list->callback = R_GenerateSwitchPlane;
+        list->callback = R_CachedSwitchPlane;
         break;
     default:
         return;
@@ -583,35 +616,28 @@ static void AddSegToDrawlist(drawlist_t *dl, seg_t *line, int texid, int sidetyp
 }
 
 //
-// R_AddLine
+// R_GetSegPieces
+// Fills z with the top and bottom of every wall piece of the
+// seg that can end up in the draw list, and piece with the
+// SEGPART_ each of them is. Returns the number of pieces
 //
 
-static void R_AddLine(seg_t *line) {
-    vtx_t       v[4];
+int R_GetSegPieces(seg_t *line, rfloat* z, int* piece) {
     line_t*     linedef;
     side_t*     sidedef;
     rfloat      top;
     rfloat      bottom;
     rfloat      btop;
     rfloat      bbottom;
-    float       x;
-    float       y;
-
-    x = F2D3D(line->v1->x);
-    y = F2D3D(line->v1->y);
+    int         count = 0;
 
     linedef = line->linedef;
     sidedef = line->sidedef;
 
     if(!linedef) {
-        return;
+        return 0;
     }
 
-    v[0].x = v[2].x = x;
-    v[0].y = v[2].y = y;
-    v[1].x = v[3].x = F2D3D(line->v2->x);
-    v[1].y = v[3].y = F2D3D(line->v2->y);
-
     GetSideTopBottom(line->frontsector, &top, &bottom);
 
     if(line->backsector) {
@@ -625,14 +651,10 @@ static void R_AddLine(seg_t *line) {
         // botom side line
         //
         if(bottom < bbottom) {
-            v[0].z = v[1].z = bbottom;
-            v[2].z = v[3].z = bottom;
-
-            if(line->sidedef[0].bottomtexture != 1) {
-                if(R_FrustrumTestVertex(v, 4)) {
-                    AddSegToDrawlist(&drawlist[DLT_WALL], line, sidedef->bottomtexture, 0);
-                    AddSwitchQuad(line);
-                }
+            if(sidedef->bottomtexture != 1) {
+                z[count * 2 + 0] = bbottom;
+                z[count * 2 + 1] = bottom;
+                piece[count++] = SEGPART_LOWER;
             }
 
             bottom = bbottom;
@@ -642,14 +664,10 @@ static void R_AddLine(seg_t *line) {
         // upper side line
         //
         if(top > btop) {
-            v[0].z = v[1].z = top;
-            v[2].z = v[3].z = btop;
-
-            if(line->sidedef[0].toptexture != 1) {
-                if(R_FrustrumTestVertex(v, 4)) {
-                    AddSegToDrawlist(&drawlist[DLT_WALL], line, sidedef->toptexture, 1);
-                    AddSwitchQuad(line);
-                }
+            if(sidedef->toptexture != 1) {
+                z[count * 2 + 0] = top;
+                z[count * 2 + 1] = btop;
+                piece[count++] = SEGPART_UPPER;
             }
 
             top = btop;
@@ -660,23 +678,65 @@ static void R_AddLine(seg_t *line) {
     // middle side line
     //
     if(sidedef->midtexture != 1) {
-        v[0].z = v[1].z = top;
-        v[2].z = v[3].z = bottom;
+        if(line->backsector && !(linedef->flags & ML_DRAWMIDTEXTURE)) {
+            return count;
+        }
 
-        if(!R_FrustrumTestVertex(v, 4)) {
-            return;
+        if(!(linedef->flags & ML_SWITCHX02 && linedef->flags & ML_SWITCHX04)) {
+            z[count * 2 + 0] = top;
+            z[count * 2 + 1] = bottom;
+            piece[count++] = SEGPART_MIDDLE;
         }
+    }
 
-        if(line->backsector) {
-            if(!(line->linedef->flags & ML_DRAWMIDTEXTURE)) {
-                return;
-            }
+    return count;
+}
+
+//
+// R_AddLine
+// All pieces of the seg are tested against the
+// frustrum together, see R_FrustrumTestSeg
+//
+
+static void R_AddLine(seg_t *line) {
+    side_t*     sidedef;
+    rfloat      z[MAXSEGPIECES * 2];
+    int         piece[MAXSEGPIECES];
+    int         count;
+    int         visible;
+    int         texid;
+    int         i;
+
+    count = R_GetSegPieces(line, z, piece);
+
+    if(!count) {
+        return;
+    }
+
+    visible = R_FrustrumTestSeg(F2D3D(line->v1->x), F2D3D(line->v1->y),
+                                F2D3D(line->v2->x), F2D3D(line->v2->y), z, count);
+
+    sidedef = line->sidedef;
+
+    for(i = 0; i < count; i++) {
+        if(!(visible & (1 << i))) {
+            continue;
         }
 
-        if(!(line->linedef->flags & ML_SWITCHX02 && line->linedef->flags & ML_SWITCHX04)) {
-            AddSegToDrawlist(&drawlist[DLT_WALL], line, sidedef->midtexture, 2);
-            AddSwitchQuad(line);
+        switch(piece[i]) {
+        case SEGPART_LOWER:
+            texid = sidedef->bottomtexture;
+            break;
+        case SEGPART_UPPER:
+            texid = sidedef->toptexture;
+            break;
+        default:
+            texid = sidedef->midtexture;
+            break;
         }
+
+        AddSegToDrawlist(&drawlist[DLT_WALL], line, texid, piece[i]);
+        AddSwitchQuad(line);
     }
 }
 
@@ -26,15 +26,79 @@
 //-----------------------------------------------------------------------------
 
 #include "r_local.h"
+#include "r_clipper.h"
 #include "tables.h"
 #include "m_fixed.h"
 #include "z_zone.h"
+#include "doomstat.h"
+#include "i_system.h"
+#include "con_console.h"
+#include "g_actions.h"
 #include <math.h>
+#include <string.h>
+
+//
+// the frustrum tests have a SSE2 or NEON path where the compiler
+// allows it, with the planes tested four at a time. builds without
+// either keep using the scalar tests
+//
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+#define USE_SIMD_FRUSTRUM
+
+typedef __m128  vfloat_t;
+typedef __m128  vmask_t;
+
+#define VLOAD(p)            _mm_loadu_ps(p)
+#define VSPLAT(f)           _mm_set1_ps(f)
+#define VADD(a, b)          _mm_add_ps(a, b)
+#define VMUL(a, b)          _mm_mul_ps(a, b)
+#define VMASKZERO()         _mm_setzero_ps()
+#define VOR(a, b)           _mm_or_ps(a, b)
+#define VGTZERO(a)          _mm_cmpgt_ps(a, _mm_setzero_ps())
+#define VALLSET(a, b)       (_mm_movemask_ps(_mm_and_ps(a, b)) == 0xf)
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+#define USE_SIMD_FRUSTRUM
+
+typedef float32x4_t vfloat_t;
+typedef uint32x4_t  vmask_t;
+
+#define VLOAD(p)            vld1q_f32(p)
+#define VSPLAT(f)           vdupq_n_f32(f)
+#define VADD(a, b)          vaddq_f32(a, b)
+#define VMUL(a, b)          vmulq_f32(a, b)
+#define VMASKZERO()         vdupq_n_u32(0)
+#define VOR(a, b)           vorrq_u32(a, b)
+#define VGTZERO(a)          vcgtq_f32(a, vdupq_n_f32(0))
+#define VALLSET(a, b)       R_NeonAllSet(vandq_u32(a, b))
+
+d_inline static dboolean R_NeonAllSet(uint32x4_t m) {
+    uint32x2_t h = vand_u32(vget_low_u32(m), vget_high_u32(m));
+    return (vget_lane_u32(h, 0) & vget_lane_u32(h, 1)) != 0;
+}
+
+#endif
+
+#define CULLBENCHVIEWS  64
 
 static GLdouble viewMatrix[16];
 static GLdouble projMatrix[16];
 float frustum[6][4];
 
+// the planes laid out for the SIMD tests: normals and distances of
+// all planes side by side, padded out to eight planes with ones
+// that every point is in front of
+static float frustumlanes[4][8];
+
+// last frustrums set up, for cullbench
+static float cullviews[CULLBENCHVIEWS][6][4];
+static int numcullviews = 0;
+static int cullviewpos = 0;
+
 typedef struct clipnode_s {
     struct clipnode_s *prev, *next;
     angle_t start, end;
@@ -271,6 +335,46 @@ angle_t R_FrustumAngle(void) {
     return ANG270 - ((int)floatangle * ANG1);
 }
 
+//
+// R_FrustrumSetLanes
+//
+
+static void R_FrustrumSetLanes(void) {
+    int p;
+    int i;
+
+    for(p = 0; p < 8; p++) {
+        for(i = 0; i < 4; i++) {
+            if(p < 6) {
+                frustumlanes[i][p] = frustum[p][i];
+            }
+            else {
+                frustumlanes[i][p] = (i == 3) ? 1.0f : 0.0f;
+            }
+        }
+    }
+}
+
+//
+// R_FrustrumCaptureView
+// Keeps the last few distinct frustrums around for cullbench
+//
+
+static void R_FrustrumCaptureView(void) {
+    if(numcullviews > 0 &&
+            !memcmp(cullviews[(cullviewpos + CULLBENCHVIEWS - 1) % CULLBENCHVIEWS],
+                    frustum, sizeof(frustum))) {
+        return;
+    }
+
+    dmemcpy(cullviews[cullviewpos], frustum, sizeof(frustum));
+    cullviewpos = (cullviewpos + 1) % CULLBENCHVIEWS;
+
+    if(numcullviews < CULLBENCHVIEWS) {
+        numcullviews++;
+    }
+}
+
 //
 // R_FrustrumSetup
 //
@@ -342,14 +446,16 @@ void R_FrustrumSetup(void) {
     frustum[5][1] = clip[ 7] + clip[ 6];
     frustum[5][2] = clip[11] + clip[10];
     frustum[5][3] = clip[15] + clip[14];
+
+    R_FrustrumSetLanes();
+    R_FrustrumCaptureView();
 }
 
 //
-// R_FrustrumTestVertex
-// Returns false if polygon is not within the view frustrum
+// R_FrustrumTestVertexScalar
 //
 
-dboolean R_FrustrumTestVertex(vtx_t* vertex, int count) {
+static dboolean R_FrustrumTestVertexScalar(vtx_t* vertex, int count) {
     int p;
     int i;
 
@@ -372,3 +478,334 @@ dboolean R_FrustrumTestVertex(vtx_t* vertex, int count) {
 
     return true;
 }
+
+//
+// R_FrustrumTestSegScalar
+//
+
+static int R_FrustrumTestSegScalar(float x1, float y1, float x2, float y2, float* z, int count) {
+    vtx_t   v[4];
+    int     visible = 0;
+    int     i;
+
+    v[0].x = v[2].x = x1;
+    v[0].y = v[2].y = y1;
+    v[1].x = v[3].x = x2;
+    v[1].y = v[3].y = y2;
+
+    for(i = 0; i < count; i++) {
+        v[0].z = v[1].z = z[i * 2 + 0];
+        v[2].z = v[3].z = z[i * 2 + 1];
+
+        if(R_FrustrumTestVertexScalar(v, 4)) {
+            visible |= (1 << i);
+        }
+    }
+
+    return visible;
+}
+
+#ifdef USE_SIMD_FRUSTRUM
+
+//
+// R_FrustrumTestVertexSIMD
+// Same test as the scalar one, but checks each vertex against
+// four planes at a time. The sums are done in the same order
+// so that both give the same results
+//
+
+static dboolean R_FrustrumTestVertexSIMD(vtx_t* vertex, int count) {
+    vfloat_t    a0, a1, b0, b1, c0, c1, d0, d1;
+    vfloat_t    x, y, z;
+    vmask_t     in0;
+    vmask_t     in1;
+    int         i;
+
+    a0 = VLOAD(&frustumlanes[0][0]);
+    a1 = VLOAD(&frustumlanes[0][4]);
+    b0 = VLOAD(&frustumlanes[1][0]);
+    b1 = VLOAD(&frustumlanes[1][4]);
+    c0 = VLOAD(&frustumlanes[2][0]);
+    c1 = VLOAD(&frustumlanes[2][4]);
+    d0 = VLOAD(&frustumlanes[3][0]);
+    d1 = VLOAD(&frustumlanes[3][4]);
+
+    in0 = in1 = VMASKZERO();
+
+    for(i = 0; i < count; i++) {
+        x = VSPLAT(vertex[i].x);
+        y = VSPLAT(vertex[i].y);
+        z = VSPLAT(vertex[i].z);
+
+        in0 = VOR(in0, VGTZERO(VADD(VADD(VADD(VMUL(a0, x), VMUL(b0, y)), VMUL(c0, z)), d0)));
+        in1 = VOR(in1, VGTZERO(VADD(VADD(VADD(VMUL(a1, x), VMUL(b1, y)), VMUL(c1, z)), d1)));
+    }
+
+    // polygon is out if all of its points are behind any one plane
+    return VALLSET(in0, in1);
+}
+
+//
+// R_FrustrumTestSegSIMD
+// The x/y part of the plane distance is worked out once for
+// each end of the seg and shared by all of its pieces
+//
+
+#define VINSIDE(xy, cz, d)  VGTZERO(VADD(VADD(xy, cz), d))
+
+static int R_FrustrumTestSegSIMD(float x1, float y1, float x2, float y2, float* z, int count) {
+    vfloat_t    a0, a1, b0, b1, c0, c1, d0, d1;
+    vfloat_t    e10, e11, e20, e21;
+    vfloat_t    top, bottom;
+    vfloat_t    ct0, ct1, cb0, cb1;
+    vmask_t     in0;
+    vmask_t     in1;
+    int         visible = 0;
+    int         i;
+
+    a0 = VLOAD(&frustumlanes[0][0]);
+    a1 = VLOAD(&frustumlanes[0][4]);
+    b0 = VLOAD(&frustumlanes[1][0]);
+    b1 = VLOAD(&frustumlanes[1][4]);
+    c0 = VLOAD(&frustumlanes[2][0]);
+    c1 = VLOAD(&frustumlanes[2][4]);
+    d0 = VLOAD(&frustumlanes[3][0]);
+    d1 = VLOAD(&frustumlanes[3][4]);
+
+    e10 = VADD(VMUL(a0, VSPLAT(x1)), VMUL(b0, VSPLAT(y1)));
+    e11 = VADD(VMUL(a1, VSPLAT(x1)), VMUL(b1, VSPLAT(y1)));
+    e20 = VADD(VMUL(a0, VSPLAT(x2)), VMUL(b0, VSPLAT(y2)));
+    e21 = VADD(VMUL(a1, VSPLAT(x2)), VMUL(b1, VSPLAT(y2)));
+
+    for(i = 0; i < count; i++) {
+        top = VSPLAT(z[i * 2 + 0]);
+        bottom = VSPLAT(z[i * 2 + 1]);
+
+        ct0 = VMUL(c0, top);
+        ct1 = VMUL(c1, top);
+        cb0 = VMUL(c0, bottom);
+        cb1 = VMUL(c1, bottom);
+
+        in0 = VOR(VOR(VINSIDE(e10, ct0, d0), VINSIDE(e20, ct0, d0)),
+                  VOR(VINSIDE(e10, cb0, d0), VINSIDE(e20, cb0, d0)));
+        in1 = VOR(VOR(VINSIDE(e11, ct1, d1), VINSIDE(e21, ct1, d1)),
+                  VOR(VINSIDE(e11, cb1, d1), VINSIDE(e21, cb1, d1)));
+
+        if(VALLSET(in0, in1)) {
+            visible |= (1 << i);
+        }
+    }
+
+    return visible;
+}
+
+#endif
+
+//
+// R_FrustrumTestVertex
+// Returns false if polygon is not within the view frustrum
+//
+
+dboolean R_FrustrumTestVertex(vtx_t* vertex, int count) {
+#ifdef USE_SIMD_FRUSTRUM
+    return R_FrustrumTestVertexSIMD(vertex, count);
+#else
+    return R_FrustrumTestVertexScalar(vertex, count);
+#endif
+}
+
+//
+// R_FrustrumTestSeg
+// Tests the pieces of a wall between (x1, y1) and (x2, y2).
+// z holds the top and bottom of each piece, up to
+// MAXSEGPIECES of them. Returns a bit for every piece
+// that is within the view frustrum
+//
+
+int R_FrustrumTestSeg(float x1, float y1, float x2, float y2, float* z, int count) {
+#ifdef USE_SIMD_FRUSTRUM
+    return R_FrustrumTestSegSIMD(x1, y1, x2, y2, z, count);
+#else
+    return R_FrustrumTestSegScalar(x1, y1, x2, y2, z, count);
+#endif
+}
+
+//
+// R_CullBenchPass
+// Runs the wall and flat tests of the whole level against
+// every captured view. Returns the number of visible pieces
+//
+
+static int R_CullBenchPass(dboolean simd, float* segz, int* segpieces,
+                           vtx_t* leafverts, int numleafverts, uint64* time) {
+    int             view;
+    int             i;
+    int             visible = 0;
+    uint64          start;
+    seg_t*          seg;
+    subsector_t*    sub;
+
+    for(view = 0; view < numcullviews; view++) {
+        dmemcpy(frustum, cullviews[view], sizeof(frustum));
+        R_FrustrumSetLanes();
+
+        start = I_GetTimeUS();
+
+        for(i = 0, seg = segs; i < numsegs; i++, seg++) {
+            int count = segpieces[i];
+            int bits;
+
+            if(!count) {
+                continue;
+            }
+
+#ifdef USE_SIMD_FRUSTRUM
+            if(simd) {
+                bits = R_FrustrumTestSegSIMD(F2D3D(seg->v1->x), F2D3D(seg->v1->y),
+                                             F2D3D(seg->v2->x), F2D3D(seg->v2->y),
+                                             &segz[i * MAXSEGPIECES * 2], count);
+            }
+            else
+#endif
+            {
+                bits = R_FrustrumTestSegScalar(F2D3D(seg->v1->x), F2D3D(seg->v1->y),
+                                               F2D3D(seg->v2->x), F2D3D(seg->v2->y),
+                                               &segz[i * MAXSEGPIECES * 2], count);
+            }
+
+            visible += (bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1);
+        }
+
+        time[0] += I_GetTimeUS() - start;
+        start = I_GetTimeUS();
+
+        for(i = 0, sub = subsectors; i < numsubsectors; i++, sub++) {
+            if(sub->numleafs < 3) {
+                continue;
+            }
+
+#ifdef USE_SIMD_FRUSTRUM
+            if(simd) {
+                visible += R_FrustrumTestVertexSIMD(&leafverts[sub->leaf], sub->numleafs);
+                visible += R_FrustrumTestVertexSIMD(&leafverts[numleafverts + sub->leaf], sub->numleafs);
+            }
+            else
+#endif
+            {
+                visible += R_FrustrumTestVertexScalar(&leafverts[sub->leaf], sub->numleafs);
+                visible += R_FrustrumTestVertexScalar(&leafverts[numleafverts + sub->leaf], sub->numleafs);
+            }
+        }
+
+        time[1] += I_GetTimeUS() - start;
+    }
+
+    return visible;
+}
+
+//
+// CMD_CullBench
+// Times the frustrum tests for all walls and flats of the level
+// from each of the last few views, with the scalar and the SIMD
+// path. Needs nothing from the GPU once the views are captured
+//
+
+static CMD(CullBench) {
+    int     runs = 100;
+    int     i;
+    int     j;
+    int     numleafverts = 0;
+    int     pieces = 0;
+    int     piece[MAXSEGPIECES];
+    int     visible[2] = { 0, 0 };
+    uint64  scalartime[2] = { 0, 0 };
+    uint64  simdtime[2] = { 0, 0 };
+    int*    segpieces;
+    float*  segz;
+    vtx_t*  leafverts;
+    float   saved[6][4];
+    leaf_t* leaf;
+
+    if(gamestate != GS_LEVEL) {
+        return;
+    }
+
+    if(!numcullviews) {
+        CON_Printf(WHITE, "cullbench: No views captured yet\n");
+        return;
+    }
+
+    if(param[0]) {
+        runs = MAX(datoi(param[0]), 1);
+    }
+
+    // the wall pieces and flats as the bsp walk would test them
+    segpieces = (int*)Z_Malloc(sizeof(int) * numsegs, PU_STATIC, NULL);
+    segz = (float*)Z_Malloc(sizeof(float) * numsegs * MAXSEGPIECES * 2, PU_STATIC, NULL);
+
+    for(i = 0; i < numsegs; i++) {
+        segpieces[i] = R_GetSegPieces(&segs[i], &segz[i * MAXSEGPIECES * 2], piece);
+        pieces += segpieces[i];
+    }
+
+    for(i = 0; i < numsubsectors; i++) {
+        if(subsectors[i].leaf + subsectors[i].numleafs > numleafverts) {
+            numleafverts = subsectors[i].leaf + subsectors[i].numleafs;
+        }
+    }
+
+    leafverts = (vtx_t*)Z_Malloc(sizeof(vtx_t) * numleafverts * 2, PU_STATIC, NULL);
+
+    for(i = 0; i < numsubsectors; i++) {
+        for(j = 0; j < subsectors[i].numleafs; j++) {
+            vtx_t* floor = &leafverts[subsectors[i].leaf + j];
+            vtx_t* ceiling = &leafverts[numleafverts + subsectors[i].leaf + j];
+
+            leaf = &leafs[subsectors[i].leaf + j];
+
+            floor->x = ceiling->x = F2D3D(leaf->vertex->x);
+            floor->y = ceiling->y = F2D3D(leaf->vertex->y);
+            floor->z = F2D3D(subsectors[i].sector->floorheight);
+            ceiling->z = F2D3D(subsectors[i].sector->ceilingheight);
+        }
+    }
+
+    dmemcpy(saved, frustum, sizeof(frustum));
+
+    for(i = 0; i < runs; i++) {
+        visible[0] = R_CullBenchPass(false, segz, segpieces, leafverts, numleafverts, scalartime);
+#ifdef USE_SIMD_FRUSTRUM
+        visible[1] = R_CullBenchPass(true, segz, segpieces, leafverts, numleafverts, simdtime);
+#endif
+    }
+
+    dmemcpy(frustum, saved, sizeof(frustum));
+    R_FrustrumSetLanes();
+
+    Z_Free(segpieces);
+    Z_Free(segz);
+    Z_Free(leafverts);
+
+    CON_Printf(WHITE, "cullbench: %i views, %i wall pieces, %i subsectors, %i runs\n",
+               numcullviews, pieces, numsubsectors, runs);
+    CON_Printf(WHITE, "walls: scalar %i us, simd %i us\n",
+               (int)(scalartime[0] / runs), (int)(simdtime[0] / runs));
+    CON_Printf(WHITE, "flats: scalar %i us, simd %i us\n",
+               (int)(scalartime[1] / runs), (int)(simdtime[1] / runs));
+
+#ifdef USE_SIMD_FRUSTRUM
+    if(visible[0] != visible[1]) {
+        CON_Warnf("cullbench: scalar saw %i visible, simd saw %i\n", visible[0], visible[1]);
+    }
+#else
+    CON_Printf(WHITE, "No SIMD path in this build\n");
+#endif
+}
+
+//
+// R_RegisterClipperCommands
+//
+
+void R_RegisterClipperCommands(void) {
+    G_AddCommand("cullbench", CMD_CullBench, 0);
+}
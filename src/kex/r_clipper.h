@@ -28,10 +28,14 @@ dboolean    R_Clipper_SafeCheckRange(angle_t startAngle, angle_t endAngle);
 void        R_Clipper_SafeAddClipRange(angle_t startangle, angle_t endangle);
 void        R_Clipper_Clear(void);
 
+#define MAXSEGPIECES    3
+
 extern float frustum[6][4];
 
 angle_t     R_FrustumAngle(void);
 void        R_FrustrumSetup(void);
 dboolean    R_FrustrumTestVertex(vtx_t* vertex, int count);
+int         R_FrustrumTestSeg(float x1, float y1, float x2, float y2, float* z, int count);
+void        R_RegisterClipperCommands(void);
 
 #endif
\ No newline at end of file
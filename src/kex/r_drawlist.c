@@ -34,12 +34,36 @@
 #include "r_drawlist.h"
 #include "i_system.h"
 #include "z_zone.h"
+#include "con_console.h"
+#include "g_actions.h"
+#include "d_prof.h"
 
 static float envcolor[4] = { 0, 0, 0, 0 };
 
 drawlist_t drawlist[NUMDRAWLISTS];
 
+// draw list entries handed to DL_ProcessDrawList and the
+// number of draws they went out in
+int dlEntryCount = 0;
+int dlDrawCount = 0;
+
 CVAR_EXTERNAL(r_texturecombiner);
+CVAR(r_batchdrawlists, 1);
+
+// sort keys for DL_SortDrawList. the arrays are kept around
+// and only grown so sorting doesn't touch the zone every frame
+typedef struct {
+    uint64  key;
+    int     index;
+} dlsortkey_t;
+
+static dlsortkey_t* dlsortkeys = NULL;
+static vtxlist_t*   dlsortlists = NULL;
+static int          dlsortmax = 0;
+
+// draw lists still to be replayed by the dlbench command
+static int          dlbenchtags = 0;
+static int          dlbenchcount = 0;
 
 //
 // DL_AddVertexList
@@ -82,6 +106,23 @@ static int SortDrawList(const void *a, const void *b) {
     return xb->texid - xa->texid;
 }
 
+//
+// SortDrawListBatched
+// Same as SortDrawList but also groups entries by their light
+// params, so every texture and light pair becomes a single draw
+//
+
+static int SortDrawListBatched(const void *a, const void *b) {
+    vtxlist_t *xa = (vtxlist_t *)a;
+    vtxlist_t *xb = (vtxlist_t *)b;
+
+    if(xa->texid != xb->texid) {
+        return xb->texid - xa->texid;
+    }
+
+    return xb->params - xa->params;
+}
+
 //
 // SortSprites
 //
@@ -94,32 +135,200 @@ static int SortSprites(const vtxlist_t *a, const vtxlist_t *b) {
 }
 
 //
-// DL_ProcessDrawList
+// DL_GetSortKey
+// Builds a key that sorts ascending in the same order the
+// comparators above sort in
 //
 
-void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
-    drawlist_t* dl;
-    int i;
-    int drawcount = 0;
-    vtxlist_t* head;
-    vtxlist_t* tail;
-    dboolean checkNightmare = false;
+d_inline static uint64 DL_GetSortKey(int tag, vtxlist_t* vl, dboolean batch) {
+    if(tag == DLT_SPRITE) {
+        // farthest first. flip the sign bit so negative
+        // distances order correctly as unsigned
+        return ~(uint64)((uint32)((visspritelist_t*)vl->data)->dist ^ 0x80000000);
+    }
 
-    if(tag < 0 && tag >= NUMDRAWLISTS) {
+    if(batch) {
+        return ~(((uint64)(uint32)vl->texid << 32) | (uint32)vl->params);
+    }
+
+    return ~(uint64)(uint32)vl->texid;
+}
+
+//
+// DL_ReserveSortKeys
+//
+
+static void DL_ReserveSortKeys(int n) {
+    if(n <= dlsortmax) {
         return;
     }
 
-    dl = &drawlist[tag];
+    dlsortmax = n + 256;
+    dlsortkeys = (dlsortkey_t*)Z_Realloc(dlsortkeys,
+                                         dlsortmax * 2 * sizeof(dlsortkey_t), PU_STATIC, NULL);
+    dlsortlists = (vtxlist_t*)Z_Realloc(dlsortlists,
+                                        dlsortmax * sizeof(vtxlist_t), PU_STATIC, NULL);
+}
 
-    if(dl->max > 0) {
-        int palette = 0;
+//
+// DL_SortDrawList
+// Sorts a draw list by radix sorting extracted keys, then
+// moving each entry once. Byte passes where every key has the
+// same digit (the high bytes of texids, mostly) are skipped
+//
+
+static void DL_SortDrawList(int tag, drawlist_t* dl, dboolean batch) {
+    int             count[8][256];
+    int             i;
+    int             pass;
+    int             n = dl->index;
+    dboolean        sorted = true;
+    dlsortkey_t*    src;
+    dlsortkey_t*    dst;
+
+    if(n < 2) {
+        return;
+    }
+
+    DL_ReserveSortKeys(n);
+
+    src = dlsortkeys;
+    dst = dlsortkeys + dlsortmax;
+
+    dmemset(count, 0, sizeof(count));
+
+    for(i = 0; i < n; i++) {
+        uint64 key = DL_GetSortKey(tag, &dl->list[i], batch);
+
+        src[i].key = key;
+        src[i].index = i;
+
+        if(i && key < src[i - 1].key) {
+            sorted = false;
+        }
+
+        for(pass = 0; pass < 8; pass++) {
+            count[pass][(key >> (pass << 3)) & 0xff]++;
+        }
+    }
+
+    // nothing to do if the list came in already in order
+    if(sorted) {
+        return;
+    }
+
+    for(pass = 0; pass < 8; pass++) {
+        int* c = count[pass];
+        int shift = pass << 3;
+        int sum = 0;
+        int b;
+
+        // every key has the same digit here
+        if(c[(src[0].key >> shift) & 0xff] == n) {
+            continue;
+        }
+
+        for(b = 0; b < 256; b++) {
+            int t = c[b];
+
+            c[b] = sum;
+            sum += t;
+        }
+
+        for(i = 0; i < n; i++) {
+            dst[c[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+
+        // swap buffers
+        {
+            dlsortkey_t* t = src;
+
+            src = dst;
+            dst = t;
+        }
+    }
+
+    for(i = 0; i < n; i++) {
+        dlsortlists[i] = dl->list[src[i].index];
+    }
+
+    dmemcpy(dl->list, dlsortlists, n * sizeof(vtxlist_t));
+}
+
+//
+// DL_BenchmarkSort
+// Replays the unsorted draw list through the old qsort
+// path and DL_SortDrawList and prints how long each took
+//
+
+static void DL_BenchmarkSort(int tag, drawlist_t* dl, dboolean batch) {
+    static const char* tagnames[NUMDRAWLISTS] = { "wall", "flat", "sprite", "amap" };
+    vtxlist_t*  capture;
+    size_t      size;
+    uint64      start;
+    uint64      qsorttime;
+    uint64      radixtime;
+    int         i;
+
+    size = dl->index * sizeof(vtxlist_t);
+
+    if(!size) {
+        return;
+    }
+
+    capture = (vtxlist_t*)Z_Malloc(size, PU_STATIC, NULL);
+    dmemcpy(capture, dl->list, size);
+
+    start = I_GetTimeUS();
+    for(i = 0; i < dlbenchcount; i++) {
+        dmemcpy(dl->list, capture, size);
 
         if(tag != DLT_SPRITE) {
-            qsort(dl->list, dl->index, sizeof(vtxlist_t), SortDrawList);
+            qsort(dl->list, dl->index, sizeof(vtxlist_t),
+                  batch ? SortDrawListBatched : SortDrawList);
         }
-        else if(dl->index >= 2) {
+        else {
             qsort(dl->list, dl->index, sizeof(vtxlist_t), SortSprites);
         }
+    }
+    qsorttime = I_GetTimeUS() - start;
+
+    start = I_GetTimeUS();
+    for(i = 0; i < dlbenchcount; i++) {
+        dmemcpy(dl->list, capture, size);
+        DL_SortDrawList(tag, dl, batch);
+    }
+    radixtime = I_GetTimeUS() - start;
+
+    // leave the list the way it was captured
+    dmemcpy(dl->list, capture, size);
+    Z_Free(capture);
+
+    CON_Printf(WHITE, "%s: %i entries, qsort %i us, radix %i us (%i runs)\n",
+               tagnames[tag], dl->index, (int)qsorttime, (int)radixtime, dlbenchcount);
+}
+
+//
+// DL_DrawList
+// Draws a sorted list, batching entries that share
+// a texture and light into a single draw
+//
+
+static void DL_DrawList(int tag, drawlist_t* dl, dboolean(*procfunc)(vtxlist_t*, int*)) {
+    int i;
+    int drawcount = 0;
+    vtxlist_t* head;
+    vtxlist_t* tail;
+    dboolean checkNightmare = false;
+    dboolean batch = (r_batchdrawlists.value > 0);
+    dtexture lasttexid = (dtexture)-1;
+    dtexture fulltexid;
+    dtexture texid;
+
+    PROF_BEGIN(PROF_DRAWWALLS + tag);
+
+    if(dl->max > 0) {
+        int palette = 0;
 
         tail = &dl->list[dl->index];
 
@@ -143,6 +352,10 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
                 }
             }
 
+            if(devparm) {
+                dlEntryCount++;
+            }
+
             rover = head + 1;
 
             if(tag != DLT_SPRITE) {
@@ -153,34 +366,37 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
                 }
             }
 
-            // setup texture ID
-            if(tag == DLT_SPRITE) {
-                int flags = ((visspritelist_t*)head->data)->spr->flags;
+            fulltexid = head->texid;
 
+            // setup texture ID. the list itself is left alone
+            // so that a prepared frame can be drawn again
+            if(tag == DLT_SPRITE) {
                 // textid in sprites contains hack that stores palette index data
                 palette = head->texid >> 24;
-                head->texid = head->texid & 0xffff;
-                GL_BindSpriteTexture(head->texid, palette);
+                texid = head->texid & 0xffff;
+                GL_BindSpriteTexture(texid, palette);
 
                 // villsa 12152013 - change blend states for nightmare things
-                if((checkNightmare ^ (flags & MF_NIGHTMARE))) {
-                    if(!checkNightmare && (flags & MF_NIGHTMARE)) {
+                if((checkNightmare ^ ((head->flags & DLF_NIGHTMARE) != 0))) {
+                    if(!checkNightmare && (head->flags & DLF_NIGHTMARE)) {
                         dglBlendFunc(GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR);
                         checkNightmare ^= 1;
                     }
-                    else if(checkNightmare && !(flags & MF_NIGHTMARE)) {
+                    else if(checkNightmare && !(head->flags & DLF_NIGHTMARE)) {
                         dglBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
                         checkNightmare ^= 1;
                     }
                 }
             }
             else {
-                head->texid = (head->texid & 0xffff);
-                GL_BindWorldTexture(head->texid, 0, 0);
+                texid = (head->texid & 0xffff);
+                GL_BindWorldTexture(texid, 0, 0);
             }
 
-            // non sprite textures must repeat or mirrored-repeat
-            if(tag == DLT_WALL) {
+            // non sprite textures must repeat or mirrored-repeat.
+            // the mirror flags are part of the sorted texid, so the wrap
+            // modes only need setting when the texid changes
+            if(tag == DLT_WALL && (!batch || fulltexid != lasttexid)) {
                 dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
                                  head->flags & DLF_MIRRORS ? GL_MIRRORED_REPEAT : GL_REPEAT);
                 dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
@@ -198,16 +414,102 @@ void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
             }
 
             dglDrawGeometry(drawcount, drawVertex);
+            lasttexid = fulltexid;
 
             // count vertex size
             if(devparm) {
                 vertCount += drawcount;
+                dlDrawCount++;
             }
 
             drawcount = 0;
-            head->data = NULL;
         }
     }
+
+    PROF_END(PROF_DRAWWALLS + tag);
+}
+
+//
+// DL_ProcessDrawList
+// Sorts and draws one of the lists in drawlist
+//
+
+void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*)) {
+    drawlist_t* dl;
+    dboolean batch = (r_batchdrawlists.value > 0);
+
+    if(tag < 0 || tag >= NUMDRAWLISTS) {
+        return;
+    }
+
+    dl = &drawlist[tag];
+
+    if(dl->max > 0) {
+        if(dlbenchtags & (1 << tag)) {
+            DL_BenchmarkSort(tag, dl, batch);
+            dlbenchtags &= ~(1 << tag);
+        }
+
+        DL_SortDrawList(tag, dl, batch);
+    }
+
+    DL_DrawList(tag, dl, procfunc);
+}
+
+//
+// DL_PrepareDrawList
+// Sorts one of the world lists, has genfunc write out the vertices
+// of every entry and hands the list over to the frame. May run on
+// a worker thread, so nothing in here can be allowed to grow
+//
+
+void DL_PrepareDrawList(int tag, drawframe_t* frame, int(*genfunc)(vtxlist_t*, vtx_t*)) {
+    drawlist_t* dl;
+    drawlist_t swap;
+    vtxlist_t* vl;
+    int i;
+    dboolean batch = (r_batchdrawlists.value > 0);
+
+    if(tag < 0 || tag >= NUMDRAWLISTS) {
+        return;
+    }
+
+    dl = &drawlist[tag];
+
+    if(dlbenchtags & (1 << tag)) {
+        DL_BenchmarkSort(tag, dl, batch);
+        dlbenchtags &= ~(1 << tag);
+    }
+
+    DL_SortDrawList(tag, dl, batch);
+
+    for(i = 0; i < dl->index; i++) {
+        vl = &dl->list[i];
+
+        vl->vertex = frame->numvertex;
+        vl->numverts = genfunc(vl, &frame->vertex[frame->numvertex]);
+
+        frame->numvertex += vl->numverts;
+    }
+
+    // the frame's old list is what the next walk fills in
+    swap = frame->list[tag];
+    frame->list[tag] = *dl;
+    *dl = swap;
+    dl->index = 0;
+}
+
+//
+// DL_ProcessFrameList
+// Draws one of the lists of a prepared frame
+//
+
+void DL_ProcessFrameList(int tag, drawframe_t* frame, dboolean(*procfunc)(vtxlist_t*, int*)) {
+    if(tag < 0 || tag >= NUMDRAWLISTS) {
+        return;
+    }
+
+    DL_DrawList(tag, &frame->list[tag], procfunc);
 }
 
 //
@@ -245,9 +547,88 @@ void DL_BeginDrawList(dboolean t, dboolean a) {
     }
 }
 
+//
+// CMD_DrawListBench
+// Times sorting of the next frame's draw lists
+//
+
+static CMD(DrawListBench) {
+    dlbenchcount = 1000;
+
+    if(param[0]) {
+        dlbenchcount = datoi(param[0]);
+    }
+
+    if(dlbenchcount <= 0) {
+        dlbenchcount = 1;
+    }
+
+    dlbenchtags = (1 << NUMDRAWLISTS) - 1;
+}
+
+//
+// DL_BenchPending
+// True if dlbench is waiting on one of the world lists
+//
+
+dboolean DL_BenchPending(void) {
+    return (dlbenchtags & ((1 << DLT_AMAP) - 1)) != 0;
+}
+
+//
+// DL_RegisterCommands
+//
+
+void DL_RegisterCommands(void) {
+    G_AddCommand("dlbench", CMD_DrawListBench, 0);
+}
+
+//
+// DL_MaxEntries
+// Most entries a frame can add to one of the world lists. A seg can
+// have a lower, upper and middle part each with a switch quad, and
+// a subsector can have two water layers and a ceiling
+//
+
+static int DL_MaxEntries(int tag) {
+    switch(tag) {
+    case DLT_WALL:
+        return numsegs * 6;
+    case DLT_FLAT:
+        return numsubsectors * 3;
+    case DLT_SPRITE:
+        return MAX_SPRITES;
+    default:
+        return 0;
+    }
+}
+
+//
+// DL_InitFrame
+// Allocates a frame big enough for anything the level can throw at
+// it, so that preparing it never has to go through the zone
+//
+
+void DL_InitFrame(drawframe_t* frame) {
+    int i;
+
+    for(i = 0; i < DLT_AMAP; i++) {
+        frame->list[i].index = 0;
+        frame->list[i].max = DL_MaxEntries(i) + 1;
+        frame->list[i].list = Z_Calloc(sizeof(vtxlist_t) * frame->list[i].max, PU_LEVEL, 0);
+    }
+
+    frame->vertex = Z_Malloc(sizeof(vtx_t) *
+                             (DL_MaxEntries(DLT_WALL) * 4 + numleafs * 3 + MAX_SPRITES * 4), PU_LEVEL, 0);
+    frame->numvertex = 0;
+    frame->sky = false;
+    frame->frame = -1;
+}
+
 //
 // DL_Init
-// Intialize draw lists
+// Intialize draw lists. The world lists get their full size
+// up front for the same reason as the frames
 //
 
 void DL_Init(void) {
@@ -258,8 +639,10 @@ void DL_Init(void) {
         dl = &drawlist[i];
 
         dl->index   = 0;
-        dl->max     = 1;
+        dl->max     = DL_MaxEntries(i) + 1;
         dl->list    = Z_Calloc(sizeof(vtxlist_t) * dl->max, PU_LEVEL, 0);
+
+        DL_ReserveSortKeys(dl->max);
     }
 }
 
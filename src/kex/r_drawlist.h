@@ -34,7 +34,9 @@ typedef enum {
     DLF_CEILING     = 0x4,
     DLF_MIRRORS     = 0x8,
     DLF_MIRRORT     = 0x10,
-    DLF_WATER2      = 0x20
+    DLF_WATER2      = 0x20,
+    DLF_NIGHTMARE   = 0x40,
+    DLF_NOCULL      = 0x80
 } drawlistflag_e;
 
 typedef enum {
@@ -51,6 +53,8 @@ typedef struct {
     dtexture    texid;
     int         flags;
     int         params;
+    int         vertex;     // first vertex in the frame, once prepared
+    int         numverts;
 } vtxlist_t;
 
 typedef struct {
@@ -59,7 +63,28 @@ typedef struct {
     int         max;
 } drawlist_t;
 
+//
+// a frame of the world as left by the prepare stage. the wall, flat
+// and sprite lists are sorted and have their vertices generated, and
+// nothing in here points back into the playsim, so the frame can
+// still be drawn after the game has moved on
+//
+typedef struct {
+    drawlist_t  list[DLT_AMAP];
+    vtx_t       *vertex;
+    int         numvertex;
+    angle_t     viewangle;
+    angle_t     viewpitch;
+    float       viewx;
+    float       viewy;
+    float       viewz;
+    dboolean    sky;
+    int         frame;
+} drawframe_t;
+
 extern drawlist_t drawlist[NUMDRAWLISTS];
+extern int dlEntryCount;
+extern int dlDrawCount;
 
 #define MAXDLDRAWCOUNT  0x10000
 vtx_t drawVertex[MAXDLDRAWCOUNT];
@@ -72,8 +97,13 @@ vtxlist_t *DL_AddVertexList(drawlist_t *dl);
 int DL_GetDrawListSize(int tag);
 void DL_BeginDrawList(dboolean t, dboolean a);
 void DL_ProcessDrawList(int tag, dboolean(*procfunc)(vtxlist_t*, int*));
+void DL_PrepareDrawList(int tag, drawframe_t* frame, int(*genfunc)(vtxlist_t*, vtx_t*));
+void DL_ProcessFrameList(int tag, drawframe_t* frame, dboolean(*procfunc)(vtxlist_t*, int*));
+void DL_InitFrame(drawframe_t* frame);
+dboolean DL_BenchPending(void);
 void DL_RenderDrawList(void);
 void DL_Init(void);
+void DL_RegisterCommands(void);
 
 #endif
 
@@ -0,0 +1,472 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+//
+// DESCRIPTION: Level geometry cache. Wall and flat vertices are kept
+//              for the lifetime of the level and only rebuilt when the
+//              sector(s) they belong to have moved, scrolled or changed
+//              their lighting. Only sectors on the playsim's dirty
+//              list, or using a light on its dirty list, are checked
+//              for changes.
+//
+//-----------------------------------------------------------------------------
+
+#include "doomstat.h"
+#include "z_zone.h"
+#include "p_local.h"
+#include "r_geom.h"
+#include "r_sky.h"
+
+CVAR(r_geometrycache, 1);
+
+CVAR_EXTERNAL(i_interpolateframes);
+
+typedef struct {
+    int         frontstamp;
+    int         backstamp;
+    fixed_t     textureoffset;
+    fixed_t     rowoffset;
+    short       toptexture;
+    short       bottomtexture;
+    short       midtexture;
+    int         lineflags;
+    dboolean    visible;
+    vtx_t       v[4];
+} seggeom_t;
+
+static sectorgeom_t*    sectorgeom = NULL;
+static seggeom_t*       seggeom = NULL;
+static int*             leafstamps = NULL;
+static vtx_t*           leafverts = NULL;
+static int              numleafverts = 0;
+static int              geomframe = 0;
+static int              geomstamp = 0;
+static int              geominterp = -1;
+
+// sectors using each light, lightsectors[lightfirst[i]] up to
+// lightsectors[lightfirst[i + 1]] for light i. sectorlights holds
+// the light indexes of every sector that the table was built from
+static int*             lightfirst = NULL;
+static int*             lightsectors = NULL;
+static word*            sectorlights = NULL;
+
+int geomHits = 0;
+int geomMisses = 0;
+
+//
+// R_RefreshSectorGeometry
+// Returns true if any render state of the sector is
+// different from what was last recorded
+//
+
+static dboolean R_RefreshSectorGeometry(sectorgeom_t* sg, sector_t* sector) {
+    sectorgeom_t    cur;
+    int             i;
+
+    cur.floorheight = sector->floorheight;
+    cur.ceilingheight = sector->ceilingheight;
+
+    if(i_interpolateframes.value) {
+        cur.floorz = sector->frame_z1[1];
+        cur.ceilingz = sector->frame_z2[1];
+    }
+    else {
+        cur.floorz = sector->floorheight;
+        cur.ceilingz = sector->ceilingheight;
+    }
+
+    cur.xoffset = sector->xoffset;
+    cur.yoffset = sector->yoffset;
+    cur.flags = sector->flags;
+    cur.skyceiling = (sector->ceilingpic == skyflatnum);
+
+    for(i = 0; i < 5; i++) {
+        cur.colors[i] = R_GetSectorLight(0xff, sector->colors[i]);
+    }
+
+    for(i = 0; i < 5; i++) {
+        if(sg->colors[i] != cur.colors[i]) {
+            break;
+        }
+    }
+
+    if(i == 5 &&
+            sg->floorheight == cur.floorheight &&
+            sg->ceilingheight == cur.ceilingheight &&
+            sg->floorz == cur.floorz &&
+            sg->ceilingz == cur.ceilingz &&
+            sg->xoffset == cur.xoffset &&
+            sg->yoffset == cur.yoffset &&
+            sg->flags == cur.flags &&
+            sg->skyceiling == cur.skyceiling) {
+        return false;
+    }
+
+    cur.frame = sg->frame;
+    cur.stamp = sg->stamp;
+    cur.dirty = sg->dirty;
+
+    dmemcpy(sg, &cur, sizeof(sectorgeom_t));
+    return true;
+}
+
+//
+// R_BuildLightSectors
+//
+
+static void R_BuildLightSectors(void) {
+    int i;
+    int j;
+    int idx;
+
+    dmemset(lightfirst, 0, sizeof(int) * (numlights + 1));
+
+    for(i = 0; i < numsectors; i++) {
+        for(j = 0; j < 5; j++) {
+            sectorlights[i * 5 + j] = sectors[i].colors[j];
+            lightfirst[sectors[i].colors[j]]++;
+        }
+    }
+
+    // turn the counts into the end of each light's run
+    for(i = 1; i < numlights; i++) {
+        lightfirst[i] += lightfirst[i - 1];
+    }
+
+    lightfirst[numlights] = numsectors * 5;
+
+    // filling in back to front leaves each entry
+    // pointing at the start of its light's run
+    for(i = numsectors - 1; i >= 0; i--) {
+        for(j = 4; j >= 0; j--) {
+            idx = sectors[i].colors[j];
+            lightsectors[--lightfirst[idx]] = i;
+        }
+    }
+}
+
+//
+// R_SectorLightsChanged
+// True if the sector has been given other lights
+// since the light table was built
+//
+
+static dboolean R_SectorLightsChanged(sector_t* sector) {
+    word*   idx = &sectorlights[(sector - sectors) * 5];
+    int     i;
+
+    for(i = 0; i < 5; i++) {
+        if(idx[i] != sector->colors[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//
+// R_InitGeometryCache
+// Called from R_SetupLevel. All buffers are level tagged and
+// go away with the rest of the level
+//
+
+void R_InitGeometryCache(void) {
+    int i;
+
+    sectorgeom = (sectorgeom_t*)Z_Calloc(sizeof(sectorgeom_t) * numsectors, PU_LEVEL, 0);
+    seggeom = (seggeom_t*)Z_Calloc(sizeof(seggeom_t) * numsegs * NUMSEGPARTS, PU_LEVEL, 0);
+    leafstamps = (int*)Z_Calloc(sizeof(int) * numsubsectors * 2, PU_LEVEL, 0);
+
+    numleafverts = 0;
+    for(i = 0; i < numsubsectors; i++) {
+        if(subsectors[i].leaf + subsectors[i].numleafs > numleafverts) {
+            numleafverts = subsectors[i].leaf + subsectors[i].numleafs;
+        }
+    }
+
+    leafverts = (vtx_t*)Z_Malloc(sizeof(vtx_t) * numleafverts * 2, PU_LEVEL, 0);
+
+    lightfirst = (int*)Z_Malloc(sizeof(int) * (numlights + 1), PU_LEVEL, 0);
+    lightsectors = (int*)Z_Malloc(sizeof(int) * numsectors * 5, PU_LEVEL, 0);
+    sectorlights = (word*)Z_Malloc(sizeof(word) * numsectors * 5, PU_LEVEL, 0);
+
+    R_BuildLightSectors();
+
+    geomframe = 0;
+    geomstamp = 0;
+    geominterp = -1;
+
+    // stamps start at 1 so that the zeroed
+    // seg and leaf entries are never valid
+    for(i = 0; i < numsectors; i++) {
+        R_RefreshSectorGeometry(&sectorgeom[i], &sectors[i]);
+        sectorgeom[i].stamp = ++geomstamp;
+    }
+}
+
+//
+// R_GeometryNewFrame
+// Picks up the sectors the playsim has flagged as changed since
+// the last frame, along with the sectors using any light that
+// has changed color. Sectors that are still moving are in between
+// tics and need to be looked at every frame
+//
+
+void R_GeometryNewFrame(void) {
+    int         i;
+    int         j;
+    dboolean    rebuild = false;
+
+    geomframe++;
+
+    if(geominterp != (int)i_interpolateframes.value) {
+        geominterp = (int)i_interpolateframes.value;
+        allsectorsdirty = true;
+    }
+
+    if(allsectorsdirty) {
+        for(i = 0; i < numsectors; i++) {
+            sectorgeom[i].dirty = true;
+        }
+
+        R_BuildLightSectors();
+    }
+    else {
+        for(i = 0; i < numdirtysectors; i++) {
+            sectorgeom[dirtysectors[i] - sectors].dirty = true;
+
+            if(R_SectorLightsChanged(dirtysectors[i])) {
+                rebuild = true;
+            }
+        }
+
+        if(rebuild) {
+            R_BuildLightSectors();
+        }
+
+        for(i = 0; i < numdirtylights; i++) {
+            for(j = lightfirst[dirtylights[i]]; j < lightfirst[dirtylights[i] + 1]; j++) {
+                sectorgeom[lightsectors[j]].dirty = true;
+            }
+        }
+
+        if(geominterp) {
+            for(i = 0; i < nummovingsectors; i++) {
+                sectorgeom[movingsectors[i] - sectors].dirty = true;
+            }
+        }
+    }
+
+    P_ClearDirtySectors();
+}
+
+//
+// R_GetSectorGeometry
+//
+
+sectorgeom_t* R_GetSectorGeometry(sector_t* sector) {
+    sectorgeom_t* sg = &sectorgeom[sector - sectors];
+
+    if(sg->frame != geomframe) {
+        sg->frame = geomframe;
+
+        if(sg->dirty) {
+            sg->dirty = false;
+
+            if(R_RefreshSectorGeometry(sg, sector)) {
+                sg->stamp = ++geomstamp;
+            }
+        }
+    }
+
+    return sg;
+}
+
+//
+// R_SetBspColors
+// Points bspColor at the front sector's finished
+// colors for the seg generators
+//
+
+static void R_SetBspColors(seg_t* line) {
+    dmemcpy(bspColor, R_GetSectorGeometry(line->frontsector)->colors, sizeof(bspColor));
+}
+
+//
+// R_GetSegGeometry
+// Copies the cached vertices of a seg part into v, calling
+// generate to rebuild them if the seg or its sectors changed
+//
+
+dboolean R_GetSegGeometry(seg_t* line, int part, seggenfunc_t generate, vtx_t* v) {
+    seggeom_t*  sg;
+    side_t*     side;
+    int         frontstamp;
+    int         backstamp;
+    int         flags;
+
+    if(r_geometrycache.value <= 0) {
+        R_SetBspColors(line);
+        return generate(line, v);
+    }
+
+    sg = &seggeom[(line - segs) * NUMSEGPARTS + part];
+    side = line->sidedef;
+
+    frontstamp = R_GetSectorGeometry(line->frontsector)->stamp;
+    backstamp = line->backsector ? R_GetSectorGeometry(line->backsector)->stamp : 0;
+
+    // ML_MAPPED gets set while walking the bsp and
+    // has nothing to do with how the seg looks
+    flags = line->linedef->flags & ~ML_MAPPED;
+
+    if(sg->frontstamp == frontstamp &&
+            sg->backstamp == backstamp &&
+            sg->textureoffset == side->textureoffset &&
+            sg->rowoffset == side->rowoffset &&
+            sg->toptexture == side->toptexture &&
+            sg->bottomtexture == side->bottomtexture &&
+            sg->midtexture == side->midtexture &&
+            sg->lineflags == flags) {
+        geomHits++;
+
+        if(!sg->visible) {
+            return false;
+        }
+
+        dmemcpy(v, sg->v, sizeof(sg->v));
+        return true;
+    }
+
+    geomMisses++;
+
+    sg->frontstamp = frontstamp;
+    sg->backstamp = backstamp;
+    sg->textureoffset = side->textureoffset;
+    sg->rowoffset = side->rowoffset;
+    sg->toptexture = side->toptexture;
+    sg->bottomtexture = side->bottomtexture;
+    sg->midtexture = side->midtexture;
+    sg->lineflags = flags;
+
+    R_SetBspColors(line);
+    sg->visible = generate(line, sg->v);
+
+    if(!sg->visible) {
+        return false;
+    }
+
+    dmemcpy(v, sg->v, sizeof(sg->v));
+    return true;
+}
+
+//
+// R_GenerateLeafPlane
+//
+
+static void R_GenerateLeafPlane(subsector_t* sub, dboolean ceiling, vtx_t* v) {
+    int         j;
+    fixed_t     tx;
+    fixed_t     ty;
+    fixed_t     z;
+    rcolor      color;
+    leaf_t*     leaf;
+    sector_t*   sector;
+    vtx_t*      start = v;
+
+    leaf    = &leafs[sub->leaf];
+    sector  = sub->sector;
+
+    // need to keep texture coords small to avoid
+    // floor 'wobble' due to rounding errors on some cards
+    // make relative to first vertex, not (0,0)
+    // which is arbitary anyway
+
+    tx = (leaf->vertex->x >> 6) & ~(FRACUNIT - 1);
+    ty = (leaf->vertex->y >> 6) & ~(FRACUNIT - 1);
+
+    if(ceiling) {
+        z = i_interpolateframes.value ? sector->frame_z2[1] : sector->ceilingheight;
+        color = R_GetSectorGeometry(sector)->colors[LIGHT_CEILING];
+    }
+    else {
+        z = i_interpolateframes.value ? sector->frame_z1[1] : sector->floorheight;
+        color = R_GetSectorGeometry(sector)->colors[LIGHT_FLOOR];
+    }
+
+    for(j = 0; j < sub->numleafs; j++, v++) {
+        if(ceiling) {
+            leaf = &leafs[(sub->leaf + (sub->numleafs - 1)) - j];
+        }
+        else {
+            leaf = &leafs[sub->leaf + j];
+        }
+
+        v->x = F2D3D(leaf->vertex->x);
+        v->y = F2D3D(leaf->vertex->y);
+        v->z = F2D3D(z);
+
+        v->tu = F2D3D((leaf->vertex->x >> 6) - tx);
+        v->tv = -F2D3D((leaf->vertex->y >> 6) - ty);
+
+        // set the mapping offsets for scrolling floors/ceilings
+        if((!ceiling && sector->flags & MS_SCROLLFLOOR) ||
+                (ceiling && sector->flags & MS_SCROLLCEILING)) {
+            v->tu   += F2D3D(sector->xoffset >> 6);
+            v->tv   += F2D3D(sector->yoffset >> 6);
+        }
+    }
+
+    dglSetVertexColor(start, color, sub->numleafs);
+}
+
+//
+// R_GetLeafGeometry
+// Copies the floor or ceiling vertices of a subsector into v,
+// rebuilding them if the sector changed. The water layer
+// adjustments are left to the caller
+//
+
+void R_GetLeafGeometry(subsector_t* sub, dboolean ceiling, vtx_t* v) {
+    int*    stamp;
+    vtx_t*  cache;
+    int     sectorstamp;
+
+    if(r_geometrycache.value <= 0) {
+        R_GenerateLeafPlane(sub, ceiling, v);
+        return;
+    }
+
+    stamp = &leafstamps[(sub - subsectors) * 2 + (ceiling ? 1 : 0)];
+    cache = &leafverts[sub->leaf + (ceiling ? numleafverts : 0)];
+    sectorstamp = R_GetSectorGeometry(sub->sector)->stamp;
+
+    if(*stamp != sectorstamp) {
+        geomMisses++;
+        R_GenerateLeafPlane(sub, ceiling, cache);
+        *stamp = sectorstamp;
+    }
+    else {
+        geomHits++;
+    }
+
+    dmemcpy(v, cache, sizeof(vtx_t) * sub->numleafs);
+}
@@ -0,0 +1,67 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright(C) 2007-2012 Samuel Villarreal
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+// 02111-1307, USA.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _R_GEOM_H_
+#define _R_GEOM_H_
+
+#include "r_local.h"
+
+typedef enum {
+    SEGPART_LOWER,
+    SEGPART_UPPER,
+    SEGPART_MIDDLE,
+    SEGPART_SWITCH,
+    NUMSEGPARTS
+} segpart_e;
+
+typedef dboolean(*seggenfunc_t)(seg_t*, vtx_t*);
+
+//
+// render state of a sector, refreshed at most once per frame.
+// stamp changes whenever anything that feeds the wall or
+// flat vertices of the sector changes
+//
+typedef struct {
+    int         frame;
+    int         stamp;
+    fixed_t     floorheight;
+    fixed_t     ceilingheight;
+    fixed_t     floorz;
+    fixed_t     ceilingz;
+    int         xoffset;
+    int         yoffset;
+    word        flags;
+    dboolean    skyceiling;
+    rcolor      colors[5];
+    dboolean    dirty;
+} sectorgeom_t;
+
+extern int geomHits;
+extern int geomMisses;
+
+void R_InitGeometryCache(void);
+void R_GeometryNewFrame(void);
+sectorgeom_t* R_GetSectorGeometry(sector_t* sector);
+dboolean R_GetSegGeometry(seg_t* line, int part, seggenfunc_t generate, vtx_t* v);
+void R_GetLeafGeometry(subsector_t* sub, dboolean ceiling, vtx_t* v);
+
+#endif
@@ -243,6 +243,8 @@ void R_SetLightFactor(float lightfactor) {
         light->active_g = light->base_g;
         light->active_b = light->base_b;
     }
+
+    P_MarkAllSectorsDirty();
 }
 
 //
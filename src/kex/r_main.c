@@ -45,8 +45,11 @@
 #include "z_zone.h"
 #include "con_console.h"
 #include "r_drawlist.h"
+#include "r_geom.h"
 #include "gl_draw.h"
 #include "g_actions.h"
+#include "d_prof.h"
+#include "i_thread.h"
 
 lumpinfo_t      *lumpinfo;
 int             skytexture;
@@ -80,6 +83,14 @@ unsigned int    glBindCalls = 0;
 
 dboolean        bRenderSky = false;
 
+// frames of the world being prepared and drawn. with
+// r_pipelineframes they take turns, one being walked
+// while the other is drawn
+static drawframe_t  drawframes[2];
+static int          curframe = 0;
+static int          renderframe = 0;
+static jobgroup_t*  rendergroup = NULL;
+
 CVAR(r_fov, 74.0);
 CVAR(r_fillmode, 1);
 CVAR(r_uniformtime, 0);
@@ -92,6 +103,10 @@ CVAR(r_drawtrace, 0);
 CVAR(r_rendersprites, 1);
 CVAR(r_drawfill, 0);
 CVAR(r_skybox, 0);
+CVAR(r_pipelineframes, 0);
+
+CVAR_EXTERNAL(r_batchdrawlists);
+CVAR_EXTERNAL(r_geometrycache);
 
 CVAR_CMD(r_colorscale, 0) {
     GL_SetColorScale();
@@ -293,6 +308,8 @@ void R_Init(void) {
     GL_ResetTextures();
 
     G_AddCommand("wireframe", CMD_Wireframe, 0);
+    DL_RegisterCommands();
+    R_RegisterClipperCommands();
 }
 
 //
@@ -343,8 +360,12 @@ void R_SetViewOffset(int offset) {
 void R_SetupLevel(void) {
     R_AllocSubsectorBuffer();
     R_RefreshBrightness();
+    R_InitGeometryCache();
 
     DL_Init();
+    DL_InitFrame(&drawframes[0]);
+    DL_InitFrame(&drawframes[1]);
+    curframe = 0;
 
     bRenderSky = true;
 }
@@ -363,6 +384,11 @@ void R_PrecacheLevel(void) {
     int num;
     mobj_t* mo;
 
+    // no GL context to upload to
+    if(nodrawers) {
+        return;
+    }
+
     CON_DPrintf("--------R_PrecacheLevel--------\n");
     GL_DumpTextures();
 
@@ -386,9 +412,11 @@ void R_PrecacheLevel(void) {
 
     num = 0;
 
+    GL_BeginTexturePrecache();
+
     for(i = 0; i < numtextures; i++) {
         if(texturepresent[i]) {
-            GL_BindWorldTexture(i, 0, 0);
+            GL_PrecacheWorldTexture(i);
             num++;
 
             for(p = 0; p < numanimdef; p++) {
@@ -403,7 +431,7 @@ void R_PrecacheLevel(void) {
                 //
                 if(!animdefs[p].palette) {
                     for(j = 1; j < animdefs[p].frames; j++) {
-                        GL_BindWorldTexture(i + j, 0, 0);
+                        GL_PrecacheWorldTexture(i + j);
                         num++;
                     }
                 }
@@ -436,18 +464,20 @@ void R_PrecacheLevel(void) {
                 sprframe = &sprdef->spriteframes[k];
                 if(sprframe->rotate) {
                     for(p = 0; p < 8; p++) {
-                        GL_BindSpriteTexture(sprframe->lump[p], 0);
+                        GL_PrecacheSpriteTexture(sprframe->lump[p]);
                         num++;
                     }
                 }
                 else {
-                    GL_BindSpriteTexture(sprframe->lump[0], 0);
+                    GL_PrecacheSpriteTexture(sprframe->lump[0]);
                     num++;
                 }
             }
         }
     }
 
+    GL_FinishTexturePrecache();
+
     CON_DPrintf("%i sprites cached\n", num);
 
     if(has_GL_ARB_multitexture) {
@@ -558,8 +588,9 @@ fixed_t R_Interpolate(fixed_t ticframe, fixed_t updateframe, dboolean enable) {
 static void R_InterpolateSectors(void) {
     int i;
 
-    for(i = 0; i < numsectors; i++) {
-        sector_t* s = &sectors[i];
+    // only sectors that moved during the last tic are in between frames
+    for(i = 0; i < nummovingsectors; i++) {
+        sector_t* s = movingsectors[i];
 
         s->frame_z1[1] = R_Interpolate(s->floorheight, s->frame_z1[0], 1);
         s->frame_z2[1] = R_Interpolate(s->ceilingheight, s->frame_z2[0], 1);
@@ -800,11 +831,63 @@ static void R_DrawContextWall(line_t* line) {
     GL_SetState(GLSTATE_BLEND, 0);
 }
 
+//
+// R_PrepareFrame
+// Walks the bsp and builds the draw lists of a frame. Runs on a
+// worker when frames are pipelined, while the main thread draws,
+// so it must stay away from GL and anything the drawing touches
+//
+
+static void R_PrepareFrame(void* data) {
+    drawframe_t* frame = (drawframe_t*)data;
+
+    //
+    // traverse BSP for rendering
+    //
+    bRenderSky = false;
+    R_RenderBSPNode(numnodes-1);
+    frame->sky = bRenderSky;
+
+    R_PrepareWorld(frame);
+}
+
+//
+// R_DrawFrame
+//
+
+static void R_DrawFrame(drawframe_t* frame) {
+    //
+    // check for t-junction cracks
+    //
+    if(r_drawfill.value >= 1) {
+        dglClearColor(1, 0, 1, 0);
+        dglClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    //
+    // draw sky
+    //
+    else if(frame->sky) {
+        R_DrawSky(frame->viewangle, frame->viewpitch);
+    }
+
+    R_SetViewMatrix(frame);
+
+    //
+    // render world
+    //
+    R_RenderWorld(frame);
+}
+
 //
 // R_RenderPlayerView
 //
 
 void R_RenderPlayerView(player_t *player) {
+    drawframe_t*    frame;
+    drawframe_t*    lastframe;
+    dboolean        pipeline;
+
     if(!r_fillmode.value) {
         dglPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
@@ -823,28 +906,19 @@ void R_RenderPlayerView(player_t *player) {
     //
     R_SetupFrame(player);
 
-    //
-    // check for t-junction cracks
-    //
-    if(r_drawfill.value >= 1) {
-        dglClearColor(1, 0, 1, 0);
-        dglClear(GL_COLOR_BUFFER_BIT);
-        bRenderSky = false;
-    }
-
-    //
-    // draw sky
-    //
-    if(bRenderSky) {
-        R_DrawSky();
-    }
+    frame = &drawframes[curframe];
+    lastframe = &drawframes[curframe ^ 1];
 
-    bRenderSky = false;
+    frame->viewangle = viewangle;
+    frame->viewpitch = viewpitch;
+    frame->viewx = fviewx;
+    frame->viewy = fviewy;
+    frame->viewz = fviewz;
 
     //
     // setup view matrix
     //
-    R_SetViewMatrix();
+    R_SetViewMatrix(frame);
 
     //
     // check for new console commands
@@ -863,20 +937,47 @@ void R_RenderPlayerView(player_t *player) {
         R_InterpolateSectors();
     }
 
-    //
-    // traverse BSP for rendering
-    //
-    R_RenderBSPNode(numnodes-1);
+    R_GeometryNewFrame();
 
     //
-    // check for new console commands
+    // with r_pipelineframes the walk runs on a worker while the
+    // frame walked during the last call gets drawn, so the world
+    // shows up a frame late but the walk stops holding up the
+    // draw. without a frame from the last call there's nothing to
+    // draw yet and this one is walked and drawn as usual
     //
-    NetUpdate();
+    pipeline = (r_pipelineframes.value > 0 && I_NumWorkers() > 0 && !DL_BenchPending());
 
-    //
-    // render world
-    //
-    R_RenderWorld();
+    if(pipeline && lastframe->frame >= 0 && lastframe->frame == renderframe - 1) {
+        if(!rendergroup) {
+            rendergroup = I_CreateJobGroup();
+        }
+
+        I_QueueJob(rendergroup, R_PrepareFrame, frame);
+        R_DrawFrame(lastframe);
+
+        PROF_BEGIN(PROF_RENDERBSP);
+        I_WaitJobGroup(rendergroup);
+        PROF_END(PROF_RENDERBSP);
+    }
+    else {
+        PROF_BEGIN(PROF_RENDERBSP);
+        R_PrepareFrame(frame);
+        PROF_END(PROF_RENDERBSP);
+
+        //
+        // check for new console commands
+        //
+        NetUpdate();
+
+        R_DrawFrame(frame);
+    }
+
+    frame->frame = renderframe++;
+
+    if(pipeline) {
+        curframe ^= 1;
+    }
 
     if(r_drawblockmap.value) {
         R_DrawBlockMap();
@@ -942,6 +1043,9 @@ void R_RegisterCvars(void) {
     CON_CvarRegister(&r_drawfill);
     CON_CvarRegister(&r_skybox);
     CON_CvarRegister(&r_colorscale);
+    CON_CvarRegister(&r_batchdrawlists);
+    CON_CvarRegister(&r_geometrycache);
+    CON_CvarRegister(&r_pipelineframes);
 }
 
 
@@ -29,6 +29,7 @@
 #include "w_wad.h"
 #include "gl_main.h"
 #include "con_cvar.h"
+#include "r_drawlist.h"
 
 extern fixed_t      viewx;
 extern fixed_t      viewy;
@@ -77,9 +78,11 @@ void R_SetViewAngleOffset(angle_t angle);
 void R_SetViewOffset(int offset);
 void R_DrawWireframe(dboolean enable);    //villsa
 void R_RegisterCvars(void);
-void R_SetViewMatrix(void);
-void R_RenderWorld(void);
+void R_SetViewMatrix(drawframe_t* frame);
+void R_PrepareWorld(drawframe_t* frame);
+void R_RenderWorld(drawframe_t* frame);
 void R_RenderBSPNode(int bspnum);
 void R_AllocSubsectorBuffer(void);
+int R_GetSegPieces(seg_t *line, rfloat* z, int* piece);
 
 #endif
\ No newline at end of file
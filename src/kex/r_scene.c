@@ -31,6 +31,7 @@
 #include "r_local.h"
 #include "r_sky.h"
 #include "r_drawlist.h"
+#include "r_geom.h"
 
 CVAR_EXTERNAL(i_interpolateframes);
 CVAR_EXTERNAL(r_texturecombiner);
@@ -38,114 +39,36 @@ CVAR_EXTERNAL(r_fog);
 CVAR_EXTERNAL(r_rendersprites);
 CVAR_EXTERNAL(st_flashoverlay);
 
+// frame being drawn by R_RenderWorld
+static drawframe_t* sceneframe = NULL;
+
 //
-// ProcessWalls
+// PrepareWalls
 //
 
-static dboolean ProcessWalls(vtxlist_t* vl, int* drawcount) {
+static int PrepareWalls(vtxlist_t* vl, vtx_t* v) {
     seg_t* seg = (seg_t*)vl->data;
-    sector_t* sec = seg->frontsector;
-
-    bspColor[LIGHT_FLOOR]    = R_GetSectorLight(0xff, sec->colors[LIGHT_FLOOR]);
-    bspColor[LIGHT_CEILING] = R_GetSectorLight(0xff, sec->colors[LIGHT_CEILING]);
-    bspColor[LIGHT_THING]    = R_GetSectorLight(0xff, sec->colors[LIGHT_THING]);
-    bspColor[LIGHT_UPRWALL] = R_GetSectorLight(0xff, sec->colors[LIGHT_UPRWALL]);
-    bspColor[LIGHT_LWRWALL] = R_GetSectorLight(0xff, sec->colors[LIGHT_LWRWALL]);
 
-    if(!vl->callback(seg, &drawVertex[*drawcount])) {
-        return false;
+    if(!vl->callback(seg, v)) {
+        return 0;
     }
 
-    dglTriangle(*drawcount + 0, *drawcount + 1, *drawcount + 2);
-    dglTriangle(*drawcount + 3, *drawcount + 2, *drawcount + 1);
-
-    *drawcount += 4;
-
-    return true;
+    return 4;
 }
 
 //
-// ProcessFlats
+// PrepareFlats
 //
 
-static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
+static int PrepareFlats(vtxlist_t* vl, vtx_t* v) {
     int j;
-    fixed_t tx;
-    fixed_t ty;
-    leaf_t* leaf;
     subsector_t* ss;
-    sector_t* sector;
-    int count;
 
-    ss      = (subsector_t*)vl->data;
-    leaf    = &leafs[ss->leaf];
-    sector  = ss->sector;
-    count   = *drawcount;
+    ss = (subsector_t*)vl->data;
 
-    for(j = 0; j < ss->numleafs - 2; j++) {
-        dglTriangle(count, count + 1 + j, count + 2 + j);
-    }
-
-    // need to keep texture coords small to avoid
-    // floor 'wobble' due to rounding errors on some cards
-    // make relative to first vertex, not (0,0)
-    // which is arbitary anyway
-
-    tx = (leaf->vertex->x >> 6) & ~(FRACUNIT - 1);
-    ty = (leaf->vertex->y >> 6) & ~(FRACUNIT - 1);
-
-    for(j = 0; j < ss->numleafs; j++) {
-        int idx;
-        vtx_t *v = &drawVertex[count];
-
-        if(vl->flags & DLF_CEILING) {
-            leaf = &leafs[(ss->leaf + (ss->numleafs - 1)) - j];
-        }
-        else {
-            leaf = &leafs[ss->leaf + j];
-        }
-
-        v->x = F2D3D(leaf->vertex->x);
-        v->y = F2D3D(leaf->vertex->y);
-
-        if(vl->flags & DLF_CEILING) {
-            if(i_interpolateframes.value) {
-                v->z = F2D3D(sector->frame_z2[1]);
-            }
-            else {
-                v->z = F2D3D(sector->ceilingheight);
-            }
-        }
-        else {
-            if(i_interpolateframes.value) {
-                v->z = F2D3D(sector->frame_z1[1]);
-            }
-            else {
-                v->z = F2D3D(sector->floorheight);
-            }
-        }
-
-        v->tu = F2D3D((leaf->vertex->x >> 6) - tx);
-        v->tv = -F2D3D((leaf->vertex->y >> 6) - ty);
-
-        // set the mapping offsets for scrolling floors/ceilings
-        if((!(vl->flags & DLF_CEILING) && sector->flags & MS_SCROLLFLOOR) ||
-                (vl->flags & DLF_CEILING && sector->flags & MS_SCROLLCEILING)) {
-            v->tu   += F2D3D(sector->xoffset >> 6);
-            v->tv   += F2D3D(sector->yoffset >> 6);
-        }
-
-        v->a = 0xff;
-
-        if(vl->flags & DLF_CEILING) {
-            idx = sector->colors[LIGHT_CEILING];
-        }
-        else {
-            idx = sector->colors[LIGHT_FLOOR];
-        }
-
-        R_LightToVertex(v, idx, 1);
+    R_GetLeafGeometry(ss, (vl->flags & DLF_CEILING) != 0, v);
 
+    for(j = 0; j < ss->numleafs; j++, v++) {
         //
         // water layer 1
         //
@@ -160,35 +83,97 @@ static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
         if(vl->flags & DLF_WATER2) {
             v->tu += F2D3D(scrollfrac >> 6);
         }
-
-        count++;
     }
 
-    *drawcount = count;
-
-    return true;
+    return ss->numleafs;
 }
 
 //
-// ProcessSprites
+// PrepareSprites
 //
 
-static dboolean ProcessSprites(vtxlist_t* vl, int* drawcount) {
+static int PrepareSprites(vtxlist_t* vl, vtx_t* v) {
     visspritelist_t* vis;
-    mobj_t* mobj;
 
     vis = (visspritelist_t*)vl->data;
-    mobj = vis->spr;
 
-    if(!mobj) {
+    if(!vis->spr) {
+        return 0;
+    }
+
+    if(!vl->callback(vis, v)) {
+        return 0;
+    }
+
+    return 4;
+}
+
+//
+// CopyFrameVertices
+// Moves the prepared vertices of an entry into the draw buffer
+//
+
+d_inline static void CopyFrameVertices(vtxlist_t* vl, int drawcount) {
+    dmemcpy(&drawVertex[drawcount], &sceneframe->vertex[vl->vertex],
+            vl->numverts * sizeof(vtx_t));
+}
+
+//
+// ProcessWalls
+//
+
+static dboolean ProcessWalls(vtxlist_t* vl, int* drawcount) {
+    if(!vl->numverts) {
+        return false;
+    }
+
+    CopyFrameVertices(vl, *drawcount);
+
+    dglTriangle(*drawcount + 0, *drawcount + 1, *drawcount + 2);
+    dglTriangle(*drawcount + 3, *drawcount + 2, *drawcount + 1);
+
+    *drawcount += 4;
+
+    return true;
+}
+
+//
+// ProcessFlats
+//
+
+static dboolean ProcessFlats(vtxlist_t* vl, int* drawcount) {
+    int j;
+    int count;
+
+    if(!vl->numverts) {
         return false;
     }
 
-    if(!vl->callback(vis, &drawVertex[*drawcount])) {
+    count = *drawcount;
+
+    for(j = 0; j < vl->numverts - 2; j++) {
+        dglTriangle(count, count + 1 + j, count + 2 + j);
+    }
+
+    CopyFrameVertices(vl, count);
+
+    *drawcount = count + vl->numverts;
+
+    return true;
+}
+
+//
+// ProcessSprites
+//
+
+static dboolean ProcessSprites(vtxlist_t* vl, int* drawcount) {
+    if(!vl->numverts) {
         return false;
     }
 
-    GL_SetState(GLSTATE_CULL, !(mobj->flags & MF_RENDERLASER));
+    CopyFrameVertices(vl, *drawcount);
+
+    GL_SetState(GLSTATE_CULL, !(vl->flags & DLF_NOCULL));
 
     dglTriangle(*drawcount + 0, *drawcount + 1, *drawcount + 2);
     dglTriangle(*drawcount + 3, *drawcount + 2, *drawcount + 1);
@@ -276,22 +261,43 @@ static void SetupFog(void) {
 // R_SetViewMatrix
 //
 
-void R_SetViewMatrix(void) {
+void R_SetViewMatrix(drawframe_t* frame) {
     dglMatrixMode(GL_PROJECTION);
     dglLoadIdentity();
     dglViewFrustum(video_width, video_height, r_fov.value, 0.1f);
     dglMatrixMode(GL_MODELVIEW);
     dglLoadIdentity();
-    dglRotatef(-TRUEANGLES(viewpitch), 1.0f, 0.0f, 0.0f);
-    dglRotatef(-TRUEANGLES(viewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
-    dglTranslatef(-fviewx, -fviewy, -fviewz);
+    dglRotatef(-TRUEANGLES(frame->viewpitch), 1.0f, 0.0f, 0.0f);
+    dglRotatef(-TRUEANGLES(frame->viewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
+    dglTranslatef(-frame->viewx, -frame->viewy, -frame->viewz);
+}
+
+//
+// R_PrepareWorld
+// Sorts the lists filled in by the bsp walk and generates all of
+// their vertices into the frame. Nothing here may touch GL
+//
+
+void R_PrepareWorld(drawframe_t* frame) {
+    frame->numvertex = 0;
+
+    DL_PrepareDrawList(DLT_WALL, frame, PrepareWalls);
+    DL_PrepareDrawList(DLT_FLAT, frame, PrepareFlats);
+
+    if(r_rendersprites.value) {
+        R_SetupSprites();
+    }
+
+    DL_PrepareDrawList(DLT_SPRITE, frame, PrepareSprites);
 }
 
 //
 // R_RenderWorld
 //
 
-void R_RenderWorld(void) {
+void R_RenderWorld(drawframe_t* frame) {
+    sceneframe = frame;
+
     SetupFog();
 
     dglEnable(GL_DEPTH_TEST);
@@ -331,12 +337,12 @@ void R_RenderWorld(void) {
 
     // -------------- Draw walls (segs) --------------------------
 
-    DL_ProcessDrawList(DLT_WALL, ProcessWalls);
+    DL_ProcessFrameList(DLT_WALL, frame, ProcessWalls);
 
     // -------------- Draw floors/ceilings (leafs) ---------------
 
     GL_SetState(GLSTATE_BLEND, 1);
-    DL_ProcessDrawList(DLT_FLAT, ProcessFlats);
+    DL_ProcessFrameList(DLT_FLAT, frame, ProcessFlats);
 
     // -------------- Draw things (sprites) ----------------------
 
@@ -344,12 +350,8 @@ void R_RenderWorld(void) {
         spriteRenderTic = I_GetTimeMS();
     }
 
-    if(r_rendersprites.value) {
-        R_SetupSprites();
-    }
-
     dglDepthMask(GL_FALSE);
-    DL_ProcessDrawList(DLT_SPRITE, ProcessSprites);
+    DL_ProcessFrameList(DLT_SPRITE, frame, ProcessSprites);
 
     // -------------- Restore states -----------------------------
 
@@ -61,6 +61,10 @@ static word CloudOffsetX = 0;
 static float sky_cloudpan1 = 0;
 static float sky_cloudpan2 = 0;
 
+// view of the frame the sky is being drawn for
+static angle_t skyviewangle = 0;
+static angle_t skyviewpitch = 0;
+
 #define FIRESKY_WIDTH   64
 #define FIRESKY_HEIGHT  64
 
@@ -175,8 +179,8 @@ static void R_DrawSkyDome(int tiles, float rows, int height,
     dglMatrixMode(GL_MODELVIEW);
     dglLoadIdentity();
     dglPushMatrix();
-    dglRotatef(-TRUEANGLES(viewpitch), 1.0f, 0.0f, 0.0f);
-    dglRotatef(-TRUEANGLES(viewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
+    dglRotatef(-TRUEANGLES(skyviewpitch), 1.0f, 0.0f, 0.0f);
+    dglRotatef(-TRUEANGLES(skyviewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
 
     //
     // try to center view to the dome
@@ -291,7 +295,7 @@ static void R_DrawSkyboxCloud(void) {
     dglMatrixMode(GL_MODELVIEW);
     dglLoadIdentity();
     dglPushMatrix();
-    dglRotatef(-TRUEANGLES(viewpitch), 1.0f, 0.0f, 0.0f);
+    dglRotatef(-TRUEANGLES(skyviewpitch), 1.0f, 0.0f, 0.0f);
 
     //
     // set vertex pointer
@@ -356,8 +360,8 @@ static void R_DrawSkyboxCloud(void) {
     // setup model matrix for clouds
     //
     dglPushMatrix();
-    dglRotatef(-TRUEANGLES(viewpitch), 1.0f, 0.0f, 0.0f);
-    dglRotatef(-TRUEANGLES(viewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
+    dglRotatef(-TRUEANGLES(skyviewpitch), 1.0f, 0.0f, 0.0f);
+    dglRotatef(-TRUEANGLES(skyviewangle) + 90.0f, 0.0f, 0.0f, 1.0f);
 
     //
     // bind cloud texture and set blending
@@ -455,7 +459,7 @@ static void R_DrawSimpleSky(int lump, int offset) {
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    SKYVIEWPOS(viewangle, 1, pos1);
+    SKYVIEWPOS(skyviewangle, 1, pos1);
 
     width = (float)SCREENWIDTH / (float)gfxwidth[gfxLmp];
     row = (float)lumpheight / (float)height;
@@ -501,7 +505,7 @@ static void R_DrawClouds(void) {
     GL_SetTextureUnit(0, true);
     GL_BindGfxTexture(lumpinfo[skypicnum].name, false);
 
-    pos = (TRUEANGLES(viewangle) / 360.0f) * 2.0f;
+    pos = (TRUEANGLES(skyviewangle) / 360.0f) * 2.0f;
 
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     dglTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -754,7 +758,7 @@ static void R_DrawFire(void) {
     }
 
     if(r_skybox.value <= 0) {
-        SKYVIEWPOS(viewangle, 4, pos1);
+        SKYVIEWPOS(skyviewangle, 4, pos1);
 
         //
         // adjust UV by 0.0035f units due to the fire sky showing a
@@ -776,13 +780,18 @@ static void R_DrawFire(void) {
 
 //
 // R_DrawSky
+// Takes the view from the frame being drawn, which
+// isn't always the one in viewangle and viewpitch
 //
 
-void R_DrawSky(void) {
+void R_DrawSky(angle_t angle, angle_t pitch) {
     if(!sky) {
         return;
     }
 
+    skyviewangle = angle;
+    skyviewpitch = pitch;
+
     if(sky->flags & SKF_VOID) {
         R_DrawVoidSky();
     }
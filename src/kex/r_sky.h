@@ -44,7 +44,7 @@ extern dPalette_t   firePal16[256];
 extern int          fireLump;
 
 void R_SkyTicker(void);
-void R_DrawSky(void);
+void R_DrawSky(angle_t angle, angle_t pitch);
 void R_InitFire(void);
 
 #endif
\ No newline at end of file
@@ -39,11 +39,10 @@
 #include "r_clipper.h"
 #include "m_misc.h"
 #include "con_console.h"
+#include "r_geom.h"
 
 #include <stdlib.h>
 
-#define MAX_SPRITES    1024
-
 spritedef_t     *spriteinfo;
 int             numsprites;
 
@@ -53,6 +52,10 @@ char*           spritename;
 
 static visspritelist_t visspritelist[MAX_SPRITES];
 static visspritelist_t *vissprite = NULL;
+static dboolean spriteoverflow = false;
+
+// sprite lump of the laser bolt
+static int boltsprite = 0;
 
 CVAR_EXTERNAL(m_regionblood);
 CVAR_EXTERNAL(st_flashoverlay);
@@ -244,6 +247,8 @@ void R_InitSprites(char** namelist) {
         states[S_496].sprite = SPR_RBLD + lump;
         states[S_497].sprite = SPR_RBLD + lump;
     }
+
+    boltsprite = W_GetNumForName("BOLTA0") - s_start;
 }
 
 //
@@ -263,8 +268,10 @@ void R_AddSprites(subsector_t *sub) {
             continue;
         }
 
+        // may be running on a worker, so the
+        // warning waits for the next frame
         if(vissprite - visspritelist >= MAX_SPRITES) {
-            CON_Warnf("R_AddSprites: Sprite overflow");
+            spriteoverflow = true;
             return;
         }
 
@@ -278,6 +285,11 @@ void R_AddSprites(subsector_t *sub) {
 //
 
 void R_ClearSprites(void) {
+    if(spriteoverflow) {
+        CON_Warnf("R_AddSprites: Sprite overflow");
+        spriteoverflow = false;
+    }
+
     vissprite = visspritelist;
 }
 
@@ -301,7 +313,7 @@ static void R_AddVisSprite(visspritelist_t* vissprite) {
     }
 
     if(thing->flags & MF_RENDERLASER) {
-        spritenum = W_GetNumForName("BOLTA0") - s_start;
+        spritenum = boltsprite;
     }
     else {
         sprdef = &spriteinfo[thing->sprite];
@@ -389,8 +401,8 @@ static dboolean R_GenerateSpritePlane(visspritelist_t* vissprite, vtx_t* vertex)
         dglSetVertexColor(vertex, D_RGBA(255, 255, 255, thing->alpha), 4);
     }
     else {
-        R_LightToVertex(vertex,
-                        thing->subsector->sector->colors[LIGHT_THING], 4);
+        dglSetVertexColor(vertex,
+                          R_GetSectorGeometry(thing->subsector->sector)->colors[LIGHT_THING], 4);
     }
 
     vertex[0].a = vertex[1].a = vertex[2].a = vertex[3].a = thing->alpha;
@@ -487,7 +499,7 @@ static dboolean R_GenerateLaserPlane(visspritelist_t* vissprite, vtx_t* vertex)
 
     laser = (laser_t*)thing->extradata;
 
-    spritenum = W_GetNumForName("BOLTA0") - s_start;
+    spritenum = boltsprite;
 
     dglSetVertexColor(vertex, D_RGBA(255, 0, 0, thing->alpha), 4);
 
@@ -570,6 +582,15 @@ static void AddSpriteDrawlist(drawlist_t *dl, visspritelist_t *vis, int texid) {
     list->texid =
         (texid | ((mobj->player ? mobj->player->palette : mobj->info->palette) << 24)
          | (list->flags << 16));
+
+    // kept on the entry as the mobj may be gone by the time it's drawn
+    if(mobj->flags & MF_NIGHTMARE) {
+        list->flags |= DLF_NIGHTMARE;
+    }
+
+    if(mobj->flags & MF_RENDERLASER) {
+        list->flags |= DLF_NOCULL;
+    }
 }
 
 //
@@ -594,12 +615,12 @@ void R_SetupSprites(void) {
             // move a bit further towards view
             vis->x = F2D3D(vis->spr->x - FixedMul(FLOATTOFIXED(1.5), dcos(ang)));
             vis->y = F2D3D(vis->spr->y - FixedMul(FLOATTOFIXED(1.5), dsin(ang)));
-            vis->z = F2D3D(R_Interpolate(vis->spr->z, vis->spr->frame_z, interpolate));
+            vis->z = F2D3D(R_Interpolate(vis->spr->z, mobjhot.frame_z[vis->spr->hotindex], interpolate));
         }
         else {  // normal vis sprite process
-            vis->x = F2D3D(R_Interpolate(vis->spr->x, vis->spr->frame_x, interpolate));
-            vis->y = F2D3D(R_Interpolate(vis->spr->y, vis->spr->frame_y, interpolate));
-            vis->z = F2D3D(R_Interpolate(vis->spr->z, vis->spr->frame_z, interpolate));
+            vis->x = F2D3D(R_Interpolate(vis->spr->x, mobjhot.frame_x[vis->spr->hotindex], interpolate));
+            vis->y = F2D3D(R_Interpolate(vis->spr->y, mobjhot.frame_y[vis->spr->hotindex], interpolate));
+            vis->z = F2D3D(R_Interpolate(vis->spr->z, mobjhot.frame_z[vis->spr->hotindex], interpolate));
         }
 
         vis->dist = (int)((vis->x - fviewx) * viewcos[0] +
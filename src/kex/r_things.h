@@ -30,6 +30,8 @@
 #include "d_player.h"
 #include "gl_main.h"
 
+#define MAX_SPRITES    1024
+
 typedef struct {
     mobj_t* spr;
     fixed_t dist;
@@ -68,6 +68,11 @@ void WIPE_FadeScreen(int fadetics) {
     vtx_t v[4];
     float left, right, top, bottom;
 
+    // don't let the wipe eat into the benchmark
+    if(singletics) {
+        return;
+    }
+
     allowmenu = false;
 
     wipeFadeAlpha = 0xff;
@@ -148,6 +153,10 @@ void WIPE_MeltScreen(void) {
     float left, right, top, bottom;
     int i = 0;
 
+    if(singletics) {
+        return;
+    }
+
     M_ClearMenus();
     allowmenu = false;
 
@@ -44,6 +44,7 @@
 #include "p_setup.h"
 #include "i_audio.h"
 #include "con_console.h"
+#include "d_prof.h"
 
 // Adjustable by menu.
 #define NORM_VOLUME     127
@@ -243,6 +244,8 @@ void S_RemoveOrigin(mobj_t* origin) {
     mobj_t* source;
     int     i;
 
+    PROF_BEGIN(PROF_SOUNDS);
+
     channels = I_GetMaxChannels();
 
     for(i = 0; i < channels; i++) {
@@ -293,6 +296,8 @@ void S_UpdateSounds(void) {
             I_UpdateChannel(i, volume, sep);
         }
     }
+
+    PROF_END(PROF_SOUNDS);
 }
 
 //
@@ -947,6 +947,7 @@ void ST_Drawer(void) {
     //
 
     if(st_showstats.value && automapactive) {
+        Draw_BeginText();
         Draw_Text(20, 430, WHITE, 0.5f, false,
                   "Monsters:  %i / %i", plyr->killcount, totalkills);
         Draw_Text(20, 440, WHITE, 0.5f, false,
@@ -955,6 +956,7 @@ void ST_Drawer(void) {
                   "Secrets:   %i / %i", plyr->secretcount, totalsecret);
         Draw_Text(20, 460, WHITE, 0.5f, false,
                   "Time:      %2.2d:%2.2d", (leveltime / TICRATE) / 60, (leveltime / TICRATE) % 60);
+        Draw_EndText();
     }
 }
 
@@ -1169,6 +1171,8 @@ static void ST_DrawChatText(void) {
         current = 0;
     }
 
+    Draw_BeginText();
+
     for(i = 0; i < MAXCHATNODES; i++) {
         if(stchat[current].msg[0] && stchat[current].tics) {
 
@@ -1192,6 +1196,8 @@ static void ST_DrawChatText(void) {
         sprintf(tmp, "%s_", st_chatstring[consoleplayer]);
         Draw_Text(STCHATX, STCHATY + 8, WHITE, 0.5f, false, tmp);
     }
+
+    Draw_EndText();
 }
 
 //
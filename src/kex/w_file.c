@@ -31,6 +31,13 @@
 #include <ctype.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
 #include "doomtype.h"
 #include "i_system.h"
 #include "z_zone.h"
@@ -102,9 +109,98 @@ wad_file_class_t stdc_wad_file = {
     W_StdC_Read,
 };
 
+#ifndef _WIN32
+
+//
+// POSIX memory mapped wad files
+//
+// The whole file is mapped read-only, so lumps can be used in place
+// and the pages are shared with the OS file cache.
+//
+
+wad_file_class_t posix_wad_file;
+
+static wad_file_t *W_POSIX_OpenFile(char *path) {
+    wad_file_t *result;
+    struct stat st;
+    void *mapped;
+    int handle;
+
+    handle = open(path, O_RDONLY);
+
+    if(handle < 0) {
+        return NULL;
+    }
+
+    if(fstat(handle, &st) != 0 || st.st_size <= 0) {
+        close(handle);
+        return NULL;
+    }
+
+    mapped = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, handle, 0);
+
+    // the mapping stays valid after the descriptor is closed
+    close(handle);
+
+    if(mapped == MAP_FAILED) {
+        return NULL;
+    }
+
+    result = Z_Malloc(sizeof(wad_file_t), PU_STATIC, 0);
+    result->file_class = &posix_wad_file;
+    result->mapped = (byte*)mapped;
+    result->length = (unsigned int)st.st_size;
+
+    return result;
+}
+
+static void W_POSIX_CloseFile(wad_file_t *wad) {
+    munmap(wad->mapped, wad->length);
+    Z_Free(wad);
+}
+
+size_t W_POSIX_Read(wad_file_t *wad, unsigned int offset,
+                    void *buffer, size_t buffer_len) {
+    if(offset >= wad->length) {
+        return 0;
+    }
+
+    if(buffer_len > wad->length - offset) {
+        buffer_len = wad->length - offset;
+    }
+
+    memcpy(buffer, wad->mapped + offset, buffer_len);
+
+    return buffer_len;
+}
+
+wad_file_class_t posix_wad_file = {
+    W_POSIX_OpenFile,
+    W_POSIX_CloseFile,
+    W_POSIX_Read,
+};
+
+#endif
+
 static wad_file_class_t *wad_file_classes = &stdc_wad_file;
 
+//
+// W_OpenFile
+// Maps the file if the platform can, otherwise falls back to stdio.
+// -nommap forces the stdio reader.
+//
+
 wad_file_t *W_OpenFile(char *path) {
+#ifndef _WIN32
+    if(!M_CheckParm("-nommap")) {
+        wad_file_t *result = posix_wad_file.OpenFile(path);
+
+        if(result != NULL) {
+            return result;
+        }
+    }
+#endif
+
     return stdc_wad_file.OpenFile(path);
 }
 
@@ -55,6 +55,7 @@
 #include "z_zone.h"
 #include "con_console.h"
 #include "m_misc.h"
+#include "d_prof.h"
 
 #include "Ext/md5.h"
 
@@ -228,6 +229,7 @@ void W_Init(void) {
         lump_p->position = LONG(filerover->filepos);
         lump_p->size = LONG(filerover->size);
         lump_p->cache = NULL;
+        lump_p->views = 0;
         dmemcpy(lump_p->name, filerover->name, 8);
     }
 
@@ -348,6 +350,7 @@ wad_file_t *W_AddFile(char *filename) {
         lump_p->position = LONG(filerover->filepos);
         lump_p->size = LONG(filerover->size);
         lump_p->cache = NULL;
+        lump_p->views = 0;
         dmemcpy(lump_p->name, filerover->name, 8);
 
         ++lump_p;
@@ -366,6 +369,29 @@ static dboolean nonmaplump = false;
 filelump_t *mapLump;
 int numMapLumps;
 byte *mapLumpData = NULL;
+static int mapLumpNum = -1;
+
+//
+// W_MappedLump
+// Returns the lump's data inside its memory mapped
+// wad file, or NULL if the file isn't mapped
+//
+
+static void* W_MappedLump(int lump) {
+    lumpinfo_t *l;
+
+    if(lump < 0 || lump >= numlumps) {
+        I_Error("W_MappedLump: lump %i out of range", lump);
+    }
+
+    l = &lumpinfo[lump];
+
+    if(l->wadfile->mapped == NULL) {
+        return NULL;
+    }
+
+    return l->wadfile->mapped + l->position;
+}
 
 //
 // W_CacheMapLump
@@ -386,7 +412,8 @@ void W_CacheMapLump(int map) {
         return;
     }
     else {
-        mapLumpData = (byte*)W_CacheLumpNum(lump, PU_STATIC);
+        mapLumpNum = lump;
+        mapLumpData = (byte*)W_LumpView(lump);
     }
 
     numMapLumps = ((wadinfo_t*)mapLumpData)->numlumps;
@@ -407,10 +434,11 @@ void W_FreeMapLump(void) {
     nonmaplump = false;
 
     if(mapLumpData) {
-        Z_Free(mapLumpData);
+        W_ReleaseLumpView(mapLumpNum);
     }
 
     mapLumpData = NULL;
+    mapLumpNum = -1;
 }
 
 //
@@ -445,12 +473,17 @@ void* W_GetMapLump(int lump) {
     if(nonmaplump) {
         char name8[9];
         int l;
+        void *data;
 
         sprintf(name8, "MAP%02d", gamemap);
         name8[8] = 0;
 
         l = W_GetNumForName(name8);
 
+        if((data = W_MappedLump(l + lump))) {
+            return data;
+        }
+
         return W_CacheLumpNum(l + lump, PU_MAPLUMP);
     }
 
@@ -526,6 +559,8 @@ void W_ReadLump(int lump, void *dest) {
 
     l = lumpinfo+lump;
 
+    PROF_BEGIN(PROF_READLUMP);
+
     I_BeginRead();
 
     c = W_Read(l->wadfile, l->position, dest, l->size);
@@ -533,6 +568,8 @@ void W_ReadLump(int lump, void *dest) {
     if(c < l->size) {
         I_Error("W_ReadLump: only read %i of %i on lump %i", c, l->size, lump);
     }
+
+    PROF_END(PROF_READLUMP);
 }
 
 //
@@ -567,6 +604,45 @@ void* W_CacheLumpNum(int lump, int tag) {
     return l->cache;
 }
 
+//
+// W_LumpView
+// Read-only access to a lump. Points straight into the wad file
+// when it's memory mapped, otherwise the lump is cached as PU_STATIC.
+// Never write to or Z_Free the result, use W_ReleaseLumpView.
+//
+
+void* W_LumpView(int lump) {
+    void *data;
+
+    if((data = W_MappedLump(lump))) {
+        return data;
+    }
+
+    data = W_CacheLumpNum(lump, PU_STATIC);
+    lumpinfo[lump].views++;
+
+    return data;
+}
+
+//
+// W_ReleaseLumpView
+// The cache is only freed once every view of it is released
+//
+
+void W_ReleaseLumpView(int lump) {
+    lumpinfo_t *l;
+
+    if(W_MappedLump(lump) != NULL) {
+        return;
+    }
+
+    l = &lumpinfo[lump];
+
+    if(l->views > 0 && --l->views == 0 && l->cache) {
+        Z_Free(l->cache);
+    }
+}
+
 //
 // W_CacheLumpName
 //
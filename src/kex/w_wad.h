@@ -46,6 +46,7 @@ typedef struct {
     int         next;
     int         index;
     void*       cache;
+    int         views;      // open W_LumpViews of the cache
 } lumpinfo_t;
 
 extern lumpinfo_t* lumpinfo;
@@ -64,6 +65,8 @@ void            W_FreeMapLump(void);
 int             W_MapLumpLength(int lump);
 void*           W_CacheLumpNum(int lump, int tag);
 void*           W_CacheLumpName(const char* name, int tag);
+void*           W_LumpView(int lump);
+void            W_ReleaseLumpView(int lump);
 
 
 
@@ -36,17 +36,7 @@
 
 #define ZONEID    0x1d4a11
 //#define ZONEFILE
-
-typedef struct memblock_s memblock_t;
-
-struct memblock_s {
-    int id; // = ZONEID
-    int tag;
-    int size;
-    void **user;
-    memblock_t *prev;
-    memblock_t *next;
-};
+#define ZONESLAB
 
 #ifdef ZONEFILE
 
@@ -86,16 +76,145 @@ static void Z_LogPuts(const char *msg) {
 
 #endif
 
+//
+// SLABS AND ARENAS
+//
+// With ZONESLAB defined, small blocks are carved out of large chunks
+// instead of going to the system one by one. Freed small blocks are
+// kept in per size class free lists for reuse.
+//
+// PU_LEVEL and PU_LEVSPEC each get their own arena. Everything they
+// allocate comes out of the arena's chunks and is only handed back to
+// the system when the tag is freed, which then just drops the chunks.
+// Blocks without a user pointer aren't even linked into the tag list,
+// so level teardown doesn't have to visit them.
+//
+// A block that changes tag out of its arena (Z_ChangeTag) 'pins' its
+// chunk, which keeps the chunk alive after the arena is reset until
+// the block is freed.
+//
+
+#define ZSLAB_GRANULARITY   16
+#define ZSLAB_MAXSIZE       1024
+#define ZSLAB_NUMCLASSES    (ZSLAB_MAXSIZE / ZSLAB_GRANULARITY + 1)
+#define ZSLAB_CHUNKSIZE     0x10000
+#define ZARENA_CHUNKSIZE    0x40000
+
+#define ZALIGN(x)           (((x) + (ZSLAB_GRANULARITY - 1)) & ~(ZSLAB_GRANULARITY - 1))
+
+enum {
+    ZK_SYSTEM,  // malloc'd
+    ZK_SLAB,    // from the shared slabs
+    ZK_ARENA    // from a tag arena
+};
+
+#define ZCHUNK_ORPHAN   -1  // arena was reset, chunk only kept for pinned blocks
+#define ZCHUNK_SLAB     -2  // shared slab chunk, never freed
+
+typedef struct zchunk_s zchunk_t;
+
+struct zchunk_s {
+    zchunk_t *next;
+    int tag;    // owning arena tag or ZCHUNK_*
+    int used;
+    int size;
+    int pins;
+};
+
+typedef struct memblock_s memblock_t;
+
+struct memblock_s {
+    int id; // = ZONEID
+    int tag;
+    int size;
+    byte kind;
+    byte sizeclass;
+    byte linked;
+    byte pad;
+    void **user;
+    memblock_t *prev;
+    memblock_t *next;
+    zchunk_t *chunk;
+};
+
+#define ZHEADERSIZE     ZALIGN(sizeof(memblock_t))
+#define ZCHUNKHEADER    ZALIGN(sizeof(zchunk_t))
+
+typedef struct {
+    dboolean    enabled;
+    zchunk_t    *chunks;
+    memblock_t  *freelist[ZSLAB_NUMCLASSES];
+} zarena_t;
+
 // Linked list of allocated blocks for each tag type
 
 static memblock_t *allocated_blocks[PU_MAX];
 
+// Running byte count and high water mark for each tag type
+
+static int tag_usage[PU_MAX];
+static int tag_peak[PU_MAX];
+
+// Total number of blocks allocated, for benchmarking
+
+static int alloc_count;
+
+// Shared slabs for small blocks of every other tag
+
+static zarena_t slabs;
+
+// Per tag arenas
+
+static zarena_t arenas[PU_MAX];
+
+static dboolean Z_ClearCache(int size);
+
+//
+// Z_SystemAlloc
+// Goes to the system, purging the cache if it has to
+//
+
+static void *Z_SystemAlloc(int size) {
+    void *ptr;
+
+    if(!(ptr = malloc(size))) {
+        if(Z_ClearCache(size)) {
+            ptr = malloc(size);
+        }
+    }
+
+    return ptr;
+}
+
+//
+// Z_IsPinned
+//
+
+static d_inline dboolean Z_IsPinned(memblock_t *block) {
+    return block->kind == ZK_ARENA && block->tag != block->chunk->tag;
+}
+
 //
 // Z_InsertBlock
 // Add a block into the linked list for its type.
 //
 
 static void Z_InsertBlock(memblock_t *block) {
+    tag_usage[block->tag] += block->size;
+
+    if(tag_usage[block->tag] > tag_peak[block->tag]) {
+        tag_peak[block->tag] = tag_usage[block->tag];
+    }
+
+    // arena blocks are dropped along with their chunks, so they only need
+    // to be visited if there's a user pointer to clear
+    if(block->kind == ZK_ARENA && !block->user && !Z_IsPinned(block)) {
+        block->linked = false;
+        block->prev = block->next = NULL;
+        return;
+    }
+
+    block->linked = true;
     block->prev = NULL;
     block->next = allocated_blocks[block->tag];
     allocated_blocks[block->tag] = block;
@@ -111,6 +230,12 @@ static void Z_InsertBlock(memblock_t *block) {
 //
 
 static void Z_RemoveBlock(memblock_t *block) {
+    tag_usage[block->tag] -= block->size;
+
+    if(!block->linked) {
+        return;
+    }
+
     // Unlink from list
     if(block->prev == NULL) {
         allocated_blocks[block->tag] = block->next;    // Start of list
@@ -122,6 +247,156 @@ static void Z_RemoveBlock(memblock_t *block) {
     if(block->next != NULL) {
         block->next->prev = block->prev;
     }
+
+    block->linked = false;
+}
+
+//
+// Z_ChunkAlloc
+// Bumps a block out of the arena's current chunk
+//
+
+static memblock_t *Z_ChunkAlloc(zarena_t *arena, int tag, int size) {
+    zchunk_t *chunk = arena->chunks;
+    memblock_t *block;
+
+    if(!chunk || chunk->used + size > chunk->size) {
+        int chunksize = (tag == ZCHUNK_SLAB ? ZSLAB_CHUNKSIZE : ZARENA_CHUNKSIZE);
+
+        if(!(chunk = (zchunk_t*)Z_SystemAlloc(ZCHUNKHEADER + chunksize))) {
+            return NULL;
+        }
+
+        chunk->tag = tag;
+        chunk->used = 0;
+        chunk->size = chunksize;
+        chunk->pins = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    block = (memblock_t*)((byte*)chunk + ZCHUNKHEADER + chunk->used);
+    block->chunk = chunk;
+    chunk->used += size;
+
+    return block;
+}
+
+//
+// Z_AllocBlock
+// Picks where a new block is going to live
+//
+
+static memblock_t *Z_AllocBlock(int size, int tag) {
+    memblock_t *block;
+
+#ifdef ZONESLAB
+    zarena_t *arena = arenas[tag].enabled ? &arenas[tag] : &slabs;
+    int chunktag = arenas[tag].enabled ? tag : ZCHUNK_SLAB;
+    int kind = arenas[tag].enabled ? ZK_ARENA : ZK_SLAB;
+
+    if(size <= ZSLAB_MAXSIZE) {
+        int sizeclass = ZALIGN(MAX(size, 1)) / ZSLAB_GRANULARITY;
+
+        if((block = arena->freelist[sizeclass])) {
+            arena->freelist[sizeclass] = block->next;
+        }
+        else if(!(block = Z_ChunkAlloc(arena, chunktag,
+                                       ZHEADERSIZE + sizeclass * ZSLAB_GRANULARITY))) {
+            return NULL;
+        }
+
+        block->kind = kind;
+        block->sizeclass = sizeclass;
+        return block;
+    }
+
+    // big level data (map lumps, sectors, lines...) is bumped into
+    // the arena, but never take more than a chunk's quarter
+    if(kind == ZK_ARENA && ZHEADERSIZE + ZALIGN(size) <= ZARENA_CHUNKSIZE / 4) {
+        if(!(block = Z_ChunkAlloc(arena, chunktag, ZHEADERSIZE + ZALIGN(size)))) {
+            return NULL;
+        }
+
+        block->kind = ZK_ARENA;
+        block->sizeclass = 0;
+        return block;
+    }
+#endif
+
+    if(!(block = (memblock_t*)Z_SystemAlloc(ZHEADERSIZE + size))) {
+        return NULL;
+    }
+
+    block->kind = ZK_SYSTEM;
+    block->sizeclass = 0;
+    block->chunk = NULL;
+
+    return block;
+}
+
+//
+// Z_ReleaseBlock
+// Gives the memory of an unlinked block back
+//
+
+static void Z_ReleaseBlock(memblock_t *block) {
+    zchunk_t *chunk = block->chunk;
+
+    // make sure the block can't be freed twice
+    block->id = 0;
+
+    switch(block->kind) {
+    case ZK_SYSTEM:
+        free(block);
+        break;
+
+    case ZK_SLAB:
+        block->next = slabs.freelist[block->sizeclass];
+        slabs.freelist[block->sizeclass] = block;
+        break;
+
+    case ZK_ARENA:
+        if(block->tag != chunk->tag) {
+            // pinned; orphaned chunks go away with their last block
+            if(--chunk->pins == 0 && chunk->tag == ZCHUNK_ORPHAN) {
+                free(chunk);
+            }
+        }
+        else if(block->sizeclass) {
+            block->next = arenas[chunk->tag].freelist[block->sizeclass];
+            arenas[chunk->tag].freelist[block->sizeclass] = block;
+        }
+
+        // big arena blocks stay put until the arena is reset
+        break;
+    }
+}
+
+//
+// Z_ResetArena
+// Drops every chunk of a tag arena at once
+//
+
+static void Z_ResetArena(int tag) {
+    zarena_t *arena = &arenas[tag];
+    zchunk_t *chunk;
+    zchunk_t *next;
+
+    for(chunk = arena->chunks; chunk != NULL; chunk = next) {
+        next = chunk->next;
+
+        if(chunk->pins) {
+            chunk->tag = ZCHUNK_ORPHAN;
+            chunk->next = NULL;
+        }
+        else {
+            free(chunk);
+        }
+    }
+
+    arena->chunks = NULL;
+    dmemset(arena->freelist, 0, sizeof(arena->freelist));
 }
 
 //
@@ -130,6 +405,15 @@ static void Z_RemoveBlock(memblock_t *block) {
 
 void Z_Init(void) {
     dmemset(allocated_blocks, 0, sizeof(allocated_blocks));
+    dmemset(tag_usage, 0, sizeof(tag_usage));
+    dmemset(tag_peak, 0, sizeof(tag_peak));
+    dmemset(&slabs, 0, sizeof(slabs));
+    dmemset(arenas, 0, sizeof(arenas));
+
+#ifdef ZONESLAB
+    arenas[PU_LEVEL].enabled = true;
+    arenas[PU_LEVSPEC].enabled = true;
+#endif
 
 #ifdef ZONEFILE
     atexit(Z_CloseLogFile); // exit handler
@@ -147,7 +431,7 @@ void Z_Init(void) {
 void (Z_Free)(void* ptr, const char *file, int line) {
     memblock_t* block;
 
-    block = (memblock_t *)((byte *)ptr - sizeof(memblock_t));
+    block = (memblock_t *)((byte *)ptr - ZHEADERSIZE);
 
     if(block->id != ZONEID) {
         I_Error("Z_Free: freed a pointer without ZONEID (%s:%d)", file, line);
@@ -161,7 +445,7 @@ void (Z_Free)(void* ptr, const char *file, int line) {
     Z_RemoveBlock(block);
 
     // Free back to system
-    free(block);
+    Z_ReleaseBlock(block);
 
 #ifdef ZONEFILE
     Z_LogPrintf("* Z_Free(ptr=%p, file=%s:%d)\n", ptr, file, line);
@@ -220,7 +504,7 @@ static dboolean Z_ClearCache(int size) {
             *block->user = NULL;
         }
 
-        free(block);
+        Z_ReleaseBlock(block);
 
         block = next_block;
     }
@@ -248,15 +532,7 @@ void *(Z_Malloc)(int size, int tag, void *user, const char *file, int line) {
 
     // Malloc a block of the required size
 
-    newblock = NULL;
-
-    if(!(newblock = (memblock_t*)malloc(sizeof(memblock_t) + size))) {
-        if(Z_ClearCache(sizeof(memblock_t) + size)) {
-            newblock = (memblock_t*)malloc(sizeof(memblock_t) + size);
-        }
-    }
-
-    if(!newblock) {
+    if(!(newblock = Z_AllocBlock(size, tag))) {
         I_Error("Z_Malloc: failed on allocation of %u bytes (%s:%d)", size, file, line);
     }
 
@@ -268,9 +544,10 @@ void *(Z_Malloc)(int size, int tag, void *user, const char *file, int line) {
     newblock->size = size;
 
     Z_InsertBlock(newblock);
+    alloc_count++;
 
     data = (unsigned char*)newblock;
-    result = data + sizeof(memblock_t);
+    result = data + ZHEADERSIZE;
 
     if(user != NULL) {
         *newblock->user = result;
@@ -311,7 +588,7 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
         I_Error("Z_Realloc: an owner is required for purgable blocks (%s:%d)", file, line);
     }
 
-    block = (memblock_t*)((byte *)ptr - sizeof(memblock_t));
+    block = (memblock_t*)((byte *)ptr - ZHEADERSIZE);
 
     newblock = NULL;
 
@@ -319,6 +596,26 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
         I_Error("Z_Realloc: Reallocated a pointer without ZONEID (%s:%d)", file, line);
     }
 
+    //
+    // slab and arena blocks can't be resized in place,
+    // so copy them into a new block
+    //
+    if(block->kind != ZK_SYSTEM) {
+        Z_RemoveBlock(block);
+
+        if(block->user) {
+            *block->user = NULL;
+        }
+
+        block->user = NULL;
+
+        result = (Z_Malloc)(size, tag, user, file, line);
+        dmemcpy(result, ptr, MIN(block->size, size));
+
+        Z_ReleaseBlock(block);
+        return result;
+    }
+
     Z_RemoveBlock(block);
 
     block->next = NULL;
@@ -328,9 +625,9 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
         *block->user = NULL;
     }
 
-    if(!(newblock = (memblock_t*)realloc(block, sizeof(memblock_t) + size))) {
-        if(Z_ClearCache(sizeof(memblock_t) + size)) {
-            newblock = (memblock_t*)realloc(block, sizeof(memblock_t) + size);
+    if(!(newblock = (memblock_t*)realloc(block, ZHEADERSIZE + size))) {
+        if(Z_ClearCache(ZHEADERSIZE + size)) {
+            newblock = (memblock_t*)realloc(block, ZHEADERSIZE + size);
         }
     }
 
@@ -344,9 +641,10 @@ void *(Z_Realloc)(void *ptr, int size, int tag, void *user, const char *file, in
     newblock->size = size;
 
     Z_InsertBlock(newblock);
+    alloc_count++;
 
     data = (unsigned char*)newblock;
-    result = data + sizeof(memblock_t);
+    result = data + ZHEADERSIZE;
 
     if(user != NULL) {
         *newblock->user = result;
@@ -386,7 +684,7 @@ void (Z_FreeTags)(int lowtag, int hightag, const char *file, int line) {
                 *block->user = NULL;
             }
 
-            free(block);
+            Z_ReleaseBlock(block);
 
             // Jump to the next in the chain
 
@@ -395,6 +693,12 @@ void (Z_FreeTags)(int lowtag, int hightag, const char *file, int line) {
 
         // This chain is empty now
         allocated_blocks[i] = NULL;
+        tag_usage[i] = 0;
+
+        // anything left in the arena goes with it
+        if(arenas[i].enabled) {
+            Z_ResetArena(i);
+        }
     }
 
 #ifdef ZONEFILE
@@ -445,7 +749,7 @@ char *(Z_Strdupa)(const char *s, const char *file, int line) {
 void (Z_Touch)(void *ptr, const char *file, int line) {
     memblock_t *block;
 
-    block = (memblock_t*)((byte*)ptr - sizeof(memblock_t));
+    block = (memblock_t*)((byte*)ptr - ZHEADERSIZE);
 
     if(block->id != ZONEID) {
         I_Error("Z_Touch: touched a pointer without ZONEID (%s:%d)", file, line);
@@ -518,7 +822,7 @@ void (Z_CheckHeap)(const char *file, int line) {
 int (Z_CheckTag)(void *ptr, const char *file, int line) {
     memblock_t*    block;
 
-    block = (memblock_t*)((byte *)ptr - sizeof(memblock_t));
+    block = (memblock_t*)((byte *)ptr - ZHEADERSIZE);
 
     (Z_CheckHeap)(file, line);
 
@@ -536,7 +840,7 @@ int (Z_CheckTag)(void *ptr, const char *file, int line) {
 void (Z_ChangeTag)(void *ptr, int tag, const char *file, int line) {
     memblock_t*    block;
 
-    block = (memblock_t*)((byte *)ptr - sizeof(memblock_t));
+    block = (memblock_t*)((byte *)ptr - ZHEADERSIZE);
 
     if(block->id != ZONEID)
         I_Error("Z_ChangeTag: block without a ZONEID! (%s:%d)",
@@ -551,6 +855,21 @@ void (Z_ChangeTag)(void *ptr, int tag, const char *file, int line) {
     // its new list.
     //
     Z_RemoveBlock(block);
+
+    // blocks leaving their arena keep its chunk alive
+    if(block->kind == ZK_ARENA) {
+        dboolean pinned = Z_IsPinned(block);
+
+        block->tag = tag;
+
+        if(!pinned && Z_IsPinned(block)) {
+            block->chunk->pins++;
+        }
+        else if(pinned && !Z_IsPinned(block)) {
+            block->chunk->pins--;
+        }
+    }
+
     block->tag = tag;
     Z_InsertBlock(block);
 
@@ -565,18 +884,43 @@ void (Z_ChangeTag)(void *ptr, int tag, const char *file, int line) {
 //
 
 int Z_TagUsage(int tag) {
-    int bytes = 0;
-    memblock_t *block;
-
     if(tag < 0 || tag >= PU_MAX) {
         I_Error("Z_TagUsage: tag out of range: %i", tag);
     }
 
-    for(block = allocated_blocks[tag]; block != NULL; block = block->next) {
-        bytes += block->size;
+    return tag_usage[tag];
+}
+
+//
+// Z_TagPeakUsage
+// Highest number of bytes held by a tag since
+// startup or the last Z_ResetTagPeaks
+//
+
+int Z_TagPeakUsage(int tag) {
+    if(tag < 0 || tag >= PU_MAX) {
+        I_Error("Z_TagPeakUsage: tag out of range: %i", tag);
     }
 
-    return bytes;
+    return tag_peak[tag];
+}
+
+//
+// Z_ResetTagPeaks
+// Starts the peaks over from what each tag holds now
+//
+
+void Z_ResetTagPeaks(void) {
+    dmemcpy(tag_peak, tag_usage, sizeof(tag_peak));
+}
+
+//
+// Z_AllocCount
+// Number of blocks handed out by Z_Malloc and Z_Realloc so far
+//
+
+int Z_AllocCount(void) {
+    return alloc_count;
 }
 
 //
@@ -586,12 +930,9 @@ int Z_TagUsage(int tag) {
 int Z_FreeMemory(void) {
     int bytes = 0;
     int i;
-    memblock_t *block;
 
     for(i = 0; i < PU_MAX; i++) {
-        for(block = allocated_blocks[i]; block != NULL; block = block->next) {
-            bytes += block->size;
-        }
+        bytes += tag_usage[i];
     }
 
     return bytes;
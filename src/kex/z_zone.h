@@ -92,6 +92,9 @@ void (Z_Touch)(void *ptr, const char *, int);
 #define strdup(s)           (Z_Strdup) (s, PU_STATIC,0,__FILE__,__LINE__)
 
 int Z_TagUsage(int tag);
+int Z_TagPeakUsage(int tag);
+void Z_ResetTagPeaks(void);
+int Z_AllocCount(void);
 int Z_FreeMemory(void);
 
 #endif